@@ -0,0 +1,221 @@
+/*--------------------------------------------------------------------*/
+/* arena.c                                                            */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "arena.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The usual length of a block, and the longest block that an Arena
+   keeps across a reset. */
+
+static const size_t BLOCK_LENGTH = 65536;
+static const size_t MAX_KEPT_LENGTH = 1048576;
+
+/* The alignment of each allocation; it is at least that of any
+   object. */
+
+enum {ALIGNMENT = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* A Block is a header followed by the memory that it hands out. */
+
+struct Block
+{
+   /* The next older Block of the Arena. */
+   struct Block *psNext;
+
+   /* The number of bytes that follow the header. */
+   size_t uLength;
+};
+
+/* The length of the header of a Block, rounded up so that the memory
+   after it is aligned. */
+
+static const size_t HEADER_LENGTH =
+   (sizeof(struct Block) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+/*--------------------------------------------------------------------*/
+
+/* An Arena is a list of Blocks, newest first, along with the number
+   of bytes used in the newest one. */
+
+struct Arena
+{
+   /* The Blocks of the Arena, newest first. */
+   struct Block *psBlocks;
+
+   /* The number of bytes handed out from the newest Block. */
+   size_t uUsed;
+
+   /* The length to give the next new Block at least. */
+   size_t uNextLength;
+
+   /* The number of allocations handed out, and the number of those
+      that called malloc(). */
+   size_t uAllocs;
+   size_t uHeapAllocs;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty Arena object, or NULL if insufficient memory is
+   available. */
+
+Arena_T Arena_new(void)
+{
+   Arena_T oArena;
+
+   oArena = (struct Arena*)malloc(sizeof(struct Arena));
+   if (oArena == NULL)
+      return NULL;
+
+   oArena->psBlocks = NULL;
+   oArena->uUsed = 0;
+   oArena->uNextLength = BLOCK_LENGTH;
+   oArena->uAllocs = 0;
+   oArena->uHeapAllocs = 0;
+   return oArena;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the list of Blocks that starts at psBlock. */
+
+static void Arena_freeBlocks(struct Block *psBlock)
+{
+   struct Block *psNext;
+
+   while (psBlock != NULL)
+   {
+      psNext = psBlock->psNext;
+      free(psBlock);
+      psBlock = psNext;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oArena and all of the memory that it has handed out. */
+
+void Arena_free(Arena_T oArena)
+{
+   if (oArena == NULL)
+      return;
+
+   Arena_freeBlocks(oArena->psBlocks);
+   free(oArena);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return uSize bytes of memory from oArena, suitably aligned for any
+   object. The memory lasts until the next reset of oArena. */
+
+void *Arena_alloc(Arena_T oArena, size_t uSize)
+{
+   struct Block *psBlock;
+   void *pvMemory;
+
+   assert(oArena != NULL);
+
+   uSize = (uSize + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+   oArena->uAllocs++;
+
+   /* Start a new Block if the newest one is full. */
+   psBlock = oArena->psBlocks;
+   if ((psBlock == NULL) || (psBlock->uLength - oArena->uUsed < uSize))
+   {
+      if (oArena->uNextLength < uSize)
+         oArena->uNextLength = uSize;
+      psBlock = (struct Block*)
+         malloc(HEADER_LENGTH + oArena->uNextLength);
+      if (psBlock == NULL)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      oArena->uHeapAllocs++;
+
+      psBlock->uLength = oArena->uNextLength;
+      psBlock->psNext = oArena->psBlocks;
+      oArena->psBlocks = psBlock;
+      oArena->uUsed = 0;
+   }
+
+   pvMemory = (char*)psBlock + HEADER_LENGTH + oArena->uUsed;
+   oArena->uUsed += uSize;
+   return pvMemory;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of string pcString in memory from oArena. */
+
+char *Arena_strdup(Arena_T oArena, const char *pcString)
+{
+   size_t uLength;
+   char *pcCopy;
+
+   assert(oArena != NULL);
+   assert(pcString != NULL);
+
+   uLength = strlen(pcString) + 1;
+   pcCopy = (char*)Arena_alloc(oArena, uLength);
+   memcpy(pcCopy, pcString, uLength);
+   return pcCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Reclaim all of the memory that oArena has handed out. oArena keeps
+   its memory for reuse, so that an arena reset once per line does
+   not call malloc() again once it has grown large enough. */
+
+void Arena_reset(Arena_T oArena)
+{
+   struct Block *psBlock;
+   size_t uTotalLength = 0;
+
+   assert(oArena != NULL);
+
+   oArena->uUsed = 0;
+   psBlock = oArena->psBlocks;
+   if (psBlock == NULL)
+      return;
+
+   /* A single Block of usual size is simply reused. */
+   if ((psBlock->psNext == NULL) &&
+       (psBlock->uLength <= MAX_KEPT_LENGTH))
+      return;
+
+   /* Otherwise replace the Blocks by one that would have held all of
+      them, unless that is too long to keep around. */
+   for (; psBlock != NULL; psBlock = psBlock->psNext)
+      uTotalLength += psBlock->uLength;
+   Arena_freeBlocks(oArena->psBlocks);
+   oArena->psBlocks = NULL;
+   if (uTotalLength > MAX_KEPT_LENGTH)
+      oArena->uNextLength = BLOCK_LENGTH;
+   else
+      oArena->uNextLength = uTotalLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of allocations that oArena has handed out, and
+   store in *puHeapAllocs the number of those that needed a call to
+   malloc(). */
+
+size_t Arena_getAllocCount(Arena_T oArena, size_t *puHeapAllocs)
+{
+   assert(oArena != NULL);
+   assert(puHeapAllocs != NULL);
+
+   *puHeapAllocs = oArena->uHeapAllocs;
+   return oArena->uAllocs;
+}
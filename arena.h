@@ -0,0 +1,60 @@
+/*--------------------------------------------------------------------*/
+/* arena.h                                                            */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+
+/* An Arena object hands out memory from large blocks by bumping a
+   pointer, and reclaims all of that memory at once. */
+
+typedef struct Arena *Arena_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty Arena object, or NULL if insufficient memory is
+   available. */
+
+Arena_T Arena_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oArena and all of the memory that it has handed out. */
+
+void Arena_free(Arena_T oArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Return uSize bytes of memory from oArena, suitably aligned for any
+   object. The memory lasts until the next reset of oArena. */
+
+void *Arena_alloc(Arena_T oArena, size_t uSize);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of string pcString in memory from oArena. */
+
+char *Arena_strdup(Arena_T oArena, const char *pcString);
+
+/*--------------------------------------------------------------------*/
+
+/* Reclaim all of the memory that oArena has handed out. oArena keeps
+   its memory for reuse, so that an arena reset once per line does
+   not call malloc() again once it has grown large enough. */
+
+void Arena_reset(Arena_T oArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of allocations that oArena has handed out, and
+   store in *puHeapAllocs the number of those that needed a call to
+   malloc(). */
+
+size_t Arena_getAllocCount(Arena_T oArena, size_t *puHeapAllocs);
+
+#endif
@@ -0,0 +1,82 @@
+#!/bin/sh
+#----------------------------------------------------------------------
+# bench/copy.sh
+# Author: Isaac Wolfe
+#----------------------------------------------------------------------
+
+# Measure the file staging of our scripts: lines of cat with
+# redirections, cp and rm. First time a script of many such lines on
+# small files, where starting a program is the cost; then one line of
+# each on a large file, where copying is. Each runs through the ish
+# of this tree, where cat, cp and rm are builtins that copy within
+# the kernel with copy_file_range(), and through the same ish with
+# each command named by its path, so that the external program runs.
+#
+# Usage: bench/copy.sh [lines [megabytes]]
+
+set -e
+cd "$(dirname "$0")/.."
+
+LINES=${1:-5000}
+MB=${2:-512}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+$CC $CFLAGS -o "$TMP/ish" ish.c command.c pipeline.c commandlist.c \
+   pathcache.c hashtable.c builtintable.c vartable.c dircache.c \
+   jobtable.c scheduler.c remote.c synAnalyze.c dynarray.c arena.c \
+   token.c linereader.c lexdfa.c lexscan.c -ldl
+
+# Each group of five lines copies a small file three ways and then
+# removes the copies.
+awk -v n="$LINES" -v dir="$TMP" 'BEGIN {
+   for (i = 0; i < n; i += 5) {
+      print "cat < " dir "/small > " dir "/a";
+      print "cat " dir "/small " dir "/a > " dir "/b";
+      print "cp " dir "/b " dir "/c";
+      print "cat " dir "/c > /dev/null";
+      print "rm " dir "/a " dir "/b " dir "/c";
+   }
+}' > "$TMP/small.builtin"
+sed -e 's|/small|/large|g' "$TMP/small.builtin" | head -n 5 \
+   > "$TMP/large.builtin"
+for SIZE in small large; do
+   sed -e 's|^cat|/bin/cat|' -e 's|^cp|/bin/cp|' -e 's|^rm|/bin/rm|' \
+      < "$TMP/$SIZE.builtin" > "$TMP/$SIZE.external"
+done
+
+head -c 4096 /dev/urandom > "$TMP/small"
+head -c $((MB * 1024 * 1024)) /dev/zero > "$TMP/large"
+
+# Time the script $2 through ish; $3 is the number of bytes that it
+# copies, or 0 to report lines per second instead. Each run starts
+# with no dirty pages left by the one before.
+run()
+{
+   printf '%-20s' "$1"
+   INPUT=$2
+   BYTES=$3
+   sync
+   START=$(date +%s.%N)
+   "$TMP/ish" -q < "$INPUT" > /dev/null
+   echo "$START $(date +%s.%N) $(wc -l < "$INPUT") $BYTES" |
+      awk '{
+         if ($4 == 0) printf "%10.0f lines/s\n", $3 / ($2 - $1);
+         else printf "%10.0f MB/s\n", $4 / 1048576 / ($2 - $1);
+      }'
+}
+
+echo "$LINES lines on a 4 KB file"
+run builtin "$TMP/small.builtin" 0
+run external "$TMP/small.external" 0
+
+# The lines on the large file move five times its size: the first
+# three copy it once, twice and once, and the fourth reads it. Disk
+# writeback makes single runs vary, so the two alternate.
+echo "5 lines on a $MB MB file"
+for ROUND in 1 2 3; do
+   run builtin "$TMP/large.builtin" $((5 * MB * 1024 * 1024))
+   run external "$TMP/large.external" $((5 * MB * 1024 * 1024))
+done
@@ -0,0 +1,74 @@
+#!/bin/sh
+#----------------------------------------------------------------------
+# bench/echo.sh
+# Author: Isaac Wolfe
+#----------------------------------------------------------------------
+
+# Measure how many lines per second ish runs of a script made mostly
+# of echo, pwd, printenv, printf, true and false, some of them
+# redirected, as our scripts are. The script runs through the ish of
+# this tree, where those commands are builtins; through the same ish
+# with each command named by its path, so that it runs as an external
+# program; and through the ish of an earlier revision.
+#
+# Usage: bench/echo.sh [lines [revision]]
+# The revision defaults to the one before echo became a builtin.
+
+set -e
+cd "$(dirname "$0")/.."
+
+LINES=${1:-20000}
+REV=${2:-$(git log --format=%H --reverse -S executeEcho -- ish.c |
+   head -n 1)^}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# Every sixth line sends its output to /dev/null, and the last one of
+# each ten sends it to a file.
+awk -v n="$LINES" -v dir="$TMP" 'BEGIN {
+   for (i = 0; i < n; i++) {
+      r = i % 10;
+      if (r < 4) line = "echo line " i " of the script";
+      else if (r < 5) line = "pwd";
+      else if (r < 6) line = "printenv HOME";
+      else if (r < 7) line = "printf %s-%d\\n word " i;
+      else if (r < 8) line = "true";
+      else if (r < 9) line = "false";
+      else line = "echo saved " i " > " dir "/saved";
+      if ((r < 9) && (i % 6 == 5)) line = line " > /dev/null";
+      print line;
+   }
+}' > "$TMP/builtin"
+sed -e 's|^echo|/bin/echo|' -e 's|^pwd|/bin/pwd|' \
+   -e 's|^printenv|/usr/bin/printenv|' -e 's|^printf|/usr/bin/printf|' \
+   -e 's|^true|/bin/true|' -e 's|^false|/bin/false|' \
+   < "$TMP/builtin" > "$TMP/external"
+
+$CC $CFLAGS -o "$TMP/ish" ish.c command.c pipeline.c commandlist.c \
+   pathcache.c hashtable.c builtintable.c vartable.c dircache.c \
+   jobtable.c scheduler.c remote.c synAnalyze.c dynarray.c arena.c \
+   token.c linereader.c lexdfa.c lexscan.c -ldl
+mkdir "$TMP/old"
+git archive "$REV" | tar -x -C "$TMP/old"
+(cd "$TMP/old" && $CC $CFLAGS -o ish $(ls *.c |
+   grep -v -e '^ishlex' -e '^ishsyn' -e '^ishclient' -e '^dfa' \
+      -e '^lexfuzz') -ldl)
+
+run()
+{
+   printf '%-20s' "$1"
+   INPUT=$2
+   shift 2
+   START=$(date +%s.%N)
+   "$@" -q < "$INPUT" > /dev/null
+   echo "$START $(date +%s.%N) $LINES" |
+      awk '{printf "%10.0f lines/s\n", $3 / ($2 - $1)}'
+}
+
+echo "$LINES lines"
+run builtin "$TMP/builtin" "$TMP/ish"
+run external "$TMP/external" "$TMP/ish"
+run "ish@$(git rev-parse --short "$REV")" "$TMP/builtin" \
+   "$TMP/old/ish"
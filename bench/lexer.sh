@@ -0,0 +1,66 @@
+#!/bin/sh
+#----------------------------------------------------------------------
+# bench/lexer.sh
+# Author: Isaac Wolfe
+#----------------------------------------------------------------------
+
+# Time the lexer driver ishlex over a generated corpus of command
+# lines, against the ishlex of an earlier revision and the standalone
+# lexer in dfa.c. All three write their tokens to /dev/null. dfa.c
+# rejects a line where a word runs into a number, so it reads a copy
+# of the corpus with all but letters turned into spaces.
+#
+# Usage: bench/lexer.sh [lines [revision]]
+# The revision defaults to the first commit, whose lexer is the
+# hand-written switch.
+
+set -e
+cd "$(dirname "$0")/.."
+
+LINES=${1:-200000}
+REV=${2:-$(git rev-list --max-parents=0 HEAD)}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# Lines of words, quoted literals and redirections, as in scripts.
+awk -v n="$LINES" 'BEGIN {
+   srand(1);
+   for (i = 0; i < n; i++) {
+      line = "cmd" i % 17;
+      for (j = int(rand() * 8); j >= 0; j--) {
+         r = rand();
+         if (r < 0.6) line = line " /usr/src/project/file" int(rand() * 1000) ".c";
+         else if (r < 0.8) line = line " \"quoted words " j "\"";
+         else if (r < 0.9) line = line " < in" j;
+         else line = line " > out" j;
+      }
+      print line;
+   }
+}' > "$TMP/corpus"
+tr -c 'a-zA-Z\n' ' ' < "$TMP/corpus" > "$TMP/words"
+
+$CC $CFLAGS -o "$TMP/ishlex" ishlex.c dynarray.c arena.c token.c \
+   linereader.c lexdfa.c lexscan.c
+$CC $CFLAGS -o "$TMP/dfa" dfa.c dynarray.c
+mkdir "$TMP/old"
+git archive "$REV" | tar -x -C "$TMP/old"
+(cd "$TMP/old" && $CC $CFLAGS -o ishlex ishlex.c dynarray.c token.c \
+   linereader.c lexdfa.c)
+
+run()
+{
+   printf '%-16s' "$1"
+   INPUT=$2
+   shift 2
+   START=$(date +%s.%N)
+   "$@" < "$INPUT" > /dev/null
+   echo "$START $(date +%s.%N)" | awk '{printf "%.2f s\n", $2 - $1}'
+}
+
+echo "$LINES lines, $(wc -c < "$TMP/corpus") bytes"
+run ishlex "$TMP/corpus" "$TMP/ishlex" -q
+run "ishlex@$(git rev-parse --short "$REV")" "$TMP/corpus" \
+   "$TMP/old/ishlex"
+run dfa "$TMP/words" "$TMP/dfa"
@@ -0,0 +1,44 @@
+#!/bin/sh
+#----------------------------------------------------------------------
+# bench/parse.sh
+# Author: Isaac Wolfe
+#----------------------------------------------------------------------
+
+# Compare the two ways of lexing and parsing a line on long lines:
+# building a TokenList and then walking it (LexDFA_lexLine and
+# SynAnalyze_analyze), and pushing each token into the parser as it
+# is found (LexDFA_pushLine and SynAnalyze_addToken).
+#
+# Usage: bench/parse.sh [lines [arguments [rounds]]]
+
+set -e
+cd "$(dirname "$0")/.."
+
+LINES=${1:-2000}
+ARGS=${2:-1000}
+ROUNDS=${3:-10}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# Commands with many long path arguments, some quoted, with their
+# redirections at the end.
+awk -v n="$LINES" -v args="$ARGS" 'BEGIN {
+   srand(1);
+   for (i = 0; i < n; i++) {
+      line = "cmd" i % 17;
+      for (j = 0; j < args; j++) {
+         if (rand() < 0.9)
+            line = line " /usr/src/project/dir" j % 7 "/file" j ".c";
+         else
+            line = line " \"quoted words " j "\"";
+      }
+      print line " < in" i " > out" i;
+   }
+}' > "$TMP/corpus"
+
+$CC $CFLAGS -I. -o "$TMP/parsebench" bench/parsebench.c dynarray.c \
+   arena.c token.c linereader.c lexdfa.c lexscan.c synAnalyze.c \
+   command.c pipeline.c commandlist.c
+"$TMP/parsebench" "$ROUNDS" < "$TMP/corpus"
@@ -0,0 +1,176 @@
+/*--------------------------------------------------------------------*/
+/* parsebench.c                                                       */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "arena.h"
+#include "token.h"
+#include "linereader.h"
+#include "lexdfa.h"
+#include "commandlist.h"
+#include "synAnalyze.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The name of the executable binary file. */
+const char *pcPgmName;
+
+/*--------------------------------------------------------------------*/
+
+/* Return the time in seconds on a monotonic clock. */
+
+static double getSeconds(void)
+{
+	struct timespec sNow;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &sNow) == -1)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+	return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lex and parse each of the uLines lines at ppcLines by building a
+   TokenList and walking it, as ishsyn does, with memory from oArena.
+   Return the number of command lists built. */
+
+static size_t parseByList(Arena_T oArena, char **ppcLines,
+	size_t uLines)
+{
+	TokenList_T oTokens;
+	size_t u;
+	size_t uBuilt = 0;
+
+	for (u = 0; u < uLines; u++)
+	{
+		oTokens = LexDFA_lexLine(oArena, ppcLines[u]);
+		if ((oTokens != NULL) &&
+			(SynAnalyze_analyze(oArena, oTokens) != NULL))
+			uBuilt++;
+		Arena_reset(oArena);
+	}
+	return uBuilt;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lex and parse each of the uLines lines at ppcLines by pushing each
+   token into the parser as soon as it is found, as ish does, with
+   memory from oArena. Return the number of command lists built. */
+
+static size_t parseByPush(Arena_T oArena, char **ppcLines,
+	size_t uLines)
+{
+	LexDFA_T oLexDFA;
+	SynAnalyze_T oSynAnalyze;
+	size_t u;
+	size_t uBuilt = 0;
+
+	oLexDFA = LexDFA_new();
+	if (oLexDFA == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	for (u = 0; u < uLines; u++)
+	{
+		oSynAnalyze = SynAnalyze_new(oArena);
+		if (LexDFA_pushLine(oLexDFA, oArena, ppcLines[u],
+				strlen(ppcLines[u]), SynAnalyze_addToken, oSynAnalyze) &&
+			(SynAnalyze_finish(oSynAnalyze) != NULL))
+			uBuilt++;
+		Arena_reset(oArena);
+	}
+	LexDFA_free(oLexDFA);
+	return uBuilt;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Program main that returns an int.
+   int argc is the number of arguments, *argv[] an array of the
+   arguments. Read the lines of stdin into memory, then lex and parse
+   all of them argv[1] times (default 10) by each path, and write the
+   time that each path takes per megabyte. */
+
+int main(int argc, char *argv[])
+{
+	char *pcLine = NULL;
+	size_t uLinePhysLength = 0;
+	char **ppcLines = NULL;
+	size_t uLines = 0;
+	size_t uMaxLines = 0;
+	size_t uBytes = 0;
+	long lRounds = 10;
+	long lRound;
+	size_t uListBuilt = 0;
+	size_t uPushBuilt = 0;
+	double dStart;
+	double dList = 0.0;
+	double dPush = 0.0;
+	LineReader_T oInputReader;
+	Arena_T oArena;
+
+	pcPgmName = argv[0];
+	if (argc > 1) lRounds = atol(argv[1]);
+
+	oInputReader = LineReader_new(0);
+	if (oInputReader == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+	while (LineReader_read(oInputReader, &pcLine, &uLinePhysLength)
+		!= NULL)
+	{
+		if (uLines == uMaxLines)
+		{
+			uMaxLines = (uMaxLines == 0) ? 1024 : 2 * uMaxLines;
+			ppcLines = (char**)realloc(ppcLines,
+				uMaxLines * sizeof(char*));
+			if (ppcLines == NULL)
+				{perror(pcPgmName); exit(EXIT_FAILURE);}
+		}
+		ppcLines[uLines] = strdup(pcLine);
+		if (ppcLines[uLines] == NULL)
+			{perror(pcPgmName); exit(EXIT_FAILURE);}
+		uBytes += strlen(pcLine) + 1;
+		uLines++;
+	}
+	LineReader_free(oInputReader);
+	free(pcLine);
+
+	oArena = Arena_new();
+	if (oArena == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	/* Alternate the paths so that both see the same cache state. */
+	for (lRound = 0; lRound < lRounds; lRound++)
+	{
+		dStart = getSeconds();
+		uListBuilt = parseByList(oArena, ppcLines, uLines);
+		dList += getSeconds() - dStart;
+
+		dStart = getSeconds();
+		uPushBuilt = parseByPush(oArena, ppcLines, uLines);
+		dPush += getSeconds() - dStart;
+	}
+
+	printf("%lu lines, %lu bytes, %ld rounds\n", (unsigned long)uLines,
+		(unsigned long)uBytes, lRounds);
+	printf("list: %8.2f ms/MB (%lu commands)\n",
+		1e3 * dList / ((double)lRounds * (double)uBytes / 1e6),
+		(unsigned long)uListBuilt);
+	printf("push: %8.2f ms/MB (%lu commands)\n",
+		1e3 * dPush / ((double)lRounds * (double)uBytes / 1e6),
+		(unsigned long)uPushBuilt);
+
+	Arena_free(oArena);
+	while (uLines > 0)
+		free(ppcLines[--uLines]);
+	free(ppcLines);
+	return 0;
+}
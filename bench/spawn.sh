@@ -0,0 +1,48 @@
+#!/bin/sh
+#----------------------------------------------------------------------
+# bench/spawn.sh
+# Author: Isaac Wolfe
+#----------------------------------------------------------------------
+
+# Measure how the latency of starting a command grows with the size of
+# the parent, for the posix_spawnp() backend that ish uses by default
+# and the fork() backend of ish -F. Then time ish itself running a
+# script of /bin/true lines with each backend.
+#
+# Usage: bench/spawn.sh [runs [megabytes...]]
+
+set -e
+cd "$(dirname "$0")/.."
+
+RUNS=${1:-500}
+[ $# -gt 0 ] && shift
+SIZES=${*:-"0 64 256 1024"}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+$CC $CFLAGS -o "$TMP/spawnbench" bench/spawnbench.c
+for MB in $SIZES; do
+   "$TMP/spawnbench" "$MB" "$RUNS"
+done
+
+$CC $CFLAGS -o "$TMP/ish" ish.c command.c pipeline.c commandlist.c \
+   pathcache.c hashtable.c builtintable.c vartable.c dircache.c jobtable.c \
+   scheduler.c remote.c synAnalyze.c dynarray.c arena.c token.c \
+   linereader.c lexdfa.c lexscan.c -ldl
+awk -v n="$RUNS" 'BEGIN {for (i = 0; i < n; i++) print "/bin/true"}' \
+   > "$TMP/script"
+
+run()
+{
+   printf 'ish %-4s' "$1"
+   shift
+   START=$(date +%s.%N)
+   "$@" -q < "$TMP/script" > /dev/null
+   echo "$START $(date +%s.%N) $RUNS" |
+      awk '{printf "%8.1f us per line\n", 1e6 * ($2 - $1) / $3}'
+}
+
+run spawn "$TMP/ish"
+run -F "$TMP/ish" -F
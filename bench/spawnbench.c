@@ -0,0 +1,131 @@
+/*--------------------------------------------------------------------*/
+/* spawnbench.c                                                       */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The name of the executable binary file. */
+static const char *pcPgmName;
+
+/* The environment of the process. */
+extern char **environ;
+
+/*--------------------------------------------------------------------*/
+
+/* Return the time in seconds on a monotonic clock. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+
+   if (clock_gettime(CLOCK_MONOTONIC, &sNow) == -1)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start ppcArgv with posix_spawnp(), as ish does by default, and
+   wait for it. */
+
+static void runBySpawn(char **ppcArgv)
+{
+   pid_t iPid;
+   int iStatus;
+
+   assert(ppcArgv != NULL);
+
+   if (posix_spawnp(&iPid, ppcArgv[0], NULL, NULL, ppcArgv, environ)
+       != 0)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   if (waitpid(iPid, &iStatus, 0) == -1)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start ppcArgv with fork() and execvp(), as ish -F does, and wait
+   for it. */
+
+static void runByFork(char **ppcArgv)
+{
+   pid_t iPid;
+   int iStatus;
+
+   assert(ppcArgv != NULL);
+
+   iPid = fork();
+   if (iPid == -1)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   if (iPid == 0)
+   {
+      execvp(ppcArgv[0], ppcArgv);
+      _exit(127);
+   }
+   if (waitpid(iPid, &iStatus, 0) == -1)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Program main that returns an int.
+   int argc is the number of arguments, *argv[] an array of the
+   arguments. Grow the process to argv[1] megabytes of touched memory,
+   then start /bin/true argv[2] times (default 500) by each backend,
+   and write the mean latency of each. */
+
+int main(int argc, char *argv[])
+{
+   static char *apcTrue[] = {"/bin/true", NULL};
+   size_t uMegabytes;
+   long lRuns = 500;
+   long lRun;
+   char *pcBallast;
+   double dStart;
+   double dSpawn;
+   double dFork;
+
+   pcPgmName = argv[0];
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s megabytes [runs]\n", pcPgmName);
+      exit(EXIT_FAILURE);
+   }
+   uMegabytes = (size_t)atol(argv[1]);
+   if (argc > 2) lRuns = atol(argv[2]);
+
+   /* Touch every page, so that fork() has page tables to copy. */
+   pcBallast = (char*)malloc(uMegabytes * 1024 * 1024 + 1);
+   if (pcBallast == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   memset(pcBallast, 1, uMegabytes * 1024 * 1024 + 1);
+
+   dStart = getSeconds();
+   for (lRun = 0; lRun < lRuns; lRun++)
+      runBySpawn(apcTrue);
+   dSpawn = (getSeconds() - dStart) / (double)lRuns;
+
+   dStart = getSeconds();
+   for (lRun = 0; lRun < lRuns; lRun++)
+      runByFork(apcTrue);
+   dFork = (getSeconds() - dStart) / (double)lRuns;
+
+   printf("%6lu MB  spawn %8.1f us  fork %8.1f us\n",
+          (unsigned long)uMegabytes, 1e6 * dSpawn, 1e6 * dFork);
+
+   free(pcBallast);
+   return 0;
+}
@@ -0,0 +1,426 @@
+/*--------------------------------------------------------------------*/
+/* builtintable.c                                                     */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "builtintable.h"
+#include "hashtable.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+
+/*--------------------------------------------------------------------*/
+
+enum {FALSE, TRUE};
+
+/*--------------------------------------------------------------------*/
+
+/* The number of slots of a new BuiltinTable, which holds a few
+   dozen names. It is a power of two, as each larger one is. */
+
+enum {INITIAL_SLOT_COUNT = 64};
+
+/* The suffix of the name of the function in a shared object that
+   executes a builtin command. */
+
+static const char FUNCTION_SUFFIX[] = "_builtin";
+
+/*--------------------------------------------------------------------*/
+
+/* A Builtin is a command name and the function that executes it. */
+
+struct Builtin
+{
+   /* The command name, and the function bound to it. */
+   char *pcName;
+   BuiltinTable_Function pfFunction;
+
+   /* The path of the shared object that the function comes from, or
+      NULL if it is part of the shell. */
+   const char *pcLibrary;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Slot is one place in the open-addressing array of a
+   BuiltinTable. It keeps the hash of its name, so that probing
+   compares most names without following psBuiltin. */
+
+struct Slot
+{
+   size_t uHash;
+
+   /* The Builtin in the Slot, or NULL if the Slot is empty. */
+   struct Builtin *psBuiltin;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Library is a shared object that BuiltinTable_load() opened. */
+
+struct Library
+{
+   /* The handle that dlopen() returned, and the path it opened. */
+   void *pvHandle;
+   char *pcPath;
+
+   /* The Library opened before this one. */
+   struct Library *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A BuiltinTable is a hash table of Builtins, open-addressed with
+   linear probing, and the Libraries that they come from. Names are
+   never removed, so a probe ends at the first empty Slot. The table
+   grows before it is half full, which keeps probes short. The
+   Builtins themselves do not move when it grows, since commands
+   point to them. */
+
+struct BuiltinTable
+{
+   /* The uSlotCount Slots, uLength of which hold Builtins. */
+   struct Slot *psSlots;
+   size_t uSlotCount;
+   size_t uLength;
+
+   struct Library *psLibraries;
+
+   /* The message of the last error of BuiltinTable_load(). */
+   char acMessage[256];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the Slot of oBuiltinTable that holds pcName, whose hash is
+   uHash, or else the empty Slot where pcName belongs. */
+
+static struct Slot *BuiltinTable_probe(BuiltinTable_T oBuiltinTable,
+   const char *pcName, size_t uHash)
+{
+   struct Slot *psSlot;
+   size_t uMask;
+   size_t u;
+
+   uMask = oBuiltinTable->uSlotCount - 1;
+   for (u = uHash & uMask; ; u = (u + 1) & uMask)
+   {
+      psSlot = &oBuiltinTable->psSlots[u];
+      if (psSlot->psBuiltin == NULL)
+         return psSlot;
+      if ((psSlot->uHash == uHash) &&
+          (strcmp(psSlot->psBuiltin->pcName, pcName) == 0))
+         return psSlot;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the Builtin for pcName in oBuiltinTable, or NULL if there
+   is none. */
+
+static struct Builtin *BuiltinTable_find(BuiltinTable_T oBuiltinTable,
+   const char *pcName)
+{
+   return BuiltinTable_probe(oBuiltinTable, pcName,
+      HashTable_hashString(pcName))->psBuiltin;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the number of Slots of oBuiltinTable. Return TRUE if
+   successful, or FALSE if insufficient memory is available. */
+
+static int BuiltinTable_grow(BuiltinTable_T oBuiltinTable)
+{
+   struct Slot *psOldSlots;
+   struct Slot *psSlot;
+   size_t uOldSlotCount;
+   size_t uMask;
+   size_t u;
+   size_t v;
+
+   psOldSlots = oBuiltinTable->psSlots;
+   uOldSlotCount = oBuiltinTable->uSlotCount;
+   oBuiltinTable->psSlots = (struct Slot*)
+      calloc(uOldSlotCount * 2, sizeof(struct Slot));
+   if (oBuiltinTable->psSlots == NULL)
+   {
+      oBuiltinTable->psSlots = psOldSlots;
+      return FALSE;
+   }
+   oBuiltinTable->uSlotCount = uOldSlotCount * 2;
+
+   /* The names are distinct, so each goes in the first empty Slot. */
+   uMask = oBuiltinTable->uSlotCount - 1;
+   for (u = 0; u < uOldSlotCount; u++)
+   {
+      if (psOldSlots[u].psBuiltin == NULL)
+         continue;
+      v = psOldSlots[u].uHash & uMask;
+      psSlot = &oBuiltinTable->psSlots[v];
+      while (psSlot->psBuiltin != NULL)
+      {
+         v = (v + 1) & uMask;
+         psSlot = &oBuiltinTable->psSlots[v];
+      }
+      *psSlot = psOldSlots[u];
+   }
+   free(psOldSlots);
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind pcName to pfFunction from the shared object at pcLibrary, or
+   from the shell if pcLibrary is NULL, in oBuiltinTable. Return
+   TRUE if successful, or FALSE if insufficient memory is
+   available. */
+
+static int BuiltinTable_bind(BuiltinTable_T oBuiltinTable,
+   const char *pcName, BuiltinTable_Function pfFunction,
+   const char *pcLibrary)
+{
+   struct Builtin *psBuiltin;
+   struct Slot *psSlot;
+   size_t uHash;
+
+   /* A Builtin that commands may point to is changed in place. */
+   uHash = HashTable_hashString(pcName);
+   psSlot = BuiltinTable_probe(oBuiltinTable, pcName, uHash);
+   psBuiltin = psSlot->psBuiltin;
+   if (psBuiltin == NULL)
+   {
+      /* Grow first, so that the new name is probed for anew. */
+      if ((oBuiltinTable->uLength + 1) * 2 > oBuiltinTable->uSlotCount)
+      {
+         if (! BuiltinTable_grow(oBuiltinTable))
+            return FALSE;
+         psSlot = BuiltinTable_probe(oBuiltinTable, pcName, uHash);
+      }
+
+      psBuiltin = (struct Builtin*)malloc(sizeof(struct Builtin));
+      if (psBuiltin == NULL)
+         return FALSE;
+      psBuiltin->pcName = (char*)malloc(strlen(pcName) + 1);
+      if (psBuiltin->pcName == NULL)
+      {
+         free(psBuiltin);
+         return FALSE;
+      }
+      strcpy(psBuiltin->pcName, pcName);
+
+      psSlot->uHash = uHash;
+      psSlot->psBuiltin = psBuiltin;
+      oBuiltinTable->uLength++;
+   }
+   psBuiltin->pfFunction = pfFunction;
+   psBuiltin->pcLibrary = pcLibrary;
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty BuiltinTable object, or NULL if insufficient
+   memory is available. */
+
+BuiltinTable_T BuiltinTable_new(void)
+{
+   BuiltinTable_T oBuiltinTable;
+
+   oBuiltinTable = (struct BuiltinTable*)
+      calloc(1, sizeof(struct BuiltinTable));
+   if (oBuiltinTable == NULL)
+      return NULL;
+
+   oBuiltinTable->psSlots = (struct Slot*)
+      calloc(INITIAL_SLOT_COUNT, sizeof(struct Slot));
+   if (oBuiltinTable->psSlots == NULL)
+   {
+      free(oBuiltinTable);
+      return NULL;
+   }
+   oBuiltinTable->uSlotCount = INITIAL_SLOT_COUNT;
+   return oBuiltinTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oBuiltinTable, and close the shared objects that
+   BuiltinTable_load() opened for it. */
+
+void BuiltinTable_free(BuiltinTable_T oBuiltinTable)
+{
+   struct Builtin *psBuiltin;
+   struct Library *psLibrary;
+   struct Library *psNextLibrary;
+   size_t u;
+
+   if (oBuiltinTable == NULL)
+      return;
+
+   for (u = 0; u < oBuiltinTable->uSlotCount; u++)
+   {
+      psBuiltin = oBuiltinTable->psSlots[u].psBuiltin;
+      if (psBuiltin == NULL)
+         continue;
+      free(psBuiltin->pcName);
+      free(psBuiltin);
+   }
+   free(oBuiltinTable->psSlots);
+
+   for (psLibrary = oBuiltinTable->psLibraries; psLibrary != NULL;
+        psLibrary = psNextLibrary)
+   {
+      psNextLibrary = psLibrary->psNext;
+      dlclose(psLibrary->pvHandle);
+      free(psLibrary->pcPath);
+      free(psLibrary);
+   }
+   free(oBuiltinTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind pcName to pfFunction in oBuiltinTable, in place of any
+   function that it was bound to. oBuiltinTable keeps a copy of
+   pcName. Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+int BuiltinTable_add(BuiltinTable_T oBuiltinTable, const char *pcName,
+   BuiltinTable_Function pfFunction)
+{
+   assert(oBuiltinTable != NULL);
+   assert(pcName != NULL);
+   assert(pfFunction != NULL);
+
+   return BuiltinTable_bind(oBuiltinTable, pcName, pfFunction, NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Open the shared object at path pcLibrary, and bind pcName in
+   oBuiltinTable to the function pcName_builtin that it defines, as
+   BuiltinTable_add() does. Return NULL if successful, or else a
+   message that tells what went wrong. */
+
+const char *BuiltinTable_load(BuiltinTable_T oBuiltinTable,
+   const char *pcLibrary, const char *pcName)
+{
+   struct Library *psLibrary;
+   void *pvHandle;
+   void *pvSymbol;
+   char *pcSymbol;
+
+   assert(oBuiltinTable != NULL);
+   assert(pcLibrary != NULL);
+   assert(pcName != NULL);
+
+   pvHandle = dlopen(pcLibrary, RTLD_NOW | RTLD_LOCAL);
+   if (pvHandle == NULL)
+      return dlerror();
+
+   pcSymbol = (char*)malloc(strlen(pcName) + sizeof(FUNCTION_SUFFIX));
+   if (pcSymbol == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   strcpy(pcSymbol, pcName);
+   strcat(pcSymbol, FUNCTION_SUFFIX);
+   dlerror();
+   pvSymbol = dlsym(pvHandle, pcSymbol);
+   free(pcSymbol);
+   if (pvSymbol == NULL)
+   {
+      /* Keep the message, which dlclose() may free. */
+      snprintf(oBuiltinTable->acMessage, sizeof(oBuiltinTable->acMessage),
+         "%s", dlerror());
+      dlclose(pvHandle);
+      return oBuiltinTable->acMessage;
+   }
+
+   /* Each Library holds one reference to its shared object. */
+   psLibrary = (struct Library*)malloc(sizeof(struct Library));
+   if (psLibrary == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psLibrary->pcPath = (char*)malloc(strlen(pcLibrary) + 1);
+   if (psLibrary->pcPath == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   strcpy(psLibrary->pcPath, pcLibrary);
+   psLibrary->pvHandle = pvHandle;
+   psLibrary->psNext = oBuiltinTable->psLibraries;
+   oBuiltinTable->psLibraries = psLibrary;
+
+   /* POSIX lets dlsym() return functions through a void*. */
+   if (! BuiltinTable_bind(oBuiltinTable, pcName,
+      *(BuiltinTable_Function*)&pvSymbol, psLibrary->pcPath))
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entry of command name pcName in oBuiltinTable, or NULL
+   if pcName is not a builtin command. */
+
+Builtin_T BuiltinTable_lookup(BuiltinTable_T oBuiltinTable,
+   const char *pcName)
+{
+   assert(oBuiltinTable != NULL);
+   assert(pcName != NULL);
+
+   return BuiltinTable_find(oBuiltinTable, pcName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the builtin command of oBuiltin with the iArgc strings of
+   ppcArgv, which end with NULL, and return its exit status. */
+
+int BuiltinTable_execute(Builtin_T oBuiltin, int iArgc,
+   char *ppcArgv[])
+{
+   assert(oBuiltin != NULL);
+   assert(ppcArgv != NULL);
+   assert(ppcArgv[iArgc] == NULL);
+
+   return (*oBuiltin->pfFunction)(iArgc, ppcArgv);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the function that oBuiltin is bound to. */
+
+BuiltinTable_Function BuiltinTable_getFunction(Builtin_T oBuiltin)
+{
+   assert(oBuiltin != NULL);
+
+   return oBuiltin->pfFunction;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the name of each builtin command in
+   oBuiltinTable, with the shared object that it comes from, if
+   any. */
+
+void BuiltinTable_write(BuiltinTable_T oBuiltinTable)
+{
+   struct Builtin *psBuiltin;
+   size_t u;
+
+   assert(oBuiltinTable != NULL);
+
+   for (u = 0; u < oBuiltinTable->uSlotCount; u++)
+   {
+      psBuiltin = oBuiltinTable->psSlots[u].psBuiltin;
+      if (psBuiltin == NULL)
+         continue;
+      if (psBuiltin->pcLibrary == NULL)
+         printf("enable %s\n", psBuiltin->pcName);
+      else
+         printf("enable -f %s %s\n", psBuiltin->pcLibrary,
+            psBuiltin->pcName);
+   }
+}
@@ -0,0 +1,99 @@
+/*--------------------------------------------------------------------*/
+/* builtintable.h                                                     */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef BUILTINTABLE_INCLUDED
+#define BUILTINTABLE_INCLUDED
+
+/*--------------------------------------------------------------------*/
+
+/* A BuiltinTable object maps the names of builtin commands to the
+   functions that execute them, so that a command name is found with
+   one hash lookup rather than by comparing it with every name. */
+
+typedef struct BuiltinTable *BuiltinTable_T;
+
+/*--------------------------------------------------------------------*/
+
+/* A Builtin is the entry of one name in a BuiltinTable. It lasts as
+   long as its table does, even if its name is bound anew. */
+
+typedef struct Builtin *Builtin_T;
+
+/*--------------------------------------------------------------------*/
+
+/* A function that executes a builtin command as main() executes a
+   program: ppcArgv holds the name of the command, its arguments and
+   NULL, and iArgc is the number of strings before NULL. It returns
+   the exit status of the command. A shared object given to
+   BuiltinTable_load() defines one for each builtin command name,
+   called name_builtin. */
+
+typedef int (*BuiltinTable_Function)(int iArgc, char *ppcArgv[]);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty BuiltinTable object, or NULL if insufficient
+   memory is available. */
+
+BuiltinTable_T BuiltinTable_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oBuiltinTable, and close the shared objects that
+   BuiltinTable_load() opened for it. */
+
+void BuiltinTable_free(BuiltinTable_T oBuiltinTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Bind pcName to pfFunction in oBuiltinTable, in place of any
+   function that it was bound to. oBuiltinTable keeps a copy of
+   pcName. Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+int BuiltinTable_add(BuiltinTable_T oBuiltinTable, const char *pcName,
+   BuiltinTable_Function pfFunction);
+
+/*--------------------------------------------------------------------*/
+
+/* Open the shared object at path pcLibrary, and bind pcName in
+   oBuiltinTable to the function pcName_builtin that it defines, as
+   BuiltinTable_add() does. Return NULL if successful, or else a
+   message that tells what went wrong. */
+
+const char *BuiltinTable_load(BuiltinTable_T oBuiltinTable,
+   const char *pcLibrary, const char *pcName);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entry of command name pcName in oBuiltinTable, or NULL
+   if pcName is not a builtin command. */
+
+Builtin_T BuiltinTable_lookup(BuiltinTable_T oBuiltinTable,
+   const char *pcName);
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the builtin command of oBuiltin with the iArgc strings of
+   ppcArgv, which end with NULL, and return its exit status. */
+
+int BuiltinTable_execute(Builtin_T oBuiltin, int iArgc,
+   char *ppcArgv[]);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the function that oBuiltin is bound to. */
+
+BuiltinTable_Function BuiltinTable_getFunction(Builtin_T oBuiltin);
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the name of each builtin command in
+   oBuiltinTable, with the shared object that it comes from, if
+   any. */
+
+void BuiltinTable_write(BuiltinTable_T oBuiltinTable);
+
+#endif
@@ -13,7 +13,10 @@
 /*--------------------------------------------------------------------*/
 
 /* A Command is an object that contains pcName, the arguments 
-   for the action (oArguments), and pcStdIn and pcStdOut. */
+   for the action, pcStdIn and pcStdOut, and the variable assignments
+   that come before the name. It is one block of memory, which ends
+   with the arguments as execvp() expects them, then the assignments,
+   and then the flags of the quoted words, if there are any. */
 
 struct Command
 {
@@ -26,112 +29,85 @@ struct Command
 	/* StdOut file name */
 	char* pcStdOut;
 
-	/* Dynarray_T object of the potential arguments. */
-	DynArray_T oArguments;
-};
-
-/*--------------------------------------------------------------------*/
-
-/* Make a new command object with the name/action pcName, with the 
-   arguments oArguments, and with standard input and output designated
-   by pcStdIn and pcStdIn */
+	/* The number of arguments. */
+	size_t uArgCount;
 
-Command_T Command_new(char* pcName, char* pcStdIn, char* pcStdOut, 
-	DynArray_T oArguments)
-{
-	Command_T oCommand;
-	size_t ulNameLength;
-	size_t ulStdInLength;
-	size_t ulStdOutLength;
-	size_t ulIndex;
-	size_t ulArgumentsLength;
-	size_t ulCurrArgumnetLength;
-	char* currArgument;
+	/* For the name and each argument, whether it held a quoted
+	   literal, or NULL if none did. */
+	int* piQuoted;
 
+	/* The builtin command that the shell found the name to stand
+	   for, or NULL if it is external, and whether the shell has
+	   looked the name up. */
+	Builtin_T oBuiltin;
+	int iLookedUp;
 
-	assert(pcName != NULL);
+	/* The number of assignments, and the assignments followed by
+	   NULL, which lie in apcArgv after its NULL. */
+	size_t uAssignCount;
+	char** ppcAssigns;
 
-	/* Allocate memory for the oCommand object itself. */
-	oCommand = (struct Command*)malloc(sizeof(struct Command));
-
-	/* Retuen error if insufficient memory. */
-	if (oCommand == NULL)
-		{perror(pcPgmName); exit(EXIT_FAILURE);}
-
-	/* Allocate memory for pcName contained within oCommand.
-	   We have already established that pcName is not NULL.
-	   Exit error if insufficient memory. */
-	ulNameLength = strlen(pcName) + 1;
-	oCommand->pcName = (char*)malloc(sizeof(char) * ulNameLength);
-	if (oCommand->pcName == NULL)
-		{perror(pcPgmName); exit(EXIT_FAILURE);}
-	strcpy(oCommand->pcName, pcName);
-
-	/* Copy over pcStdIn. */
-	/* Make oCommand's pcStdIn NULL of NULL is passed in... */
-	if (pcStdIn == NULL)
-	{
-		oCommand->pcStdIn = NULL;
-	}
-	/* ...otherwise, allocate memory and copy pcStdIn.
-	   Exit error if insufficient memory. */
-	else 
-	{
-		ulStdInLength = strlen(pcStdIn) + 1;
-		oCommand->pcStdIn = 
-		(char*)malloc(sizeof(char) * ulStdInLength);
-		if (oCommand->pcStdIn == NULL)
-			{perror(pcPgmName); exit(EXIT_FAILURE);}
-		strcpy(oCommand->pcStdIn, pcStdIn);
-	}
+	/* The name followed by the arguments and NULL, as execvp()
+	   expects them, and then the assignments followed by NULL. */
+	char* apcArgv[];
+};
 
-	/* Copy over pcStdOut. */
-	/* Make oCommand's pcStdOut NULL of NULL is passed in... */
-	if (pcStdOut == NULL)
-	{
-		oCommand->pcStdOut = NULL;
-	}
-	/* ...otherwise, allocate memory and copy pcStdIn.
-	   Exit error if insufficient memory. */
-	else 
-	{
-		ulStdOutLength = strlen(pcStdOut) + 1;
-		oCommand->pcStdOut = 
-		(char*)malloc(sizeof(char) * ulStdOutLength);
-		if (oCommand->pcStdOut == NULL)
-			{perror(pcPgmName); exit(EXIT_FAILURE);}
-		strcpy(oCommand->pcStdOut, pcStdOut);
-	}
+/*--------------------------------------------------------------------*/
 
-	/* Copy over oArguments. */
-	/* Make oCommand's oArguments NULL of NULL is passed in... */
-	if (oArguments == NULL)
-	{
-		oCommand->oArguments = NULL;
-	}
-	/* ...otherwise, allocate memory and copy over each element
-	   in the dynamic array. */
-	else 
+/* Make a new command object from ppcArgv, which holds the name/action,
+   the uArgCount arguments, and NULL, with piQuoted, which holds for
+   each of the name and the arguments whether it held a quoted
+   literal, or is NULL if none did, with standard input and output
+   designated by pcStdIn and pcStdOut, and with the uAssignCount
+   "name=value" assignments of ppcAssigns, which may be NULL if there
+   are none, in effect for it alone. The command is one block from
+   oArena, which holds copies of ppcArgv, piQuoted and ppcAssigns
+   after its other fields, so all may be reused at once. The strings
+   are taken as they are, without copying them; they must last until
+   oArena is reset. */
+
+Command_T Command_new(Arena_T oArena, char** ppcArgv, size_t uArgCount,
+	const int* piQuoted, char* pcStdIn, char* pcStdOut, 
+	char** ppcAssigns, size_t uAssignCount)
+{
+	Command_T oCommand;
+	size_t uQuotedCount;
+
+	assert(oArena != NULL);
+	assert(ppcArgv != NULL);
+	assert(ppcArgv[0] != NULL);
+	assert(ppcArgv[uArgCount + 1] == NULL);
+	assert((ppcAssigns != NULL) || (uAssignCount == 0));
+
+	uQuotedCount = (piQuoted == NULL) ? 0 : uArgCount + 1;
+	oCommand = (struct Command*)Arena_alloc(oArena, 
+		sizeof(struct Command) + 
+		sizeof(char*) * (uArgCount + uAssignCount + 3) +
+		sizeof(int) * uQuotedCount);
+
+	memcpy(oCommand->apcArgv, ppcArgv, 
+		sizeof(char*) * (uArgCount + 2));
+	oCommand->ppcAssigns = oCommand->apcArgv + uArgCount + 2;
+	if (uAssignCount > 0)
+		memcpy(oCommand->ppcAssigns, ppcAssigns, 
+			sizeof(char*) * uAssignCount);
+	oCommand->ppcAssigns[uAssignCount] = NULL;
+	oCommand->piQuoted = NULL;
+	if (piQuoted != NULL)
 	{
-		/* Memory allocation for oCommands's oArguments. */
-		ulArgumentsLength = DynArray_getLength(oArguments);
-		oCommand->oArguments = DynArray_new(ulArgumentsLength);
-
-		/* Memory allocation for each element in oArguments. */
-		for (ulIndex = 0; 
-			 ulIndex < DynArray_getLength(oArguments);
-			 ulIndex++)
-		{	
-			ulCurrArgumnetLength = 
-			strlen(DynArray_get(oArguments, ulIndex)) + 1;
-			currArgument = 
-			(char*)malloc(sizeof(char) * ulCurrArgumnetLength);
-			strcpy(currArgument, DynArray_get(oArguments, ulIndex));
-			(void)DynArray_set(oCommand->oArguments, ulIndex, currArgument);	
-		}	
+		oCommand->piQuoted = 
+			(int*)(oCommand->ppcAssigns + uAssignCount + 1);
+		memcpy(oCommand->piQuoted, piQuoted, 
+			sizeof(int) * uQuotedCount);
 	}
+	oCommand->pcName = oCommand->apcArgv[0];
+	oCommand->pcStdIn = pcStdIn;
+	oCommand->pcStdOut = pcStdOut;
+	oCommand->uArgCount = uArgCount;
+	oCommand->uAssignCount = uAssignCount;
+	oCommand->oBuiltin = NULL;
+	oCommand->iLookedUp = 0;
 
-	/* if (oArguments != NULL) DynArray_free(oArguments); */
 	return oCommand;
 }
 
@@ -144,19 +120,20 @@ void Command_write(Command_T oCommand)
 	size_t ulIndex;
 	assert(oCommand != NULL);
 
+	/* Print the assignments, if any. */
+	for (ulIndex = 0; ulIndex < oCommand->uAssignCount; ulIndex++)
+	{
+		printf("Command assignment: %s\n", 
+			oCommand->ppcAssigns[ulIndex]);
+	}
+
 	/* Print name of the commmand. */
 	printf("Command name: %s\n", oCommand->pcName);
 
-	/* Print oArguemnts if not NULL. */
-	if (oCommand->oArguments != NULL)
+	/* Print the arguments, if any. */
+	for (ulIndex = 0; ulIndex < oCommand->uArgCount; ulIndex++)
 	{
-		for (ulIndex = 0; 
-			ulIndex < DynArray_getLength(oCommand->oArguments);
-			ulIndex++)
-		{
-			printf("Command arg: %s\n", 
-				(char*)DynArray_get(oCommand->oArguments, ulIndex));
-		}
+		printf("Command arg: %s\n", oCommand->apcArgv[ulIndex + 1]);
 	}
 
 	/* Print StdIn of command if not NULL. */
@@ -171,122 +148,146 @@ void Command_write(Command_T oCommand)
 
 /*--------------------------------------------------------------------*/
 
-/* Free oCommand. */
+/* Return pcStdIn of oCommand. */
 
-void Command_free(Command_T oCommand)
+char* Command_getStdIn(Command_T oCommand)
 {
-	size_t ulIndex;
+	assert(oCommand != NULL);
+	return oCommand->pcStdIn;
+}
 
-	/* Free pcName. */
-	free(oCommand->pcName);
+/*--------------------------------------------------------------------*/
 
-	/* Free oArguments. */
-	if (oCommand->oArguments != NULL)
-	{
-		for (ulIndex = 0; 
-			ulIndex < DynArray_getLength(oCommand->oArguments);
-			ulIndex++)
-		{
-			free(DynArray_get(oCommand->oArguments, ulIndex));
-		}
-		DynArray_free(oCommand->oArguments);
-	}
+/* Return pcStdOut of oCommand. */
 
-	/* Free pcStdIn if not NULL. */
-	if (oCommand->pcStdIn != NULL) 
-	{
-		free(oCommand->pcStdIn);
-	}
+char* Command_getStdOut(Command_T oCommand)
+{
+	assert(oCommand != NULL);
 
-	/* Free pcStdOut if not NULL. */
-	if (oCommand->pcStdOut != NULL) 
-	{
-		free(oCommand->pcStdOut);
-	}
+	return oCommand->pcStdOut;
+}
 
-	/* Free oCommand itself. */
-	free(oCommand);
+/*--------------------------------------------------------------------*/
+
+/* Return name of oCommand. */
+
+char* Command_getName(Command_T oCommand)
+{
+	assert(oCommand != NULL);
+	return oCommand->pcName;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Return pcStdIn of oCommand. */
+/* Return the number of arguments of oCommand. */
 
-char* Command_getStdIn(Command_T oCommand)
+size_t Command_getArgCount(Command_T oCommand)
 {
 	assert(oCommand != NULL);
-	return oCommand->pcStdIn;
+	return oCommand->uArgCount;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Return pcStdOut of oCommand. */
+/* Return the uIndex'th argument of oCommand. */
 
-char* Command_getStdOut(Command_T oCommand)
+char* Command_getArg(Command_T oCommand, size_t uIndex)
 {
 	assert(oCommand != NULL);
+	assert(uIndex < oCommand->uArgCount);
+	return oCommand->apcArgv[uIndex + 1];
+}
 
-	return oCommand->pcStdOut;
+/*--------------------------------------------------------------------*/
+
+/* Return the NULL-terminated char** array of oCommand's name followed
+   by its arguments, ready to be passed to execvp(). oCommand owns
+   the array. */
+
+char** Command_getArgsArray(Command_T oCommand)
+{
+	assert(oCommand != NULL);
+	return oCommand->apcArgv;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Return name of oCommand. */
+/* Return the array that holds, for the name of oCommand and each of
+   its arguments, 1 (TRUE) iff it held a quoted literal, or NULL if
+   none did. oCommand owns the array. */
 
-char* Command_getName(Command_T oCommand)
+const int* Command_getQuoted(Command_T oCommand)
 {
 	assert(oCommand != NULL);
-	return oCommand->pcName;
+	return oCommand->piQuoted;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Return oArguments of oCommand. */
+/* Return 1 (TRUE) iff the uIndex'th word of oCommand, counting the
+   name as the 0th, held a quoted literal, or 0 (FALSE) otherwise. */
 
-DynArray_T Command_getArguments(Command_T oCommand)
+int Command_isQuoted(Command_T oCommand, size_t uIndex)
 {
 	assert(oCommand != NULL);
-	return oCommand->oArguments;
+	assert(uIndex <= oCommand->uArgCount);
+	return (oCommand->piQuoted != NULL) && oCommand->piQuoted[uIndex];
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Return char** array of oCommand's Command->oArguments. */
+/* Store in oCommand oBuiltin, the builtin command that the shell
+   found its name to stand for, or NULL if it found the command to be
+   external, so that the name is looked up once. */
 
-char** Command_getArgsArray(Command_T oCommand)
+void Command_setBuiltin(Command_T oCommand, Builtin_T oBuiltin)
+{
+	assert(oCommand != NULL);
+	oCommand->oBuiltin = oBuiltin;
+	oCommand->iLookedUp = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff Command_setBuiltin() has been called for
+   oCommand, or 0 (FALSE) otherwise. */
+
+int Command_isLookedUp(Command_T oCommand)
 {
-	char** ppcArguments;
-	size_t index;
-	size_t ulLength;
+	assert(oCommand != NULL);
+	return oCommand->iLookedUp;
+}
+
+/*--------------------------------------------------------------------*/
 
+/* Return the builtin command that Command_setBuiltin() stored in
+   oCommand, or NULL if the command is external or has not been looked
+   up. */
+
+Builtin_T Command_getBuiltin(Command_T oCommand)
+{
 	assert(oCommand != NULL);
+	return oCommand->oBuiltin;
+}
 
-	/* If oArguments is empyt, make the uLength zero. */
-	if (oCommand->oArguments == NULL) ulLength = 0;
-	else ulLength = DynArray_getLength(oCommand->oArguments);
-
-	/* Use oArgument's length to malloc memory. Create two additional 
-	   char* of memory to store the command name and the NULL 
-	   character. */
-	ppcArguments = 
-	(char**)malloc(sizeof(char*) * 
-		(ulLength + 2));
-
-	/* Return failure if no memory. */
-	if (ppcArguments == NULL)
-		{perror(pcPgmName); exit(EXIT_FAILURE);}
-
-	/* Make firt index name, fill middle with args (if any) and
-	   make last NULL. */
-	ppcArguments[0] = oCommand->pcName;
-	for (index = 1; 
-		index < ulLength + 1;
-		index++)
-	{
-		ppcArguments[index] = DynArray_get(oCommand->oArguments, index - 1);
-	}
-	ppcArguments[index] = NULL;
+/*--------------------------------------------------------------------*/
 
-	return ppcArguments;
+/* Return the number of variable assignments of oCommand. */
+
+size_t Command_getAssignCount(Command_T oCommand)
+{
+	assert(oCommand != NULL);
+	return oCommand->uAssignCount;
 }
 
+/*--------------------------------------------------------------------*/
+
+/* Return the NULL-terminated char** array of oCommand's "name=value"
+   variable assignments, which hold for oCommand alone. oCommand owns
+   the array. */
+
+char** Command_getAssignments(Command_T oCommand)
+{
+	assert(oCommand != NULL);
+	return oCommand->ppcAssigns;
+}
@@ -6,7 +6,9 @@
 #ifndef COMMAND_INCLUDED
 #define COMMAND_INCLUDED
 
-#include "dynarray.h"
+#include "arena.h"
+#include "builtintable.h"
+#include <stddef.h>
 
 /*--------------------------------------------------------------------*/
 
@@ -17,13 +19,21 @@ typedef struct Command* Command_T;
 
 /*--------------------------------------------------------------------*/
 
-/* Returns a new command object with the name/action pcName, with the 
-   arguments oArguments, and with standard input and output designated
-   by pcStdIn and pcStdOut */
-
-Command_T Command_new(char* pcName, char* pcStdIn, char* pcStdOut, 
-	DynArray_T oArguments);
-
+/* Returns a new command object from ppcArgv, which holds the
+   name/action, the uArgCount arguments, and NULL, with piQuoted,
+   which holds for each of the name and the arguments whether it held
+   a quoted literal, or is NULL if none did, with standard input and
+   output designated by pcStdIn and pcStdOut, and with the
+   uAssignCount "name=value" assignments of ppcAssigns, which may be
+   NULL if there are none, in effect for it alone. The command is one
+   block from oArena, which holds copies of ppcArgv, piQuoted and
+   ppcAssigns after its other fields, so all may be reused at once.
+   The strings are taken as they are, without copying them; they must
+   last until oArena is reset. */
+
+Command_T Command_new(Arena_T oArena, char** ppcArgv, size_t uArgCount,
+	const int* piQuoted, char* pcStdIn, char* pcStdOut, 
+	char** ppcAssigns, size_t uAssignCount);
 
 /*--------------------------------------------------------------------*/
 
@@ -33,12 +43,6 @@ void Command_write(Command_T oCommand);
 
 /*--------------------------------------------------------------------*/
 
-/* Free oCommand. */
-
-void Command_free(Command_T oCommand);
-
-/*--------------------------------------------------------------------*/
-
 /* Return stdin string of oCommand. */
 
 char* Command_getStdIn(Command_T oCommand);
@@ -57,14 +61,74 @@ char* Command_getName(Command_T oCommand);
 
 /*--------------------------------------------------------------------*/
 
-/* Return oArguments of oCommand. */
+/* Return the number of arguments of oCommand. */
+
+size_t Command_getArgCount(Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th argument of oCommand. */
 
-DynArray_T Command_getArguments(Command_T oCommand);
+char* Command_getArg(Command_T oCommand, size_t uIndex);
 
 /*--------------------------------------------------------------------*/
 
-/* Return char** array of oCommand's Command->oArguments. */
+/* Return the NULL-terminated char** array of oCommand's name followed
+   by its arguments, ready to be passed to execvp(). oCommand owns
+   the array. */
 
 char** Command_getArgsArray(Command_T oCommand);
 
-#endif
\ No newline at end of file
+/*--------------------------------------------------------------------*/
+
+/* Return the array that holds, for the name of oCommand and each of
+   its arguments, 1 (TRUE) iff it held a quoted literal, or NULL if
+   none did. oCommand owns the array. */
+
+const int* Command_getQuoted(Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff the uIndex'th word of oCommand, counting the
+   name as the 0th, held a quoted literal, or 0 (FALSE) otherwise. */
+
+int Command_isQuoted(Command_T oCommand, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Store in oCommand oBuiltin, the builtin command that the shell
+   found its name to stand for, or NULL if it found the command to be
+   external, so that the name is looked up once. */
+
+void Command_setBuiltin(Command_T oCommand, Builtin_T oBuiltin);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff Command_setBuiltin() has been called for
+   oCommand, or 0 (FALSE) otherwise. */
+
+int Command_isLookedUp(Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the builtin command that Command_setBuiltin() stored in
+   oCommand, or NULL if the command is external or has not been looked
+   up. */
+
+Builtin_T Command_getBuiltin(Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of variable assignments of oCommand. */
+
+size_t Command_getAssignCount(Command_T oCommand);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the NULL-terminated char** array of oCommand's "name=value"
+   variable assignments, which hold for oCommand alone. oCommand owns
+   the array. */
+
+char** Command_getAssignments(Command_T oCommand);
+
+#endif
@@ -0,0 +1,181 @@
+/*--------------------------------------------------------------------*/
+/* commandlist.c                                                      */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "commandlist.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of pipelines that a new CommandList has room for. */
+
+enum {INITIAL_MAX_LENGTH = 4};
+
+/*--------------------------------------------------------------------*/
+
+/* An Element is a pipeline of a CommandList, with the condition under
+   which it runs and where. */
+
+struct Element
+{
+	/* The pipeline. */
+	Pipeline_T oPipeline;
+
+	/* The condition under which it runs. */
+	enum ListCondition eCondition;
+
+	/* Whether it runs in the background. */
+	int iBackground;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A CommandList is an object that contains its elements, in order. */
+
+struct CommandList
+{
+	/* The arena from which the elements are allocated. */
+	Arena_T oArena;
+
+	/* The number of elements, and the number that psElements has
+	   room for. */
+	size_t uLength;
+	size_t uMaxLength;
+
+	/* The elements, first to last. */
+	struct Element* psElements;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Make a new, empty command list object, allocated from oArena. */
+
+CommandList_T CommandList_new(Arena_T oArena)
+{
+	CommandList_T oCommandList;
+
+	assert(oArena != NULL);
+
+	oCommandList = (struct CommandList*)
+		Arena_alloc(oArena, sizeof(struct CommandList));
+	oCommandList->oArena = oArena;
+	oCommandList->uLength = 0;
+	oCommandList->uMaxLength = INITIAL_MAX_LENGTH;
+	oCommandList->psElements = (struct Element*)
+		Arena_alloc(oArena, sizeof(struct Element) * INITIAL_MAX_LENGTH);
+
+	return oCommandList;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to the end of oCommandList the pipeline oPipeline, which runs
+   under condition eCondition, in the background if iBackground is
+   TRUE. The list grows in memory from the arena of oCommandList. */
+
+void CommandList_add(CommandList_T oCommandList, Pipeline_T oPipeline,
+	enum ListCondition eCondition, int iBackground)
+{
+	struct Element* psElements;
+
+	assert(oCommandList != NULL);
+	assert(oPipeline != NULL);
+
+	/* Grow geometrically, copying the elements over. */
+	if (oCommandList->uLength == oCommandList->uMaxLength)
+	{
+		psElements = (struct Element*)Arena_alloc(oCommandList->oArena,
+			sizeof(struct Element) * 2 * oCommandList->uMaxLength);
+		memcpy(psElements, oCommandList->psElements,
+			sizeof(struct Element) * oCommandList->uLength);
+		oCommandList->psElements = psElements;
+		oCommandList->uMaxLength *= 2;
+	}
+
+	oCommandList->psElements[oCommandList->uLength].oPipeline = 
+		oPipeline;
+	oCommandList->psElements[oCommandList->uLength].eCondition = 
+		eCondition;
+	oCommandList->psElements[oCommandList->uLength].iBackground = 
+		iBackground;
+	oCommandList->uLength++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Print a command list, oCommandList. */
+
+void CommandList_write(CommandList_T oCommandList)
+{
+	size_t ulIndex;
+	assert(oCommandList != NULL);
+
+	/* Print each pipeline, followed by the operator that ends it:
+	   "&" if it runs in the background, or else the one that joins
+	   it to the next. */
+	for (ulIndex = 0; ulIndex < oCommandList->uLength; ulIndex++)
+	{
+		Pipeline_write(oCommandList->psElements[ulIndex].oPipeline);
+		if (oCommandList->psElements[ulIndex].iBackground)
+			printf("Command list: &\n");
+		else if (ulIndex + 1 < oCommandList->uLength)
+		{
+			switch (oCommandList->psElements[ulIndex + 1].eCondition)
+			{
+				case RUN_ALWAYS: printf("Command list: ;\n"); break;
+				case RUN_IF_SUCCESS: printf("Command list: &&\n"); break;
+				case RUN_IF_FAILURE: printf("Command list: ||\n"); break;
+			}
+		}
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of pipelines of oCommandList. */
+
+size_t CommandList_getLength(CommandList_T oCommandList)
+{
+	assert(oCommandList != NULL);
+	return oCommandList->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th pipeline of oCommandList. */
+
+Pipeline_T CommandList_getPipeline(CommandList_T oCommandList, 
+	size_t uIndex)
+{
+	assert(oCommandList != NULL);
+	assert(uIndex < oCommandList->uLength);
+	return oCommandList->psElements[uIndex].oPipeline;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the condition under which the uIndex'th pipeline of
+   oCommandList runs. */
+
+enum ListCondition CommandList_getCondition(CommandList_T oCommandList,
+	size_t uIndex)
+{
+	assert(oCommandList != NULL);
+	assert(uIndex < oCommandList->uLength);
+	return oCommandList->psElements[uIndex].eCondition;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff the uIndex'th pipeline of oCommandList runs in the
+   background. */
+
+int CommandList_isBackground(CommandList_T oCommandList, size_t uIndex)
+{
+	assert(oCommandList != NULL);
+	assert(uIndex < oCommandList->uLength);
+	return oCommandList->psElements[uIndex].iBackground;
+}
@@ -0,0 +1,78 @@
+/*--------------------------------------------------------------------*/
+/* commandlist.h                                                      */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef COMMANDLIST_INCLUDED
+#define COMMANDLIST_INCLUDED
+
+#include "pipeline.h"
+#include "arena.h"
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+
+/* When a pipeline of a command list runs: always, as after ";" or at
+   the start of the list, or only if the exit status of the list so
+   far is zero, as after "&&", or nonzero, as after "||". */
+
+enum ListCondition {RUN_ALWAYS, RUN_IF_SUCCESS, RUN_IF_FAILURE};
+
+/*--------------------------------------------------------------------*/
+
+/* A command list is an object that contains a sequence of pipelines,
+   each with the condition under which it runs, and whether it runs
+   in the background, as when it ends with "&". */
+
+typedef struct CommandList* CommandList_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Returns a new, empty command list object, allocated from oArena. */
+
+CommandList_T CommandList_new(Arena_T oArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Add to the end of oCommandList the pipeline oPipeline, which runs
+   under condition eCondition, in the background if iBackground is
+   TRUE. The list grows in memory from the arena of oCommandList. */
+
+void CommandList_add(CommandList_T oCommandList, Pipeline_T oPipeline,
+	enum ListCondition eCondition, int iBackground);
+
+/*--------------------------------------------------------------------*/
+
+/* Print a command list, oCommandList. */
+
+void CommandList_write(CommandList_T oCommandList);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of pipelines of oCommandList. */
+
+size_t CommandList_getLength(CommandList_T oCommandList);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th pipeline of oCommandList. */
+
+Pipeline_T CommandList_getPipeline(CommandList_T oCommandList, 
+	size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the condition under which the uIndex'th pipeline of
+   oCommandList runs. */
+
+enum ListCondition CommandList_getCondition(CommandList_T oCommandList,
+	size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff the uIndex'th pipeline of oCommandList runs in the
+   background. */
+
+int CommandList_isBackground(CommandList_T oCommandList, size_t uIndex);
+
+#endif
@@ -0,0 +1,437 @@
+/*--------------------------------------------------------------------*/
+/* dircache.c                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "dircache.h"
+#include "hashtable.h"
+#include "ish.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/*--------------------------------------------------------------------*/
+
+enum {FALSE, TRUE};
+
+/*--------------------------------------------------------------------*/
+
+/* The size of the buffer that getdents64() fills, and the number of
+   bytes of names that a Listing first has room for. */
+
+enum {DIRENT_BUFFER_SIZE = 32768, INITIAL_NAMES_SIZE = 1024};
+
+/* The most Listings that a DirCache keeps, and the most bytes of
+   names that they may hold together. Past either, the Listing used
+   least recently is dropped. */
+
+enum {MAX_LISTINGS = 64, MAX_NAMES_SIZE = 4 * 1024 * 1024};
+
+/*--------------------------------------------------------------------*/
+
+/* A directory entry as getdents64() returns it. */
+
+struct Dirent64
+{
+   uint64_t uIno;
+   int64_t iOff;
+   unsigned short usRecLen;
+   unsigned char ucType;
+   char acName[];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Listing is the names in one directory, as they were when it was
+   read. */
+
+struct Listing
+{
+   /* The link that chains the Listing into its bucket, or into the
+      list of those read again. */
+   struct HashLink sLink;
+
+   /* The path of the directory. */
+   char *pcDir;
+
+   /* The device, inode and modification time of the directory when
+      it was read, and whether it may have changed in the same clock
+      tick afterwards, unseen in its modification time. */
+   dev_t iDev;
+   ino_t iIno;
+   struct timespec sMtime;
+   int iRacy;
+
+   /* The names, each followed by a null character, in one block,
+      the size of the block, and the sorted DynArray of them. */
+   char *pcNames;
+   size_t uNamesSize;
+   DynArray_T oNames;
+
+   /* The value of the use count of the DirCache when the Listing was
+      last used. */
+   unsigned long ulLastUse;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A DirCache is a hash table of Listings. */
+
+struct DirCache
+{
+   /* The Listings, by directory. */
+   HashTable_T oListings;
+
+   /* The Listings replaced by reading their directories again, or
+      dropped to make room, whose names may still be in use. */
+   struct HashLink *psReleased;
+
+   /* The number of calls of DirCache_list() so far, and the size of
+      the names of the Listings in oListings. */
+   unsigned long ulUses;
+   size_t uNamesSize;
+
+   /* The buffer that getdents64() fills. */
+   char *pcBuffer;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pointer to the link in oDirCache that points to the
+   Listing for pcDir, or to the NULL link at the end of its bucket if
+   there is none. uHash is the hash code of pcDir. */
+
+static struct HashLink **DirCache_find(DirCache_T oDirCache,
+   const char *pcDir, size_t uHash)
+{
+   struct HashLink **ppsLink;
+
+   ppsLink = HashTable_getBucket(oDirCache->oListings, uHash);
+   while ((*ppsLink != NULL) &&
+          (((*ppsLink)->uHash != uHash) ||
+           (strcmp(((struct Listing*)*ppsLink)->pcDir, pcDir) != 0)))
+      ppsLink = &(*ppsLink)->psNext;
+   return ppsLink;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the Listing whose link is psLink, and its names. pvExtra is
+   unused. */
+
+static void DirCache_freeListing(struct HashLink *psLink,
+   void *pvExtra)
+{
+   struct Listing *psListing = (struct Listing*)psLink;
+
+   (void)pvExtra;
+
+   DynArray_free(psListing->oNames);
+   free(psListing->pcNames);
+   free(psListing->pcDir);
+   free(psListing);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the names pvName1 and pvName2 as strcmp() does. */
+
+static int DirCache_compare(const void *pvName1, const void *pvName2)
+{
+   return strcmp((const char*)pvName1, (const char*)pvName2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the names in the directory open as iFd into psListing, with
+   pcBuffer for getdents64(), and sort them. Return TRUE if
+   successful, or FALSE with errno set if the directory cannot be
+   read. */
+
+static int DirCache_readNames(struct Listing *psListing, int iFd,
+   char *pcBuffer)
+{
+   struct Dirent64 *psDirent;
+   char *pcNames;
+   size_t uNamesLength = 0;
+   size_t uNamesSize = INITIAL_NAMES_SIZE;
+   size_t uNameLength;
+   size_t uCount = 0;
+   size_t u;
+   long lRead;
+   long lOffset;
+
+   psListing->pcNames = (char*)malloc(uNamesSize);
+   if (psListing->pcNames == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   /* Copy the names into one block, each after the last. */
+   while ((lRead = syscall(SYS_getdents64, iFd, pcBuffer,
+      DIRENT_BUFFER_SIZE)) > 0)
+      for (lOffset = 0; lOffset < lRead; lOffset += psDirent->usRecLen)
+      {
+         psDirent = (struct Dirent64*)(pcBuffer + lOffset);
+         if ((strcmp(psDirent->acName, ".") == 0) ||
+             (strcmp(psDirent->acName, "..") == 0))
+            continue;
+         uNameLength = strlen(psDirent->acName);
+         if (uNamesLength + uNameLength + 1 > uNamesSize)
+         {
+            while (uNamesLength + uNameLength + 1 > uNamesSize)
+               uNamesSize *= 2;
+            pcNames = (char*)realloc(psListing->pcNames, uNamesSize);
+            if (pcNames == NULL)
+               {perror(pcPgmName); exit(EXIT_FAILURE);}
+            psListing->pcNames = pcNames;
+         }
+         memcpy(psListing->pcNames + uNamesLength, psDirent->acName,
+            uNameLength + 1);
+         uNamesLength += uNameLength + 1;
+         uCount++;
+      }
+   if (lRead == -1)
+   {
+      free(psListing->pcNames);
+      return FALSE;
+   }
+   psListing->uNamesSize = uNamesSize;
+
+   /* Point to them once the block no longer moves. */
+   psListing->oNames = DynArray_new(uCount);
+   if (psListing->oNames == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   pcNames = psListing->pcNames;
+   for (u = 0; u < uCount; u++)
+   {
+      (void)DynArray_set(psListing->oNames, u, pcNames);
+      pcNames += strlen(pcNames) + 1;
+   }
+   DynArray_sort(psListing->oNames, DirCache_compare);
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Listing of the directory pcDir, or NULL with errno
+   set if it cannot be read. */
+
+static struct Listing *DirCache_read(DirCache_T oDirCache,
+   const char *pcDir)
+{
+   struct Listing *psListing;
+   struct stat sStat;
+   struct timespec sNow;
+   int iFd;
+   int iErrno;
+
+   iFd = open(pcDir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (iFd == -1)
+      return NULL;
+
+   psListing = (struct Listing*)malloc(sizeof(struct Listing));
+   if (psListing == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   /* The time is taken before reading, so a change made during the
+      read shows in a later time. */
+   if ((fstat(iFd, &sStat) == -1) ||
+       (! DirCache_readNames(psListing, iFd, oDirCache->pcBuffer)))
+   {
+      iErrno = errno;
+      close(iFd);
+      free(psListing);
+      errno = iErrno;
+      return NULL;
+   }
+   close(iFd);
+
+   psListing->pcDir = (char*)malloc(strlen(pcDir) + 1);
+   if (psListing->pcDir == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   strcpy(psListing->pcDir, pcDir);
+   psListing->iDev = sStat.st_dev;
+   psListing->iIno = sStat.st_ino;
+   psListing->sMtime = sStat.st_mtim;
+
+   /* Modification times come from the coarse clock. A directory
+      changed no earlier than the tick it was read in could be
+      changed again without a new time, so it is read again. */
+   psListing->iRacy = TRUE;
+   if (clock_gettime(CLOCK_REALTIME_COARSE, &sNow) == 0)
+      psListing->iRacy = (sStat.st_mtim.tv_sec > sNow.tv_sec) ||
+         ((sStat.st_mtim.tv_sec == sNow.tv_sec) &&
+          (sStat.st_mtim.tv_nsec >= sNow.tv_nsec));
+   return psListing;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If the Listing whose link is psLink was used less recently than
+   the Listing at *pvOldest, or *pvOldest is NULL, store it there. */
+
+static void DirCache_findOldest(struct HashLink *psLink,
+   void *pvOldest)
+{
+   struct Listing *psListing = (struct Listing*)psLink;
+   struct Listing **ppsOldest = (struct Listing**)pvOldest;
+
+   if ((*ppsOldest == NULL) ||
+       (psListing->ulLastUse < (*ppsOldest)->ulLastUse))
+      *ppsOldest = psListing;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Drop the Listings of oDirCache used least recently until there is
+   room for one more, whose names take uNamesSize bytes. Their names
+   may still be in use until DirCache_release(). */
+
+static void DirCache_makeRoom(DirCache_T oDirCache, size_t uNamesSize)
+{
+   struct HashLink **ppsLink;
+   struct Listing *psOldest;
+
+   while ((HashTable_getLength(oDirCache->oListings) >= MAX_LISTINGS) ||
+          ((HashTable_getLength(oDirCache->oListings) > 0) &&
+           (oDirCache->uNamesSize + uNamesSize > MAX_NAMES_SIZE)))
+   {
+      psOldest = NULL;
+      HashTable_map(oDirCache->oListings, DirCache_findOldest,
+         &psOldest);
+      ppsLink = DirCache_find(oDirCache, psOldest->pcDir,
+         psOldest->sLink.uHash);
+      HashTable_remove(oDirCache->oListings, ppsLink);
+      oDirCache->uNamesSize -= psOldest->uNamesSize;
+      psOldest->sLink.psNext = oDirCache->psReleased;
+      oDirCache->psReleased = &psOldest->sLink;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty DirCache object, or NULL if insufficient
+   memory is available. */
+
+DirCache_T DirCache_new(void)
+{
+   DirCache_T oDirCache;
+
+   oDirCache = (struct DirCache*)calloc(1, sizeof(struct DirCache));
+   if (oDirCache == NULL)
+      return NULL;
+   oDirCache->oListings = HashTable_new();
+   oDirCache->pcBuffer = (char*)malloc(DIRENT_BUFFER_SIZE);
+   if ((oDirCache->oListings == NULL) || (oDirCache->pcBuffer == NULL))
+   {
+      HashTable_free(oDirCache->oListings);
+      free(oDirCache->pcBuffer);
+      free(oDirCache);
+      return NULL;
+   }
+   return oDirCache;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oDirCache, and the names that it holds. */
+
+void DirCache_free(DirCache_T oDirCache)
+{
+   if (oDirCache == NULL)
+      return;
+
+   DirCache_release(oDirCache);
+   HashTable_map(oDirCache->oListings, DirCache_freeListing, NULL);
+   HashTable_free(oDirCache->oListings);
+   free(oDirCache->pcBuffer);
+   free(oDirCache);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a DynArray of the names in directory pcDir, other than "."
+   and "..", sorted as by strcmp(), or NULL if the directory cannot
+   be read, with errno set. The directory is read only if oDirCache
+   has not read it since it last changed, or has forgotten it since.
+   oDirCache owns the DynArray and the names, which last until
+   DirCache_release() is called after the directory is read again or
+   forgotten, or until oDirCache is freed. */
+
+DynArray_T DirCache_list(DirCache_T oDirCache, const char *pcDir)
+{
+   struct HashLink **ppsLink;
+   struct HashLink *psOld;
+   struct Listing *psListing;
+   struct stat sStat;
+   size_t uHash;
+
+   assert(oDirCache != NULL);
+   assert(pcDir != NULL);
+
+   /* One stat() tells whether the names are still current. */
+   uHash = HashTable_hashString(pcDir);
+   ppsLink = DirCache_find(oDirCache, pcDir, uHash);
+   psListing = (struct Listing*)*ppsLink;
+   oDirCache->ulUses++;
+   if ((psListing != NULL) && (! psListing->iRacy) &&
+       (stat(pcDir, &sStat) == 0) &&
+       (sStat.st_dev == psListing->iDev) &&
+       (sStat.st_ino == psListing->iIno) &&
+       (sStat.st_mtim.tv_sec == psListing->sMtime.tv_sec) &&
+       (sStat.st_mtim.tv_nsec == psListing->sMtime.tv_nsec))
+   {
+      psListing->ulLastUse = oDirCache->ulUses;
+      return psListing->oNames;
+   }
+
+   psListing = DirCache_read(oDirCache, pcDir);
+   if (psListing == NULL)
+      return NULL;
+   psListing->ulLastUse = oDirCache->ulUses;
+
+   /* The old names may be in use until DirCache_release(). */
+   psOld = *ppsLink;
+   if (psOld != NULL)
+   {
+      HashTable_remove(oDirCache->oListings, ppsLink);
+      oDirCache->uNamesSize -= ((struct Listing*)psOld)->uNamesSize;
+      psOld->psNext = oDirCache->psReleased;
+      oDirCache->psReleased = psOld;
+   }
+
+   DirCache_makeRoom(oDirCache, psListing->uNamesSize);
+   HashTable_add(oDirCache->oListings, &psListing->sLink, uHash);
+   oDirCache->uNamesSize += psListing->uNamesSize;
+   return psListing->oNames;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the names of the directories in oDirCache that were read
+   again or forgotten since the last call, which are no longer in
+   use. */
+
+void DirCache_release(DirCache_T oDirCache)
+{
+   struct HashLink *psLink;
+   struct HashLink *psNext;
+
+   assert(oDirCache != NULL);
+
+   for (psLink = oDirCache->psReleased; psLink != NULL; psLink = psNext)
+   {
+      psNext = psLink->psNext;
+      DirCache_freeListing(psLink, NULL);
+   }
+   oDirCache->psReleased = NULL;
+}
@@ -0,0 +1,54 @@
+/*--------------------------------------------------------------------*/
+/* dircache.h                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef DIRCACHE_INCLUDED
+#define DIRCACHE_INCLUDED
+
+#include "dynarray.h"
+
+/*--------------------------------------------------------------------*/
+
+/* A DirCache object remembers the sorted names in each directory
+   that it has read, with the modification time of the directory, so
+   that a directory is read again only after it changes. It keeps a
+   bounded number of directories and names, and forgets those used
+   least recently first. */
+
+typedef struct DirCache *DirCache_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty DirCache object, or NULL if insufficient
+   memory is available. */
+
+DirCache_T DirCache_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oDirCache, and the names that it holds. */
+
+void DirCache_free(DirCache_T oDirCache);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a DynArray of the names in directory pcDir, other than "."
+   and "..", sorted as by strcmp(), or NULL if the directory cannot
+   be read, with errno set. The directory is read only if oDirCache
+   has not read it since it last changed, or has forgotten it since.
+   oDirCache owns the DynArray and the names, which last until
+   DirCache_release() is called after the directory is read again or
+   forgotten, or until oDirCache is freed. */
+
+DynArray_T DirCache_list(DirCache_T oDirCache, const char *pcDir);
+
+/*--------------------------------------------------------------------*/
+
+/* Free the names of the directories in oDirCache that were read
+   again or forgotten since the last call, which are no longer in
+   use. */
+
+void DirCache_release(DirCache_T oDirCache);
+
+#endif
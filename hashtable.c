@@ -0,0 +1,242 @@
+/*--------------------------------------------------------------------*/
+/* hashtable.c                                                        */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "hashtable.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of buckets that a new HashTable has, a power of 2. */
+
+enum {INITIAL_BUCKET_COUNT = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* A HashTable is an array of buckets, each a chain of HashLinks. */
+
+struct HashTable
+{
+   /* The buckets, the number of them, and the number of entries in
+      all of them. */
+   struct HashLink **ppsBuckets;
+   size_t uBucketCount;
+   size_t uLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for string pcKey. */
+
+size_t HashTable_hashString(const char *pcKey)
+{
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (; *pcKey != '\0'; pcKey++)
+      uHash = uHash * 65599 + (size_t)(unsigned char)*pcKey;
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for the uLength characters at pcKey, which need
+   not be terminated by a null character. It is the hash code of the
+   string of those characters. */
+
+size_t HashTable_hashChars(const char *pcKey, size_t uLength)
+{
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (; uLength > 0; pcKey++, uLength--)
+      uHash = uHash * 65599 + (size_t)(unsigned char)*pcKey;
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty HashTable object, or NULL if insufficient
+   memory is available. */
+
+HashTable_T HashTable_new(void)
+{
+   HashTable_T oHashTable;
+
+   oHashTable = (struct HashTable*)malloc(sizeof(struct HashTable));
+   if (oHashTable == NULL)
+      return NULL;
+   oHashTable->ppsBuckets = (struct HashLink**)
+      calloc(INITIAL_BUCKET_COUNT, sizeof(struct HashLink*));
+   if (oHashTable->ppsBuckets == NULL)
+   {
+      free(oHashTable);
+      return NULL;
+   }
+   oHashTable->uBucketCount = INITIAL_BUCKET_COUNT;
+   oHashTable->uLength = 0;
+   return oHashTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oHashTable, but not the entries that it holds. */
+
+void HashTable_free(HashTable_T oHashTable)
+{
+   if (oHashTable == NULL)
+      return;
+
+   free(oHashTable->ppsBuckets);
+   free(oHashTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of entries in oHashTable. */
+
+size_t HashTable_getLength(HashTable_T oHashTable)
+{
+   assert(oHashTable != NULL);
+
+   return oHashTable->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pointer to the link at the head of the bucket of
+   oHashTable in which an entry whose key has hash code uHash
+   belongs. Following psNext from there visits every such entry, and
+   others; compare uHash before the keys. The pointer lasts until an
+   entry is added. */
+
+struct HashLink **HashTable_getBucket(HashTable_T oHashTable,
+   size_t uHash)
+{
+   assert(oHashTable != NULL);
+
+   return &oHashTable->ppsBuckets[uHash & (oHashTable->uBucketCount - 1)];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the number of buckets of oHashTable, unless insufficient
+   memory is available. */
+
+static void HashTable_grow(HashTable_T oHashTable)
+{
+   struct HashLink **ppsBuckets;
+   struct HashLink *psLink;
+   struct HashLink *psNext;
+   size_t uBucketCount;
+   size_t uBucket;
+   size_t u;
+
+   assert(oHashTable != NULL);
+
+   uBucketCount = 2 * oHashTable->uBucketCount;
+   ppsBuckets = (struct HashLink**)
+      calloc(uBucketCount, sizeof(struct HashLink*));
+   if (ppsBuckets == NULL)
+      return;
+
+   for (u = 0; u < oHashTable->uBucketCount; u++)
+      for (psLink = oHashTable->ppsBuckets[u]; psLink != NULL;
+           psLink = psNext)
+      {
+         psNext = psLink->psNext;
+         uBucket = psLink->uHash & (uBucketCount - 1);
+         psLink->psNext = ppsBuckets[uBucket];
+         ppsBuckets[uBucket] = psLink;
+      }
+
+   free(oHashTable->ppsBuckets);
+   oHashTable->ppsBuckets = ppsBuckets;
+   oHashTable->uBucketCount = uBucketCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the entry whose HashLink is psLink, and whose key has hash code
+   uHash, to oHashTable. If the buckets cannot grow for lack of
+   memory, the chains grow longer instead. */
+
+void HashTable_add(HashTable_T oHashTable, struct HashLink *psLink,
+   size_t uHash)
+{
+   struct HashLink **ppsBucket;
+
+   assert(oHashTable != NULL);
+   assert(psLink != NULL);
+
+   ppsBucket = HashTable_getBucket(oHashTable, uHash);
+   psLink->uHash = uHash;
+   psLink->psNext = *ppsBucket;
+   *ppsBucket = psLink;
+
+   oHashTable->uLength++;
+   if (oHashTable->uLength > oHashTable->uBucketCount)
+      HashTable_grow(oHashTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove from oHashTable the entry that *ppsLink points to, where
+   ppsLink was reached from HashTable_getBucket(). */
+
+void HashTable_remove(HashTable_T oHashTable,
+   struct HashLink **ppsLink)
+{
+   assert(oHashTable != NULL);
+   assert(ppsLink != NULL);
+   assert(*ppsLink != NULL);
+
+   *ppsLink = (*ppsLink)->psNext;
+   oHashTable->uLength--;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each entry of oHashTable, passing
+   pvExtra as an extra argument.  That is, for each entry whose
+   HashLink is psLink, call (*pfApply)(psLink, pvExtra). *pfApply may
+   free the entry, but then must call HashTable_clear() afterwards. */
+
+void HashTable_map(HashTable_T oHashTable,
+   void (*pfApply)(struct HashLink *psLink, void *pvExtra),
+   const void *pvExtra)
+{
+   struct HashLink *psLink;
+   struct HashLink *psNext;
+   size_t u;
+
+   assert(oHashTable != NULL);
+   assert(pfApply != NULL);
+
+   for (u = 0; u < oHashTable->uBucketCount; u++)
+      for (psLink = oHashTable->ppsBuckets[u]; psLink != NULL;
+           psLink = psNext)
+      {
+         psNext = psLink->psNext;
+         (*pfApply)(psLink, (void*)pvExtra);
+      }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove every entry from oHashTable, without freeing them. */
+
+void HashTable_clear(HashTable_T oHashTable)
+{
+   size_t u;
+
+   assert(oHashTable != NULL);
+
+   for (u = 0; u < oHashTable->uBucketCount; u++)
+      oHashTable->ppsBuckets[u] = NULL;
+   oHashTable->uLength = 0;
+}
@@ -0,0 +1,113 @@
+/*--------------------------------------------------------------------*/
+/* hashtable.h                                                        */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef HASHTABLE_INCLUDED
+#define HASHTABLE_INCLUDED
+
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A HashTable object chains entries into buckets by the hash codes
+   of their keys, and doubles its buckets as it fills, so that chains
+   stay short however many entries it holds. It does not own the
+   entries, and knows nothing of their keys. */
+
+typedef struct HashTable *HashTable_T;
+
+/* A HashLink chains an entry of a HashTable into its bucket, and
+   holds the hash code of the entry's key, so that the table grows
+   without hashing the keys again. It is the first member of the
+   entry, so that a pointer to either one is a pointer to the
+   other. */
+
+struct HashLink
+{
+   /* The next entry in the same bucket, or NULL. */
+   struct HashLink *psNext;
+
+   /* The hash code of the key of the entry. */
+   size_t uHash;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for string pcKey. */
+
+size_t HashTable_hashString(const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for the uLength characters at pcKey, which need
+   not be terminated by a null character. It is the hash code of the
+   string of those characters. */
+
+size_t HashTable_hashChars(const char *pcKey, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty HashTable object, or NULL if insufficient
+   memory is available. */
+
+HashTable_T HashTable_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oHashTable, but not the entries that it holds. */
+
+void HashTable_free(HashTable_T oHashTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of entries in oHashTable. */
+
+size_t HashTable_getLength(HashTable_T oHashTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pointer to the link at the head of the bucket of
+   oHashTable in which an entry whose key has hash code uHash
+   belongs. Following psNext from there visits every such entry, and
+   others; compare uHash before the keys. The pointer lasts until an
+   entry is added. */
+
+struct HashLink **HashTable_getBucket(HashTable_T oHashTable,
+   size_t uHash);
+
+/*--------------------------------------------------------------------*/
+
+/* Add the entry whose HashLink is psLink, and whose key has hash code
+   uHash, to oHashTable. If the buckets cannot grow for lack of
+   memory, the chains grow longer instead. */
+
+void HashTable_add(HashTable_T oHashTable, struct HashLink *psLink,
+   size_t uHash);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove from oHashTable the entry that *ppsLink points to, where
+   ppsLink was reached from HashTable_getBucket(). */
+
+void HashTable_remove(HashTable_T oHashTable,
+   struct HashLink **ppsLink);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each entry of oHashTable, passing
+   pvExtra as an extra argument.  That is, for each entry whose
+   HashLink is psLink, call (*pfApply)(psLink, pvExtra). *pfApply may
+   free the entry, but then must call HashTable_clear() afterwards. */
+
+void HashTable_map(HashTable_T oHashTable,
+   void (*pfApply)(struct HashLink *psLink, void *pvExtra),
+   const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove every entry from oHashTable, without freeing them. */
+
+void HashTable_clear(HashTable_T oHashTable);
+
+#endif
@@ -5,267 +5,3662 @@
 
 #define _GNU_SOURCE
 
-#include "dynarray.h"
+#include "arena.h"
 #include "token.h"
 #include "linereader.h"
 #include "lexdfa.h"
 #include "command.h"
+#include "pipeline.h"
+#include "commandlist.h"
+#include "pathcache.h"
+#include "builtintable.h"
+#include "vartable.h"
+#include "dircache.h"
+#include "jobtable.h"
+#include "scheduler.h"
+#include "remote.h"
+#include "dynarray.h"
 #include "synAnalyze.h"
 #include "ish.h"
 #include <assert.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <spawn.h>
+#include <sys/signalfd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <poll.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/prctl.h>
+
+/*--------------------------------------------------------------------*/
+
+enum {FALSE, TRUE};
 
 /*--------------------------------------------------------------------*/
 
 /* The name of the executable binary file. */
 const char* pcPgmName;
 
+/* The shell that runs an executable file that is not a program, as
+   execvp() would. */
+static const char SCRIPT_SHELL[] = "/bin/sh";
+
+/* The reader of the shell's input: standard input, the script file
+   given with -f, or the socket of a session, if any. */
+static LineReader_T oInputReader;
+
+/* Where each external command was found in PATH. */
+static PathCache_T oPathCache;
+
+/* The builtin commands, those of the shell and those that enable
+   loaded. */
+static BuiltinTable_T oBuiltinTable;
+
+/* The environment variables, which environ holds as
+   VarTable_getEnvp() built them, except while a builtin command with
+   assignments runs. */
+static VarTable_T oVarTable = NULL;
+
+/* The names in the directories that patterns of file names were
+   matched in. */
+static DirCache_T oDirCache;
+
+/* The "name=value" assignments of the builtin command running in the
+   shell, which hold for it alone, or NULL if it has none. */
+static char** ppcBuiltinAssigns = NULL;
+
+/* Whether to run every command with fork(), rather than spawning
+   external commands with posix_spawn(). */
+static int iForkOnly = FALSE;
+
+/* The exit status of the last pipeline that ran. */
+static int iLastStatus = 0;
+
+/* Whether the shell prompts for, echoes and reports on its input. */
+static int iInteractive = -1;
+
+/* The jobs running in the background. */
+static JobTable_T oJobTable;
+
+/* The signal mask of the shell when it started, which its children
+   get back; the shell itself blocks SIGCHLD, and reads it from
+   iSigChldFd instead. */
+static sigset_t sOrigMask;
+static int iSigChldFd;
+
+/* The attributes of every spawned child: the original signal mask. */
+static posix_spawnattr_t sSpawnAttr;
+
+/* With -P, the lines of the script that are running at once, or else
+   NULL; the most lines that may run at once; and whether any line
+   has started since the last barrier. */
+static Scheduler_T oScheduler = NULL;
+static size_t uSchedulerWindow;
+static int iScheduled = FALSE;
+
+/*--------------------------------------------------------------------*/
+
+/* The parallel builtin runs its jobs as executePipeline() does. */
+
+static int executeParallel(int iArgc, char* ppcArgv[]);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the exit status that iWaitStatus, as stored by waitpid(),
+   describes: the status passed to exit(), or 128 plus the number of
+   the signal that killed the process. */
+
+static int getExitStatus(int iWaitStatus)
+{
+	if (WIFSIGNALED(iWaitStatus))
+		return 128 + WTERMSIG(iWaitStatus);
+	return WEXITSTATUS(iWaitStatus);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Reap the background jobs that have exited since the last call,
+   without blocking: only if a SIGCHLD has arrived on iSigChldFd,
+   collect every child that is done, and record its status in
+   oJobTable, or else in oScheduler. */
+
+static void reapJobs(void)
+{
+	struct signalfd_siginfo sInfo;
+	int iArrived = FALSE;
+	int iWaitStatus;
+	pid_t iPid;
+
+	/* The signals of several children may be merged into one. */
+	while (read(iSigChldFd, &sInfo, sizeof(sInfo)) == 
+		(ssize_t)sizeof(sInfo))
+		iArrived = TRUE;
+	if (! iArrived)
+		return;
+
+	while ((iPid = waitpid(-1, &iWaitStatus, WNOHANG)) > 0)
+		if ((! JobTable_setDone(oJobTable, iPid, 
+			getExitStatus(iWaitStatus))) && (oScheduler != NULL))
+			Scheduler_setDone(oScheduler, iPid, 
+				getExitStatus(iWaitStatus));
+}
+
 /*--------------------------------------------------------------------*/
 
-/* Redirects oCommand's commands to the proper files, both 
-   standard input and standard output. */
+/* Open the files to which oCommand redirects standard input and
+   standard output, closed on exec, and store their file descriptors
+   in *piStdIn and *piStdOut; leave either one unchanged if it is not
+   redirected. If a file cannot be opened, report the error, close
+   any file already opened, and return FALSE. Otherwise return
+   TRUE. */
 
-static void redirect(Command_T oCommand)
+static int openRedirections(Command_T oCommand, int* piStdIn, 
+	int* piStdOut)
 {
 	char* currStdin; 
 	char* currStdout; 
-	int fd;
-	int ret;
+	int iInFd = -1;
+	int iOutFd;
 
 	currStdin = Command_getStdIn(oCommand);
 	if (currStdin != NULL)
 	{
-		fd = open(currStdin, O_RDONLY);
-		if (fd == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
-
-		ret = close(0);
-		if (ret == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
-
-		ret = dup(fd);
-		if (ret == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
-
-		ret = close(fd);
-		if (ret == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+		iInFd = open(currStdin, O_RDONLY | O_CLOEXEC);
+		if (iInFd == -1) {perror(pcPgmName); return FALSE; }
 	}
 
 	currStdout = Command_getStdOut(oCommand);
-	fflush(stdout);
 	if (currStdout != NULL)
 	{
-		fd = creat(currStdout, 0600);
-		if (fd == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+		iOutFd = open(currStdout, 
+			O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+		if (iOutFd == -1) 
+		{
+			perror(pcPgmName); 
+			if (iInFd != -1) close(iInFd);
+			return FALSE;
+		}
+		*piStdOut = iOutFd;
+	}
 
-		ret = close(1);
-		if (ret == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	if (iInFd != -1) *piStdIn = iInFd;
+	return TRUE;
+}
 
-		ret = dup(fd);
-		if (ret == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+/*--------------------------------------------------------------------*/
+
+/* In a child process, redirect oCommand's commands to the proper
+   files, both standard input and standard output. Unless oCommand
+   redirects them to files, standard input comes from file descriptor
+   iStdIn and standard output goes to iStdOut, where -1 means the
+   shell's own. */
+
+static void redirect(Command_T oCommand, int iStdIn, int iStdOut)
+{
+	int ret;
+
+	if (! openRedirections(oCommand, &iStdIn, &iStdOut))
+		exit(EXIT_FAILURE);
 
-		ret = close(fd);
+	fflush(stdout);
+	if (iStdIn != -1)
+	{
+		ret = dup2(iStdIn, 0);
 		if (ret == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
 	}
+	if (iStdOut != -1)
+	{
+		ret = dup2(iStdOut, 1);
+		if (ret == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make oVarTable anew from the "name=value" strings of ppcEnv, which
+   may be NULL, and make environ the environment array that it
+   builds, so that children and getenv() see the same variables. */
+
+static void loadVariables(char** ppcEnv)
+{
+	static char* apcNoEnv[] = {NULL};
+	VarTable_T oNewVarTable;
+
+	oNewVarTable = VarTable_new((ppcEnv != NULL) ? ppcEnv : apcNoEnv);
+	if (oNewVarTable == NULL) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	VarTable_free(oVarTable);
+	oVarTable = oNewVarTable;
+
+	/* Let go of any environment array that setenv() built. */
+	clearenv();
+	environ = VarTable_getEnvp(oVarTable);
 }
 
 /*--------------------------------------------------------------------*/
 
-static void executeCommand(Command_T oCommand)
+/* Set the variable pcName to pcValue, or remove it if pcValue is
+   NULL, in oVarTable and so in environ. Commands are found anew in a
+   new PATH. */
+
+static void setVariable(const char* pcName, const char* pcValue)
 {
-	size_t ulArgumentCount;
-	pid_t iPid;
-	int iRet;
-	DynArray_T oArguments;
-	char** ppcArguments;
-	char* commandName;
-	char* HOME;
+	if (pcValue == NULL)
+		VarTable_unset(oVarTable, pcName);
+	else if (! VarTable_set(oVarTable, pcName, pcValue))
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+	environ = VarTable_getEnvp(oVarTable);
+
+	if (strcmp(pcName, "PATH") == 0)
+		PathCache_clear(oPathCache);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value of the variable pcName, as the last assignment
+   of ppcBuiltinAssigns to it sets it, or else as oVarTable holds it,
+   or NULL if it is not set. */
+
+static const char* getVariable(const char* pcName)
+{
+	const char* pcValue = NULL;
+	size_t uNameLength;
+	char** ppc;
+
+	uNameLength = strlen(pcName);
+	if (ppcBuiltinAssigns != NULL)
+		for (ppc = ppcBuiltinAssigns; *ppc != NULL; ppc++)
+			if ((strncmp(*ppc, pcName, uNameLength) == 0) &&
+				((*ppc)[uNameLength] == '='))
+				pcValue = *ppc + uNameLength + 1;
+	if (pcValue != NULL)
+		return pcValue;
+	return VarTable_get(oVarTable, pcName, uNameLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the environment array for oCommand: environ, with
+   oCommand's assignments put over it if it has any. Each set of
+   assignments is put over the variables once, while they stay
+   unchanged, however often a command with it runs. */
+
+static char** getEnvironment(Command_T oCommand)
+{
+	if (Command_getAssignCount(oCommand) == 0)
+		return environ;
+	return VarTable_getOverlay(oVarTable, 
+		Command_getAssignments(oCommand), 
+		Command_getAssignCount(oCommand));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff oCommand assigns PATH for itself, so that it must
+   be found in that PATH rather than through the PathCache. */
+
+static int assignsPath(Command_T oCommand)
+{
+	char** ppc;
+
+	for (ppc = Command_getAssignments(oCommand); *ppc != NULL; ppc++)
+		if (strncmp(*ppc, "PATH=", 5) == 0)
+			return TRUE;
+	return FALSE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff errno tells that a way of copying within the
+   kernel does not work for the file descriptors given, so that
+   another way might. */
 
-	/* Define dynarray of arguments. */
-	oArguments = Command_getArguments(oCommand);
-	ppcArguments = Command_getArgsArray(oCommand);
+static int isCopyUnsupported(void)
+{
+	return (errno == EINVAL) || (errno == ENOSYS) || 
+		(errno == EXDEV) || (errno == EBADF) || 
+		(errno == EOPNOTSUPP);
+}
+
+/*--------------------------------------------------------------------*/
 
-	/* Store number of elements in dynarray. */
-	if (oArguments == NULL) ulArgumentCount = 0;
-	else ulArgumentCount = DynArray_getLength(oArguments);
+/* Copy the rest of the file whose file descriptor is iFromFd to file
+   descriptor iToFd, within the kernel where it can: with
+   copy_file_range() from a regular file, else with sendfile() from a
+   file it can map, else with splice() to or from a pipe, and else
+   through a buffer. Return TRUE, or FALSE if the copy fails, with
+   errno set. */
 
-	/* Store command name. */
-	commandName = Command_getName(oCommand);
+static int copyFile(int iFromFd, int iToFd)
+{
+	char acBuffer[8192];
+	struct stat sStat;
+	ssize_t lCount = -1;
+	ssize_t lWritten;
+	ssize_t lRet;
 
-	/* Execute exit command. */
-	if (strcmp(commandName, "exit") == 0)
+	/* A file of /proc may be empty in size but not in content. */
+	if ((fstat(iFromFd, &sStat) == 0) && S_ISREG(sStat.st_mode) &&
+		(sStat.st_size > 0))
 	{
-		/* Free oCommand. */
-		exit(0);
+		while ((lCount = copy_file_range(iFromFd, NULL, iToFd, NULL,
+			1 << 30, 0)) > 0)
+			;
+		if (lCount == 0)
+			return TRUE;
+		if (! isCopyUnsupported())
+			return FALSE;
 	}
 
-	/* Execute setenv command. */
-	else if (strcmp(commandName, "setenv") == 0)
+	while ((lCount = sendfile(iToFd, iFromFd, NULL, 1 << 30)) > 0)
+		;
+	if (lCount == 0)
+		return TRUE;
+	if (! isCopyUnsupported())
+		return FALSE;
+
+	while ((lCount = splice(iFromFd, NULL, iToFd, NULL, 1 << 30, 
+		SPLICE_F_MOVE)) > 0)
+		;
+	if (lCount == 0)
+		return TRUE;
+	if (! isCopyUnsupported())
+		return FALSE;
+
+	while ((lCount = read(iFromFd, acBuffer, sizeof(acBuffer))) > 0)
 	{
-		/* Ensure not to few aruments.. */
-		if (ulArgumentCount == 0)
+		for (lWritten = 0; lWritten < lCount; lWritten += lRet)
 		{
-			fprintf(stderr, "%s: missing variable\n", pcPgmName);
+			lRet = write(iToFd, acBuffer + lWritten, 
+				(size_t)(lCount - lWritten));
+			if (lRet == -1)
+				return FALSE;
 		}
+	}
+	return lCount == 0;
+}
 
-		/* ...or too many. */
-		else if (ulArgumentCount > 2)
-		{
-			fprintf(stderr, "%s: too many arguments\n", pcPgmName);
-		}
+/*--------------------------------------------------------------------*/
 
-		/* Execute with empty string as value if only 1 arg. */
-		else if (ulArgumentCount == 1)
-		{
-			setenv(DynArray_get(oArguments, 0), "", 1);
-		}
+/* The output of a builtin command, gathered so that the command
+   writes it to standard output with as few calls to write() as
+   possible. */
 
-		/* Otherwise, execute with additional argument. */
-		else
-		{
-			setenv(DynArray_get(oArguments, 0), 
-				   DynArray_get(oArguments, 1), 1);
-		}
-	}
+enum {OUTPUT_SIZE = 4096};
+
+struct Output
+{
+	/* The number of bytes in acBuffer. */
+	size_t ulLength;
+
+	/* Whether a write() has failed. */
+	int iFailed;
+
+	char acBuffer[OUTPUT_SIZE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Write the bytes in psOutput's buffer to standard output, and empty
+   the buffer. */
+
+static void flushOutput(struct Output* psOutput)
+{
+	size_t ulWritten = 0;
+	ssize_t lCount;
 
-	/* Execute unsetenv command. */
-	else if (strcmp(commandName, "unsetenv") == 0)
+	/* Whatever the shell itself printed comes first. */
+	fflush(stdout);
+	while ((ulWritten < psOutput->ulLength) && (! psOutput->iFailed))
 	{
-		/* Ensure not missing variables... */
-		if (ulArgumentCount < 1)
+		lCount = write(1, psOutput->acBuffer + ulWritten,
+			psOutput->ulLength - ulWritten);
+		if (lCount == -1)
 		{
-			fprintf(stderr, "%s: missing variable\n", pcPgmName);
+			if (errno == EINTR) continue;
+			perror(pcPgmName);
+			psOutput->iFailed = TRUE;
 		}
+		else ulWritten += (size_t)lCount;
+	}
+	psOutput->ulLength = 0;
+}
 
-		/* ...or too many variables. */
-		else if (ulArgumentCount > 1)
-		{
-			fprintf(stderr, "%s: too many arguments\n", pcPgmName);
-		}
+/*--------------------------------------------------------------------*/
 
-		/* Otherwise, execute unsetenv. */
-		else unsetenv(DynArray_get(oArguments, 0));
-	}
+/* Add the ulLength bytes at pcBytes to psOutput, writing the buffer
+   whenever it fills. */
 
-	/* Execute cd commands. */
-	else if (strcmp(commandName, "cd") == 0)
+static void addOutput(struct Output* psOutput, const char* pcBytes,
+	size_t ulLength)
+{
+	size_t ulCount;
+
+	while (ulLength > 0)
 	{
+		if (psOutput->ulLength == OUTPUT_SIZE)
+			flushOutput(psOutput);
+		ulCount = OUTPUT_SIZE - psOutput->ulLength;
+		if (ulCount > ulLength) ulCount = ulLength;
+		memcpy(psOutput->acBuffer + psOutput->ulLength, pcBytes, 
+			ulCount);
+		psOutput->ulLength += ulCount;
+		pcBytes += ulCount;
+		ulLength -= ulCount;
+	}
+}
 
-		/* Make sure there aren't too many args... */
-		if (ulArgumentCount > 1)
-		{
-			fprintf(stderr, 
-					"%s: too many arguments\n",
-					pcPgmName);
-		}
+/*--------------------------------------------------------------------*/
 
-		/* ...and that if there are zero args that HOME is set. */
-		else if (ulArgumentCount == 0)
-		{
-			HOME = getenv("HOME");
-			if (HOME != NULL)
+/* Add the string pcString to psOutput. */
+
+static void addString(struct Output* psOutput, const char* pcString)
+{
+	addOutput(psOutput, pcString, strlen(pcString));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the escape sequence that starts after the backslash at
+   *ppcString to psOutput, and advance *ppcString past it. Octal
+   escapes are \0NNN if iZeroOctal is TRUE, as in echo and %b, and
+   \NNN otherwise, as in printf formats. Return FALSE iff the
+   sequence is \c, which ends all output. */
+
+static int addEscape(struct Output* psOutput, const char** ppcString,
+	int iZeroOctal)
+{
+	const char* pc = *ppcString;
+	const char* pcTo;
+	int iValue = 0;
+	int iDigits;
+	char c;
+
+	switch (*pc)
+	{
+		case 'a': c = '\a'; pc++; break;
+		case 'b': c = '\b'; pc++; break;
+		case 'f': c = '\f'; pc++; break;
+		case 'n': c = '\n'; pc++; break;
+		case 'r': c = '\r'; pc++; break;
+		case 't': c = '\t'; pc++; break;
+		case 'v': c = '\v'; pc++; break;
+		case '\\': c = '\\'; pc++; break;
+		case 'c': *ppcString = pc + 1; return FALSE;
+		case 'x':
+			for (pcTo = pc + 1, iDigits = 0; iDigits < 2; iDigits++)
 			{
-				chdir(HOME);
+				if ((*pcTo >= '0') && (*pcTo <= '9'))
+					iValue = iValue * 16 + (*pcTo - '0');
+				else if ((*pcTo >= 'a') && (*pcTo <= 'f'))
+					iValue = iValue * 16 + (*pcTo - 'a' + 10);
+				else if ((*pcTo >= 'A') && (*pcTo <= 'F'))
+					iValue = iValue * 16 + (*pcTo - 'A' + 10);
+				else break;
+				pcTo++;
 			}
-			else 
+			if (iDigits == 0) {c = '\\'; break; }
+			c = (char)iValue;
+			pc = pcTo;
+			break;
+		default:
+			if ((*pc < '0') || (*pc > '7') ||
+				(iZeroOctal && (*pc != '0')))
 			{
-				fprintf(stderr, 
-					"%s: HOME environemnt variable not set\n",
-					pcPgmName);
+				c = '\\';
+				break;
 			}
+			if (iZeroOctal) pc++;
+			for (iDigits = 0; iDigits < 3; iDigits++)
+			{
+				if ((*pc < '0') || (*pc > '7')) break;
+				iValue = iValue * 8 + (*pc - '0');
+				pc++;
+			}
+			c = (char)iValue;
+			break;
+	}
+	addOutput(psOutput, &c, 1);
+	*ppcString = pc;
+	return TRUE;
+}
 
-		}
+/*--------------------------------------------------------------------*/
 
-		/* Otherwise, call change directory. */
-		else
+/* Add pcString to psOutput, with the escape sequences of echo -e in
+   it replaced as addEscape() replaces them. Return FALSE iff pcString
+   contains \c. */
+
+static int addEscapedString(struct Output* psOutput, const char* pcString)
+{
+	const char* pcBackslash;
+
+	while ((pcBackslash = strchr(pcString, '\\')) != NULL)
+	{
+		addOutput(psOutput, pcString, 
+			(size_t)(pcBackslash - pcString));
+		pcString = pcBackslash + 1;
+		if (! addEscape(psOutput, &pcString, TRUE))
+			return FALSE;
+	}
+	addString(psOutput, pcString);
+	return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the echo builtin command: write its arguments,
+   separated by spaces, and a newline. Leading arguments made of -n,
+   -e and -E leave out the newline, replace escape sequences, and
+   keep them, as in /bin/echo. Return the exit status. */
+
+static int executeEcho(int iArgc, char* ppcArgv[])
+{
+	struct Output sOutput;
+	size_t ulArgumentCount;
+	size_t ulIndex;
+	const char* pcArg;
+	const char* pc;
+	int iNewline = TRUE;
+	int iEscapes = FALSE;
+
+	ulArgumentCount = (size_t)iArgc - 1;
+	sOutput.ulLength = 0;
+	sOutput.iFailed = FALSE;
+
+	/* Read the options. */
+	for (ulIndex = 0; ulIndex < ulArgumentCount; ulIndex++)
+	{
+		pcArg = ppcArgv[ulIndex + 1];
+		if ((pcArg[0] != '-') || (pcArg[1] == '\0')) break;
+		for (pc = pcArg + 1; *pc != '\0'; pc++)
+			if ((*pc != 'n') && (*pc != 'e') && (*pc != 'E'))
+				break;
+		if (*pc != '\0') break;
+		for (pc = pcArg + 1; *pc != '\0'; pc++)
 		{
-			chdir(DynArray_get(oArguments, 0));
+			if (*pc == 'n') iNewline = FALSE;
+			else iEscapes = (*pc == 'e');
 		}
 	}
 
-	/* Otherwise, the command is external. */
-	else
+	for (; ulIndex < ulArgumentCount; ulIndex++)
 	{
+		pcArg = ppcArgv[ulIndex + 1];
+		if (! iEscapes)
+			addString(&sOutput, pcArg);
+		else if (! addEscapedString(&sOutput, pcArg))
+		{
+			iNewline = FALSE;
+			break;
+		}
+		if (ulIndex + 1 < ulArgumentCount)
+			addOutput(&sOutput, " ", 1);
+	}
+	if (iNewline) addOutput(&sOutput, "\n", 1);
 
-		iRet = fflush(stdin);
-		if (iRet == EOF) {perror(pcPgmName); exit(EXIT_FAILURE); }
-		iRet = fflush(stdout);
-		if (iRet == EOF) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	flushOutput(&sOutput);
+	return sOutput.iFailed;
+}
 
-		iPid = fork();
-		if (iPid == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+/*--------------------------------------------------------------------*/
 
-		if (iPid == 0)
-		{
-			/* Redirect if needed to stdin and stdout. */
-			redirect(oCommand);
+/* Execute the printenv builtin command: write the value of
+   each environment variable that it names, or every "name=value"
+   of the environment if it names none. Return 1 if a variable is
+   not set, and 0 otherwise. */
+
+static int executePrintenv(int iArgc, char* ppcArgv[])
+{
+	struct Output sOutput;
+	size_t ulArgumentCount;
+	size_t ulIndex;
+	const char* pcName;
+	const char* pcValue;
+	char** ppcVariable;
+	int iStatus = 0;
 
-			/* Execute external command. */
-			execvp(commandName, ppcArguments);
+	ulArgumentCount = (size_t)iArgc - 1;
+	sOutput.ulLength = 0;
+	sOutput.iFailed = FALSE;
 
-			fprintf(stderr, 
-				    "%s: No such file or directory\n", 
-				    pcPgmName);
-			exit(EXIT_FAILURE);
+	if (ulArgumentCount == 0)
+	{
+		for (ppcVariable = environ; *ppcVariable != NULL; ppcVariable++)
+		{
+			addString(&sOutput, *ppcVariable);
+			addOutput(&sOutput, "\n", 1);
 		}
-		iPid = wait(NULL);
-		if (iPid == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
 	}
-	Command_free(oCommand);
-	free(ppcArguments);
+
+	for (ulIndex = 0; ulIndex < ulArgumentCount; ulIndex++)
+	{
+		pcName = ppcArgv[ulIndex + 1];
+		pcValue = NULL;
+		if (strchr(pcName, '=') == NULL)
+			pcValue = getVariable(pcName);
+		if (pcValue == NULL)
+		{
+			iStatus = 1;
+			continue;
+		}
+		addString(&sOutput, pcValue);
+		addOutput(&sOutput, "\n", 1);
+	}
+
+	flushOutput(&sOutput);
+	return sOutput.iFailed ? 1 : iStatus;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Program main that returns an int. 
-   int argc is the number of arguments, *argv[] an array of the 
-   arguments. */
+/* Add to psOutput the conversion pcSpec, a printf() format with one
+   conversion, of the arguments that follow. */
 
-int main(int argc, char *argv[])
+static void addFormatted(struct Output* psOutput, const char* pcSpec, 
+	...)
 {
-	char *pcLine;
-	DynArray_T oTokens;
-	Command_T oCommand;
-	int iRet;
+	va_list ap;
+	char acBuffer[256];
+	char* pcBuffer = acBuffer;
+	int iLength;
 
-	pcPgmName = argv[0];
+	va_start(ap, pcSpec);
+	iLength = vsnprintf(acBuffer, sizeof(acBuffer), pcSpec, ap);
+	va_end(ap);
+	if (iLength < 0) return;
+
+	/* Format a long conversion again, into a buffer big enough. */
+	if ((size_t)iLength >= sizeof(acBuffer))
+	{
+		pcBuffer = (char*)malloc((size_t)iLength + 1);
+		if (pcBuffer == NULL) {perror(pcPgmName); exit(EXIT_FAILURE); }
+		va_start(ap, pcSpec);
+		vsnprintf(pcBuffer, (size_t)iLength + 1, pcSpec, ap);
+		va_end(ap);
+	}
+	addOutput(psOutput, pcBuffer, (size_t)iLength);
+	if (pcBuffer != acBuffer) free(pcBuffer);
+}
+
+/*--------------------------------------------------------------------*/
 
-    printf("%c ", '%');
+/* Write to stderr that pcArg, an argument of printf, is not a
+   number, if pcEnd, where reading it as one stopped, is not its
+   end. Set *piStatus to 1 if so. */
 
-    /* Continually analyze stdin. */
-	while((pcLine = LineReader_read(stdin)) != NULL)
+static void checkNumber(const char* pcArg, const char* pcEnd, 
+	int* piStatus)
+{
+	if ((*pcEnd != '\0') || (pcEnd == pcArg) || (errno != 0))
 	{
-		printf("%s\n", pcLine);
-		iRet = fflush(stdout);
-		if (iRet == EOF)
-			{perror(pcPgmName); exit(EXIT_FAILURE);}
+		*piStatus = 1;
+		fprintf(stderr, "%s: printf: %s: invalid number\n", 
+			pcPgmName, pcArg);
+	}
+}
 
-		/* Lex analyze. */
-		oTokens = LexDFA_lexLine(pcLine);
+/*--------------------------------------------------------------------*/
 
-		oCommand = NULL;
+/* Return the integer that pcArg, an argument of printf, stands for:
+   as strtoll() reads it, or the code of the character after a
+   leading quote. Set *piStatus to 1 if pcArg is not all a number. */
 
-		/* Make command is oTokens != NULL. */
-		if (oTokens != NULL)
-		{
-			oCommand = SynAnalyze_analyze(oTokens);
-			LexDFA_freeTokens(oTokens);
-			DynArray_free(oTokens);
-		}
+static long long getInteger(const char* pcArg, int* piStatus)
+{
+	char* pcEnd;
+	long long llValue;
 
-		/* Execute command if it is not null. */
-		if (oCommand != NULL)
-		{
-			executeCommand(oCommand);
-		}
+	if ((pcArg[0] == '\'') || (pcArg[0] == '"'))
+		return (long long)(unsigned char)pcArg[1];
+	errno = 0;
+	llValue = strtoll(pcArg, &pcEnd, 0);
+	checkNumber(pcArg, pcEnd, piStatus);
+	return llValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the floating point number that pcArg, an argument of
+   printf, stands for, as getInteger() does but with strtod(). */
+
+static double getDouble(const char* pcArg, int* piStatus)
+{
+	char* pcEnd;
+	double dValue;
+
+	if ((pcArg[0] == '\'') || (pcArg[0] == '"'))
+		return (double)(unsigned char)pcArg[1];
+	errno = 0;
+	dValue = strtod(pcArg, &pcEnd);
+	checkNumber(pcArg, pcEnd, piStatus);
+	return dValue;
+}
+
+/*--------------------------------------------------------------------*/
 
-		if (pcLine != NULL) free(pcLine);
-		printf("%c ", '%');
+/* Execute the printf builtin command: write its later
+   arguments as its first argument, the format, tells, and reuse the
+   format while arguments remain. The format takes the escape
+   sequences and the conversions of printf(1), %b among them; a
+   missing argument counts as an empty string or 0. Return the exit
+   status. */
+
+static int executePrintf(int iArgc, char* ppcArgv[])
+{
+	struct Output sOutput;
+	size_t ulArgumentCount;
+	size_t ulNext = 2;
+	size_t ulUsed;
+	const char* pcFormat;
+	const char* pc;
+	const char* pcArg;
+	char acSpec[32];
+	char acChar[2] = {'\0', '\0'};
+	long long llValue;
+	double dValue;
+	size_t ulSpecLength;
+	int iStatus = 0;
+	int iStar;
+	int iStarCount;
+	int aiStars[2];
+	int iDone = FALSE;
+	char cConversion;
+
+	ulArgumentCount = (size_t)iArgc - 1;
+	sOutput.ulLength = 0;
+	sOutput.iFailed = FALSE;
+	if (ulArgumentCount == 0)
+	{
+		fprintf(stderr, "%s: printf: missing format\n", pcPgmName);
+		return 1;
 	}
-	printf("\n");
+	pcFormat = ppcArgv[1];
+
+	do
+	{
+		ulUsed = ulNext;
+		pc = pcFormat;
+		while ((*pc != '\0') && (! iDone))
+		{
+			/* Copy plain text up to the next escape or
+			   conversion. */
+			if ((*pc != '\\') && (*pc != '%'))
+			{
+				ulSpecLength = strcspn(pc, "\\%");
+				addOutput(&sOutput, pc, ulSpecLength);
+				pc += ulSpecLength;
+				continue;
+			}
+			if (*pc == '\\')
+			{
+				pc++;
+				if (! addEscape(&sOutput, &pc, FALSE)) iDone = TRUE;
+				continue;
+			}
+			if (pc[1] == '%')
+			{
+				addOutput(&sOutput, "%", 1);
+				pc += 2;
+				continue;
+			}
+
+			/* Copy the flags, width and precision of the
+			   conversion, taking each * from an argument. */
+			ulSpecLength = 0;
+			iStarCount = 0;
+			acSpec[ulSpecLength++] = *pc++;
+			while ((*pc != '\0') && (strchr("-+ #0", *pc) != NULL) &&
+				(ulSpecLength < 8))
+				acSpec[ulSpecLength++] = *pc++;
+			for (iStar = 0; iStar < 2; iStar++)
+			{
+				if (iStar == 1)
+				{
+					if (*pc != '.') break;
+					acSpec[ulSpecLength++] = *pc++;
+				}
+				if (*pc == '*')
+				{
+					acSpec[ulSpecLength++] = *pc++;
+					pcArg = (ulNext <= ulArgumentCount) ?
+						ppcArgv[ulNext++] : "0";
+					aiStars[iStarCount++] = 
+						(int)getInteger(pcArg, &iStatus);
+				}
+				else
+					while ((*pc >= '0') && (*pc <= '9') &&
+						(ulSpecLength < 24))
+						acSpec[ulSpecLength++] = *pc++;
+			}
+
+			cConversion = *pc;
+			if ((cConversion == '\0') || 
+				(strchr("diouxXcsbeEfFgGaA", cConversion) == NULL))
+			{
+				fprintf(stderr, "%s: printf: %s: invalid conversion\n",
+					pcPgmName, pcFormat);
+				flushOutput(&sOutput);
+				return 1;
+			}
+			pc++;
+			pcArg = (ulNext <= ulArgumentCount) ?
+				ppcArgv[ulNext++] : NULL;
+
+			/* Integers convert as long long, and %c and %b as
+			   strings. */
+			if (strchr("diouxX", cConversion) != NULL)
+			{
+				acSpec[ulSpecLength++] = 'l';
+				acSpec[ulSpecLength++] = 'l';
+			}
+			acSpec[ulSpecLength++] = 
+				(strchr("cb", cConversion) != NULL) ? 's' : cConversion;
+			acSpec[ulSpecLength] = '\0';
+
+			if (cConversion == 'b')
+			{
+				if ((pcArg != NULL) && 
+					(! addEscapedString(&sOutput, pcArg)))
+					iDone = TRUE;
+			}
+			else if ((cConversion == 's') || (cConversion == 'c'))
+			{
+				if (pcArg == NULL) pcArg = "";
+				if (cConversion == 'c')
+				{
+					acChar[0] = pcArg[0];
+					pcArg = acChar;
+				}
+				if (iStarCount == 2)
+					addFormatted(&sOutput, acSpec, aiStars[0], 
+						aiStars[1], pcArg);
+				else if (iStarCount == 1)
+					addFormatted(&sOutput, acSpec, aiStars[0], pcArg);
+				else
+					addFormatted(&sOutput, acSpec, pcArg);
+			}
+			else if (strchr("diouxX", cConversion) != NULL)
+			{
+				llValue = (pcArg == NULL) ? 0 : 
+					getInteger(pcArg, &iStatus);
+				if (iStarCount == 2)
+					addFormatted(&sOutput, acSpec, aiStars[0], 
+						aiStars[1], llValue);
+				else if (iStarCount == 1)
+					addFormatted(&sOutput, acSpec, aiStars[0], llValue);
+				else
+					addFormatted(&sOutput, acSpec, llValue);
+			}
+			else
+			{
+				dValue = (pcArg == NULL) ? 0.0 : 
+					getDouble(pcArg, &iStatus);
+				if (iStarCount == 2)
+					addFormatted(&sOutput, acSpec, aiStars[0], 
+						aiStars[1], dValue);
+				else if (iStarCount == 1)
+					addFormatted(&sOutput, acSpec, aiStars[0], dValue);
+				else
+					addFormatted(&sOutput, acSpec, dValue);
+			}
+		}
+	}
+	while ((! iDone) && (ulNext <= ulArgumentCount) && 
+		(ulNext > ulUsed));
+
+	flushOutput(&sOutput);
+	return sOutput.iFailed ? 1 : iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the pwd builtin command: write the path of the working
+   directory. Return the exit status. */
+
+static int executePwd(int iArgc, char* ppcArgv[])
+{
+	struct Output sOutput;
+	char* pcPath;
+
+	(void)iArgc;
+	(void)ppcArgv;
+
+	pcPath = getcwd(NULL, 0);
+	if (pcPath == NULL) {perror(pcPgmName); return 1; }
+
+	sOutput.ulLength = 0;
+	sOutput.iFailed = FALSE;
+	addString(&sOutput, pcPath);
+	addOutput(&sOutput, "\n", 1);
+	free(pcPath);
+
+	flushOutput(&sOutput);
+	return sOutput.iFailed;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Each builtin command below runs as a BuiltinTable_Function: from
+   iArgc, the number of strings in ppcArgv before its NULL, and
+   ppcArgv, which holds the command name and its arguments. Each
+   returns the exit status of the command. */
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the exit builtin command: end the shell. */
+
+static int executeExit(int iArgc, char* ppcArgv[])
+{
+	(void)iArgc;
+	(void)ppcArgv;
+	exit(0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the setenv builtin command: set the environment variable
+   named by the first argument to the second, or to "" if there is
+   none. */
+
+static int executeSetenv(int iArgc, char* ppcArgv[])
+{
+	size_t ulArgumentCount = (size_t)iArgc - 1;
+
+	/* Ensure not to few aruments.. */
+	if (ulArgumentCount == 0)
+	{
+		fprintf(stderr, "%s: missing variable\n", pcPgmName);
+		return 1;
+	}
+
+	/* ...or too many. */
+	if (ulArgumentCount > 2)
+	{
+		fprintf(stderr, "%s: too many arguments\n", pcPgmName);
+		return 1;
+	}
+
+	/* ...or a name that environ cannot hold. */
+	if ((ppcArgv[1][0] == '\0') || (strchr(ppcArgv[1], '=') != NULL))
+	{
+		fprintf(stderr, "%s: invalid variable name\n", pcPgmName);
+		return 1;
+	}
+
+	/* Execute with empty string as value if only 1 arg. */
+	if (ulArgumentCount == 1)
+		setVariable(ppcArgv[1], "");
+
+	/* Otherwise, execute with additional argument. */
+	else
+		setVariable(ppcArgv[1], ppcArgv[2]);
+	return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the unsetenv builtin command: remove the environment
+   variable named by the argument. */
+
+static int executeUnsetenv(int iArgc, char* ppcArgv[])
+{
+	size_t ulArgumentCount = (size_t)iArgc - 1;
+
+	/* Ensure not missing variables... */
+	if (ulArgumentCount < 1)
+	{
+		fprintf(stderr, "%s: missing variable\n", pcPgmName);
+		return 1;
+	}
+
+	/* ...or too many variables. */
+	if (ulArgumentCount > 1)
+	{
+		fprintf(stderr, "%s: too many arguments\n", pcPgmName);
+		return 1;
+	}
+
+	/* Otherwise, execute unsetenv. */
+	setVariable(ppcArgv[1], NULL);
+	return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the hash builtin command: list the commands that
+   oPathCache remembers, forget them all with -r, or find and
+   remember each command named. */
+
+static int executeHash(int iArgc, char* ppcArgv[])
+{
+	size_t ulArgumentCount = (size_t)iArgc - 1;
+	size_t ulIndex;
+	int iStatus = 0;
+
+	/* With no arguments, list the remembered commands... */
+	if (ulArgumentCount == 0)
+	{
+		PathCache_write(oPathCache);
+	}
+
+	/* ...with -r, forget them... */
+	else if (strcmp(ppcArgv[1], "-r") == 0)
+	{
+		if (ulArgumentCount > 1)
+		{
+			iStatus = 1;
+			fprintf(stderr, "%s: too many arguments\n", pcPgmName);
+		}
+		else PathCache_clear(oPathCache);
+	}
+
+	/* ...and otherwise, find and remember each one named. */
+	else
+	{
+		for (ulIndex = 1; ulIndex <= ulArgumentCount; ulIndex++)
+		{
+			if (PathCache_lookup(oPathCache, ppcArgv[ulIndex]) == NULL)
+			{
+				iStatus = 1;
+				fprintf(stderr, "%s: %s: not found\n", pcPgmName,
+					ppcArgv[ulIndex]);
+			}
+		}
+	}
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the cd builtin command: change the working directory to
+   the one named by the argument, or to HOME if there is none. */
+
+static int executeCd(int iArgc, char* ppcArgv[])
+{
+	size_t ulArgumentCount = (size_t)iArgc - 1;
+	const char* HOME;
+
+	/* Make sure there aren't too many args... */
+	if (ulArgumentCount > 1)
+	{
+		fprintf(stderr, 
+				"%s: too many arguments\n",
+				pcPgmName);
+		return 1;
+	}
+
+	/* ...and that if there are zero args that HOME is set. */
+	if (ulArgumentCount == 0)
+	{
+		HOME = getVariable("HOME");
+		if (HOME == NULL)
+		{
+			fprintf(stderr, 
+				"%s: HOME environemnt variable not set\n",
+				pcPgmName);
+			return 1;
+		}
+		return (chdir(HOME) == -1) ? 1 : 0;
+	}
+
+	/* Otherwise, call change directory. */
+	return (chdir(ppcArgv[1]) == -1) ? 1 : 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the jobs builtin command: write the state of every job in
+   oJobTable. */
+
+static int executeJobs(int iArgc, char* ppcArgv[])
+{
+	(void)ppcArgv;
+	if (iArgc > 1)
+	{
+		fprintf(stderr, "%s: too many arguments\n", pcPgmName);
+		return 1;
+	}
+	reapJobs();
+	JobTable_write(oJobTable, FALSE);
+	return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the wait builtin command: wait for every job in
+   oJobTable, or for each process named, and return the exit status
+   of the last one named. */
+
+static int executeWait(int iArgc, char* ppcArgv[])
+{
+	int iIndex;
+	char* pcEnd;
+	pid_t iPid;
+	int iWaitStatus;
+	int iState;
+	int iStatus = 0;
+
+	/* With no arguments, wait for every job... */
+	if (iArgc == 1)
+	{
+		while ((iPid = JobTable_getRunning(oJobTable)) != -1)
+		{
+			if (waitpid(iPid, &iWaitStatus, 0) == -1)
+				iWaitStatus = 0;
+			JobTable_setDone(oJobTable, iPid, 
+				getExitStatus(iWaitStatus));
+		}
+	}
+
+	/* ...and otherwise, for each process named, keeping the
+	   exit status of the last. */
+	for (iIndex = 1; iIndex < iArgc; iIndex++)
+	{
+		iPid = (pid_t)strtol(ppcArgv[iIndex], &pcEnd, 10);
+		iState = -1;
+		if ((*pcEnd == '\0') && (pcEnd != ppcArgv[iIndex]))
+			iState = JobTable_getState(oJobTable, iPid, &iStatus);
+		if (iState == -1)
+		{
+			iStatus = EXIT_NOT_RUN;
+			fprintf(stderr, 
+				"%s: pid %s is not a child of this shell\n",
+				pcPgmName, ppcArgv[iIndex]);
+			continue;
+		}
+		if (iState == 1)
+		{
+			iStatus = 0;
+			if (waitpid(iPid, &iWaitStatus, 0) != -1)
+				iStatus = getExitStatus(iWaitStatus);
+			JobTable_setDone(oJobTable, iPid, iStatus);
+		}
+	}
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the true builtin command: succeed. */
+
+static int executeTrue(int iArgc, char* ppcArgv[])
+{
+	(void)iArgc;
+	(void)ppcArgv;
+	return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the false builtin command: fail. */
+
+static int executeFalse(int iArgc, char* ppcArgv[])
+{
+	(void)iArgc;
+	(void)ppcArgv;
+	return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stderr that the command named pcCommand failed on the
+   file pcFile, as errno tells, and return 1. */
+
+static int reportFileError(const char* pcCommand, const char* pcFile)
+{
+	fprintf(stderr, "%s: %s: %s: %s\n", pcPgmName, pcCommand, pcFile,
+		strerror(errno));
+	return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the cat builtin command: copy each file named, or standard
+   input if none is or the name is "-", to standard output, as
+   copyFile() copies. */
+
+static int executeCat(int iArgc, char* ppcArgv[])
+{
+	int iIndex = 1;
+	int iFd;
+	int iStatus = 0;
+
+	/* Whatever the shell itself printed comes first. */
+	fflush(stdout);
+
+	do
+	{
+		if ((iIndex == iArgc) || (strcmp(ppcArgv[iIndex], "-") == 0))
+		{
+			/* Read the shell's input from where the shell
+			   stopped. */
+			if (oInputReader != NULL) LineReader_sync(oInputReader);
+			if (! copyFile(0, 1))
+				iStatus = reportFileError(ppcArgv[0], "-");
+			continue;
+		}
+		iFd = open(ppcArgv[iIndex], O_RDONLY | O_CLOEXEC);
+		if (iFd == -1)
+		{
+			iStatus = reportFileError(ppcArgv[0], ppcArgv[iIndex]);
+			continue;
+		}
+		if (! copyFile(iFd, 1))
+			iStatus = reportFileError(ppcArgv[0], ppcArgv[iIndex]);
+		close(iFd);
+	}
+	while (++iIndex < iArgc);
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy the file at pcFrom to pcTo, or into pcTo with the same last
+   name if pcTo is a directory, as the cp builtin command named
+   pcCommand. Return 0, or 1 after reporting an error. */
+
+static int copyPath(const char* pcCommand, const char* pcFrom, 
+	const char* pcTo)
+{
+	struct stat sFromStat;
+	struct stat sToStat;
+	const char* pcBase;
+	char* pcPath = NULL;
+	int iFromFd;
+	int iToFd;
+	int iStatus = 0;
+
+	iFromFd = open(pcFrom, O_RDONLY | O_CLOEXEC);
+	if (iFromFd == -1)
+		return reportFileError(pcCommand, pcFrom);
+	if (fstat(iFromFd, &sFromStat) == -1)
+	{
+		close(iFromFd);
+		return reportFileError(pcCommand, pcFrom);
+	}
+	if (S_ISDIR(sFromStat.st_mode))
+	{
+		close(iFromFd);
+		errno = EISDIR;
+		return reportFileError(pcCommand, pcFrom);
+	}
+
+	/* A copy into a directory keeps the last part of the name. */
+	if ((stat(pcTo, &sToStat) == 0) && S_ISDIR(sToStat.st_mode))
+	{
+		pcBase = strrchr(pcFrom, '/');
+		pcBase = (pcBase == NULL) ? pcFrom : pcBase + 1;
+		pcPath = (char*)malloc(strlen(pcTo) + strlen(pcBase) + 2);
+		if (pcPath == NULL) {perror(pcPgmName); exit(EXIT_FAILURE); }
+		sprintf(pcPath, "%s/%s", pcTo, pcBase);
+		pcTo = pcPath;
+	}
+
+	/* Truncating a file copied onto itself would lose it. */
+	if ((stat(pcTo, &sToStat) == 0) && 
+		(sToStat.st_dev == sFromStat.st_dev) &&
+		(sToStat.st_ino == sFromStat.st_ino))
+	{
+		fprintf(stderr, "%s: %s: %s and %s are the same file\n",
+			pcPgmName, pcCommand, pcFrom, pcTo);
+		close(iFromFd);
+		free(pcPath);
+		return 1;
+	}
+
+	iToFd = open(pcTo, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+		sFromStat.st_mode & 0777);
+	if (iToFd == -1)
+		iStatus = reportFileError(pcCommand, pcTo);
+	else
+	{
+		if (! copyFile(iFromFd, iToFd))
+			iStatus = reportFileError(pcCommand, pcTo);
+		if ((close(iToFd) == -1) && (iStatus == 0))
+			iStatus = reportFileError(pcCommand, pcTo);
+	}
+	close(iFromFd);
+	free(pcPath);
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the cp builtin command, which is
+
+      cp source target
+      cp source... directory
+
+   Copy each source file to target, or into directory, as copyFile()
+   copies. */
+
+static int executeCp(int iArgc, char* ppcArgv[])
+{
+	struct stat sStat;
+	int iIndex;
+	int iStatus = 0;
+
+	if (iArgc < 3)
+	{
+		fprintf(stderr, "Usage: cp source target\n"
+			"       cp source... directory\n");
+		return 1;
+	}
+	if ((iArgc > 3) && ((stat(ppcArgv[iArgc - 1], &sStat) == -1) ||
+		(! S_ISDIR(sStat.st_mode))))
+	{
+		errno = ENOTDIR;
+		return reportFileError(ppcArgv[0], ppcArgv[iArgc - 1]);
+	}
+
+	for (iIndex = 1; iIndex < iArgc - 1; iIndex++)
+		if (copyPath(ppcArgv[0], ppcArgv[iIndex], ppcArgv[iArgc - 1]) 
+			!= 0)
+			iStatus = 1;
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the rm builtin command, which is
+
+      rm [-f] file...
+
+   Remove each file named. With -f, a file that does not exist is no
+   error. */
+
+static int executeRm(int iArgc, char* ppcArgv[])
+{
+	int iIndex = 1;
+	int iForce = FALSE;
+	int iStatus = 0;
+
+	if ((iArgc > 1) && (strcmp(ppcArgv[1], "-f") == 0))
+	{
+		iForce = TRUE;
+		iIndex++;
+	}
+	if ((iIndex == iArgc) && (! iForce))
+	{
+		fprintf(stderr, "Usage: rm [-f] file...\n");
+		return 1;
+	}
+
+	for (; iIndex < iArgc; iIndex++)
+		if ((unlink(ppcArgv[iIndex]) == -1) && 
+			((! iForce) || (errno != ENOENT)))
+			iStatus = reportFileError(ppcArgv[0], ppcArgv[iIndex]);
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make the directory pcPath, and with iParents, each missing
+   directory above it, with none an error if it exists already.
+   pcPath is changed meanwhile but put back. Return 0 on success, or
+   -1 with errno set. */
+
+static int makeDirectory(char* pcPath, int iParents)
+{
+	char* pcSlash;
+	struct stat sStat;
+
+	if (mkdir(pcPath, 0777) == 0)
+		return 0;
+	if (! iParents)
+		return -1;
+	if ((errno == EEXIST) && (stat(pcPath, &sStat) == 0) &&
+		S_ISDIR(sStat.st_mode))
+		return 0;
+	if (errno != ENOENT)
+		return -1;
+
+	/* Make the parent, and then try again. */
+	pcSlash = strrchr(pcPath, '/');
+	while ((pcSlash != NULL) && (pcSlash > pcPath) && 
+		(pcSlash[-1] == '/'))
+		pcSlash--;
+	if ((pcSlash == NULL) || (pcSlash == pcPath))
+		return -1;
+	*pcSlash = '\0';
+	if (makeDirectory(pcPath, TRUE) == -1)
+	{
+		*pcSlash = '/';
+		return -1;
+	}
+	*pcSlash = '/';
+	return ((mkdir(pcPath, 0777) == 0) || (errno == EEXIST)) ? 0 : -1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the mkdir builtin command, which is
+
+      mkdir [-p] directory...
+
+   Make each directory named; with -p, also each missing directory
+   above it, and none is an error if it exists already. */
+
+static int executeMkdir(int iArgc, char* ppcArgv[])
+{
+	int iIndex = 1;
+	int iParents = FALSE;
+	int iStatus = 0;
+
+	if ((iArgc > 1) && (strcmp(ppcArgv[1], "-p") == 0))
+	{
+		iParents = TRUE;
+		iIndex++;
+	}
+	if (iIndex == iArgc)
+	{
+		fprintf(stderr, "Usage: mkdir [-p] directory...\n");
+		return 1;
+	}
+
+	for (; iIndex < iArgc; iIndex++)
+		if (makeDirectory(ppcArgv[iIndex], iParents) == -1)
+			iStatus = reportFileError(ppcArgv[0], ppcArgv[iIndex]);
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the enable builtin command, which is
+
+      enable [-f library name...]
+
+   With -f, make each name a builtin command that the function
+   name_builtin in the shared object library executes, in the shell
+   itself. Otherwise list the builtin commands. */
+
+static int executeEnable(int iArgc, char* ppcArgv[])
+{
+	const char* pcMessage;
+	int iIndex;
+	int iStatus = 0;
+
+	if (iArgc == 1)
+	{
+		BuiltinTable_write(oBuiltinTable);
+		return 0;
+	}
+	if ((iArgc < 4) || (strcmp(ppcArgv[1], "-f") != 0))
+	{
+		fprintf(stderr, "Usage: enable [-f library name...]\n");
+		return 1;
+	}
+
+	for (iIndex = 3; iIndex < iArgc; iIndex++)
+	{
+		pcMessage = BuiltinTable_load(oBuiltinTable, ppcArgv[2], 
+			ppcArgv[iIndex]);
+		if (pcMessage != NULL)
+		{
+			iStatus = 1;
+			fprintf(stderr, "%s: enable: %s\n", pcPgmName, pcMessage);
+		}
+	}
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* How a command uses the files that its arguments name: in some way
+   that the scheduler cannot tell, or only by reading them, or by
+   writing them. */
+
+enum FileUse {FILES_UNKNOWN, FILES_READ, FILES_WRITE};
+
+/* A builtin command that is part of the shell: its name, its
+   function, how it uses the files that its arguments name, and the
+   options that it takes. Those that change the state of the shell
+   itself use files in an unknown way. pcOptions is NULL for one that
+   reads its own options; otherwise it holds the letters of the
+   options that it takes, each alone as its first argument, and a
+   command with any other option runs the external program of the
+   same name instead. */
+
+struct ShellBuiltin
+{
+	const char* pcName;
+	BuiltinTable_Function pfFunction;
+	enum FileUse eFileUse;
+	const char* pcOptions;
+};
+
+/* The builtin commands that are part of the shell. */
+
+static const struct ShellBuiltin asBuiltins[] =
+{
+	{"exit", executeExit, FILES_UNKNOWN, NULL},
+	{"setenv", executeSetenv, FILES_UNKNOWN, NULL},
+	{"unsetenv", executeUnsetenv, FILES_UNKNOWN, NULL},
+	{"hash", executeHash, FILES_UNKNOWN, NULL},
+	{"cd", executeCd, FILES_UNKNOWN, NULL},
+	{"jobs", executeJobs, FILES_UNKNOWN, NULL},
+	{"wait", executeWait, FILES_UNKNOWN, NULL},
+	{"parallel", executeParallel, FILES_UNKNOWN, NULL},
+	{"echo", executeEcho, FILES_READ, NULL},
+	{"pwd", executePwd, FILES_READ, NULL},
+	{"printenv", executePrintenv, FILES_READ, NULL},
+	{"printf", executePrintf, FILES_READ, NULL},
+	{"true", executeTrue, FILES_READ, NULL},
+	{"false", executeFalse, FILES_READ, NULL},
+	{"cat", executeCat, FILES_READ, ""},
+	{"cp", executeCp, FILES_WRITE, ""},
+	{"rm", executeRm, FILES_WRITE, "f"},
+	{"mkdir", executeMkdir, FILES_WRITE, "p"},
+	{"enable", executeEnable, FILES_UNKNOWN, NULL}
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entry of asBuiltins that oBuiltin, the builtin command
+   named pcName, executes, or NULL if enable has bound the name
+   anew. */
+
+static const struct ShellBuiltin* findShellBuiltin(Builtin_T oBuiltin,
+	const char* pcName)
+{
+	BuiltinTable_Function pfFunction;
+	size_t uIndex;
+
+	pfFunction = BuiltinTable_getFunction(oBuiltin);
+	for (uIndex = 0; uIndex < sizeof(asBuiltins) / sizeof(asBuiltins[0]);
+		uIndex++)
+		if ((asBuiltins[uIndex].pfFunction == pfFunction) &&
+			(strcmp(asBuiltins[uIndex].pcName, pcName) == 0))
+			return &asBuiltins[uIndex];
+	return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff the arguments of oCommand hold only the options
+   that psShellBuiltin takes, where it takes them. An argument "-"
+   is no option. */
+
+static int hasOnlyOptions(const struct ShellBuiltin* psShellBuiltin,
+	Command_T oCommand)
+{
+	size_t uArgCount;
+	size_t uArg;
+	const char* pcArg;
+
+	if (psShellBuiltin->pcOptions == NULL)
+		return TRUE;
+	uArgCount = Command_getArgCount(oCommand);
+	for (uArg = 0; uArg < uArgCount; uArg++)
+	{
+		pcArg = Command_getArg(oCommand, uArg);
+		if ((pcArg[0] != '-') || (pcArg[1] == '\0'))
+			continue;
+		if ((uArg > 0) || (pcArg[1] == '-') || (pcArg[2] != '\0') ||
+			(strchr(psShellBuiltin->pcOptions, pcArg[1]) == NULL))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entry of oBuiltinTable for oCommand's name, or NULL if
+   oCommand is external, or is a builtin command of the shell given an
+   option that the builtin does not take, so that the external
+   program runs instead. The name is looked up once, and oCommand
+   remembers the answer. */
+
+static Builtin_T getBuiltin(Command_T oCommand)
+{
+	Builtin_T oBuiltin;
+	const struct ShellBuiltin* psShellBuiltin;
+
+	if (! Command_isLookedUp(oCommand))
+	{
+		oBuiltin = BuiltinTable_lookup(oBuiltinTable, 
+			Command_getName(oCommand));
+		if (oBuiltin != NULL)
+		{
+			psShellBuiltin = findShellBuiltin(oBuiltin, 
+				Command_getName(oCommand));
+			if ((psShellBuiltin != NULL) && 
+				(! hasOnlyOptions(psShellBuiltin, oCommand)))
+				oBuiltin = NULL;
+		}
+		Command_setBuiltin(oCommand, oBuiltin);
+	}
+	return Command_getBuiltin(oCommand);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If oCommand is a builtin command, execute it in the current
+   process, store its exit status in *piStatus, and return TRUE.
+   Otherwise return FALSE. */
+
+static int executeBuiltin(Command_T oCommand, int* piStatus)
+{
+	Builtin_T oBuiltin;
+
+	oBuiltin = getBuiltin(oCommand);
+	if (oBuiltin == NULL)
+		return FALSE;
+	if (Command_getAssignCount(oCommand) == 0)
+	{
+		*piStatus = BuiltinTable_execute(oBuiltin, 
+			(int)Command_getArgCount(oCommand) + 1, 
+			Command_getArgsArray(oCommand));
+		return TRUE;
+	}
+
+	/* The assignments hold while the command runs, and for the
+	   commands it starts. */
+	environ = getEnvironment(oCommand);
+	ppcBuiltinAssigns = Command_getAssignments(oCommand);
+	*piStatus = BuiltinTable_execute(oBuiltin, 
+		(int)Command_getArgCount(oCommand) + 1, 
+		Command_getArgsArray(oCommand));
+	ppcBuiltinAssigns = NULL;
+	environ = VarTable_getEnvp(oVarTable);
+	return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move file descriptor iFd onto iTarget while a builtin command runs
+   in the shell, and return a copy of what iTarget was before. */
+
+static int replaceFd(int iFd, int iTarget)
+{
+	int iSaved;
+
+	iSaved = fcntl(iTarget, F_DUPFD_CLOEXEC, 10);
+	if (iSaved == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	if (dup2(iFd, iTarget) == -1) 
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+	close(iFd);
+	return iSaved;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put back the file descriptor iTarget that replaceFd() saved as
+   iSaved. */
+
+static void restoreFd(int iSaved, int iTarget)
+{
+	if (dup2(iSaved, iTarget) == -1) 
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+	close(iSaved);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If oCommand is a builtin command, execute it in the current
+   process as executeBuiltin() does, store its exit status in
+   *piStatus, and return TRUE; the files that oCommand redirects
+   standard input and output to replace the shell's own while it
+   runs. Otherwise return FALSE. */
+
+static int executeRedirectedBuiltin(Command_T oCommand, int* piStatus)
+{
+	int iStdIn = -1;
+	int iStdOut = -1;
+	int iSavedIn = -1;
+	int iSavedOut = -1;
+
+	if (getBuiltin(oCommand) == NULL)
+		return FALSE;
+	if ((Command_getStdIn(oCommand) == NULL) &&
+		(Command_getStdOut(oCommand) == NULL))
+		return executeBuiltin(oCommand, piStatus);
+
+	if (! openRedirections(oCommand, &iStdIn, &iStdOut))
+	{
+		*piStatus = 1;
+		return TRUE;
+	}
+	/* The shell's input, if on stdin, must not lose what it has
+	   read ahead. */
+	fflush(stdout);
+	if ((iStdIn != -1) && (oInputReader != NULL))
+		LineReader_sync(oInputReader);
+	if (iStdIn != -1) iSavedIn = replaceFd(iStdIn, 0);
+	if (iStdOut != -1) iSavedOut = replaceFd(iStdOut, 1);
+
+	executeBuiltin(oCommand, piStatus);
+
+	fflush(stdout);
+	if (iSavedIn != -1) restoreFd(iSavedIn, 0);
+	if (iSavedOut != -1) restoreFd(iSavedOut, 1);
+	return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the arguments with which SCRIPT_SHELL runs oCommand, found
+   at pcPath, as a script: SCRIPT_SHELL, pcPath, then the arguments of
+   oCommand. The caller owns the array, but not its strings. */
+
+static char** getScriptArgs(Command_T oCommand, const char* pcPath)
+{
+	char** ppcArgs;
+	size_t uArgCount;
+
+	uArgCount = Command_getArgCount(oCommand);
+	ppcArgs = (char**)malloc((uArgCount + 3) * sizeof(char*));
+	if (ppcArgs == NULL) {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	ppcArgs[0] = (char*)SCRIPT_SHELL;
+	ppcArgs[1] = (char*)pcPath;
+	memcpy(ppcArgs + 2, Command_getArgsArray(oCommand) + 1,
+		(uArgCount + 1) * sizeof(char*));
+	return ppcArgs;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run oCommand in a child process made by fork(), with standard input
+   from iStdIn and standard output to iStdOut unless they are -1 or
+   oCommand redirects them. Return the child's process ID, or -1 if
+   fork() fails. */
+
+static pid_t forkCommand(Command_T oCommand, int iStdIn, int iStdOut)
+{
+	const char* pcPath = NULL;
+	char** ppcEnvp;
+	pid_t iPid;
+	int iStatus;
+
+	/* Find the command in the shell, where the PathCache lasts, and
+	   build its environment there, where it is kept for reuse. */
+	ppcEnvp = environ;
+	if (getBuiltin(oCommand) == NULL)
+	{
+		ppcEnvp = getEnvironment(oCommand);
+		if (! assignsPath(oCommand))
+			pcPath = PathCache_lookup(oPathCache, 
+				Command_getName(oCommand));
+	}
+
+	iPid = fork();
+	if (iPid == -1) {perror(pcPgmName); return -1;}
+
+	if (iPid == 0)
+	{
+		/* The command gets the signal mask the shell started with. */
+		sigprocmask(SIG_SETMASK, &sOrigMask, NULL);
+
+		/* Redirect if needed to stdin and stdout. */
+		redirect(oCommand, iStdIn, iStdOut);
+
+		/* A builtin command in a pipeline runs in the child. */
+		if (executeBuiltin(oCommand, &iStatus))
+			exit(iStatus);
+
+		/* Execute external command. If its remembered path has
+		   gone missing, or it has a PATH of its own, search PATH
+		   again. */
+		environ = ppcEnvp;
+		if (pcPath != NULL)
+		{
+			execv(pcPath, Command_getArgsArray(oCommand));
+			if (errno == ENOEXEC)
+				execv(SCRIPT_SHELL, getScriptArgs(oCommand, pcPath));
+		}
+		if ((pcPath == NULL) ? assignsPath(oCommand) : (errno == ENOENT))
+			execvp(Command_getName(oCommand), 
+				Command_getArgsArray(oCommand));
+
+		fprintf(stderr, "%s: %s\n", pcPgmName, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	return iPid;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the external command oCommand with posix_spawn(), with
+   standard input from iStdIn and standard output to iStdOut unless
+   they are -1 or oCommand redirects them. The child shares the
+   shell's memory until it executes the command, so nothing is
+   copied however large the shell is; the redirections are opened
+   in the shell and moved into place by spawn file actions. The
+   command's path comes from the PathCache; if the file there has
+   gone missing, it is forgotten and searched for again. Return the
+   child's process ID, or -1 if the command could not be run. */
+
+static pid_t spawnCommand(Command_T oCommand, int iStdIn, int iStdOut)
+{
+	posix_spawn_file_actions_t sActions;
+	const char* pcPath;
+	char** ppcEnvp;
+	char** ppcSavedEnv;
+	char** ppcScriptArgs;
+	int iInFd = -1;
+	int iOutFd = -1;
+	pid_t iPid;
+	int iRet;
+
+	if (! openRedirections(oCommand, &iInFd, &iOutFd))
+		return -1;
+	if (iInFd != -1) iStdIn = iInFd;
+	if (iOutFd != -1) iStdOut = iOutFd;
+
+	iRet = posix_spawn_file_actions_init(&sActions);
+	if (iRet != 0) {errno = iRet; perror(pcPgmName); exit(EXIT_FAILURE);}
+	if (iStdIn != -1)
+	{
+		iRet = posix_spawn_file_actions_adddup2(&sActions, iStdIn, 0);
+		if (iRet != 0) 
+			{errno = iRet; perror(pcPgmName); exit(EXIT_FAILURE);}
+	}
+	if (iStdOut != -1)
+	{
+		iRet = posix_spawn_file_actions_adddup2(&sActions, iStdOut, 1);
+		if (iRet != 0) 
+			{errno = iRet; perror(pcPgmName); exit(EXIT_FAILURE);}
+	}
+
+	/* A command with a PATH of its own is searched for in it;
+	   posix_spawnp() takes PATH from environ. */
+	ppcEnvp = getEnvironment(oCommand);
+	if (assignsPath(oCommand))
+	{
+		ppcSavedEnv = environ;
+		environ = ppcEnvp;
+		iRet = posix_spawnp(&iPid, Command_getName(oCommand), &sActions,
+			&sSpawnAttr, Command_getArgsArray(oCommand), ppcEnvp);
+		environ = ppcSavedEnv;
+		pcPath = NULL;
+	}
+	else
+	{
+		iRet = ENOENT;
+		pcPath = PathCache_lookup(oPathCache, 
+			Command_getName(oCommand));
+		if (pcPath != NULL)
+			iRet = posix_spawn(&iPid, pcPath, &sActions, &sSpawnAttr,
+				Command_getArgsArray(oCommand), ppcEnvp);
+	}
+	if ((iRet == ENOENT) && (pcPath != NULL) &&
+		(pcPath != Command_getName(oCommand)))
+	{
+		PathCache_remove(oPathCache, Command_getName(oCommand));
+		pcPath = PathCache_lookup(oPathCache, Command_getName(oCommand));
+		if (pcPath != NULL)
+			iRet = posix_spawn(&iPid, pcPath, &sActions, &sSpawnAttr, 
+				Command_getArgsArray(oCommand), ppcEnvp);
+	}
+
+	/* Like execvp(), run a file without a known format as a
+	   script of the shell. */
+	if ((iRet == ENOEXEC) && (pcPath != NULL))
+	{
+		ppcScriptArgs = getScriptArgs(oCommand, pcPath);
+		iRet = posix_spawn(&iPid, SCRIPT_SHELL, &sActions, 
+			&sSpawnAttr, ppcScriptArgs, ppcEnvp);
+		free(ppcScriptArgs);
+	}
+
+	posix_spawn_file_actions_destroy(&sActions);
+	if (iInFd != -1) close(iInFd);
+	if (iOutFd != -1) close(iOutFd);
+
+	if (iRet != 0)
+	{
+		fprintf(stderr, "%s: %s\n", pcPgmName, strerror(iRet));
+		return -1;
+	}
+	return iPid;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds from *psStart to *psEnd. */
+
+static double getSeconds(const struct timespec* psStart, 
+	const struct timespec* psEnd)
+{
+	return (double)(psEnd->tv_sec - psStart->tv_sec) +
+		(double)(psEnd->tv_nsec - psStart->tv_nsec) / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The number of jobs of a parallel builtin that may be done but not
+   yet written out, each holding a memfd, beyond the N that run. */
+
+enum {PARALLEL_MAX_AHEAD = 256};
+
+/* A ParallelJob is one run of the command of a parallel builtin. */
+
+struct ParallelJob
+{
+	/* The process ID of the job, or -1 once it is done. */
+	pid_t iPid;
+
+	/* The memfd that holds the job's standard output. */
+	int iOutFd;
+
+	/* The exit status of the job. */
+	int iStatus;
+
+	/* When the job started, and how long it took, in seconds. */
+	struct timespec sStart;
+	double dSeconds;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the parallel builtin command, which is
+
+      parallel [-j N] command [argument...] [::: argument...]
+
+   Run command with its arguments once for each argument after
+   ":::", or, if there is no ":::", for each line of standard input,
+   which is then given as one more argument. Keep up to N jobs
+   running at once, by default one for each processor; each one
+   reads /dev/null, and its standard output is held in a memfd of its
+   own until it is written out, in the order of the arguments. Jobs
+   keep starting behind a slow one until N + PARALLEL_MAX_AHEAD
+   memfds are held. At the end, report on stderr the throughput and the
+   wall time per job. Reap any background job that exits meanwhile.
+   Return 0 if every job succeeds, or 1 otherwise, or if memory or a
+   file descriptor ran out, in which case no more jobs start. */
+
+static int executeParallel(int iArgc, char* ppcArgv[])
+{
+	size_t uArgCount;
+	size_t uWidth = 0;
+	size_t uCommandIndex = 0;
+	size_t uCommandLength;
+	size_t uJobCount;
+	size_t uStarted = 0;
+	size_t uDone = 0;
+	size_t uWritten = 0;
+	size_t uIndex;
+	long lWidth;
+	char* pcEnd;
+	char* pcLine;
+	char* pcBuffer = NULL;
+	size_t uBufferPhysLength = 0;
+	char** ppcJobArgs;
+	char** ppcJobArgv;
+	DynArray_T oLines = NULL;
+	LineReader_T oLineReader;
+	Arena_T oArena;
+	Command_T oJobCommand;
+	struct ParallelJob* psJobs;
+	struct ParallelJob* psJob;
+	struct timespec sStart;
+	struct timespec sEnd;
+	double dMin = 0.0;
+	double dMax = 0.0;
+	double dTotal = 0.0;
+	double dElapsed;
+	int iNullFd;
+	int iWaitStatus;
+	int iStatus = 0;
+	pid_t iPid;
+
+	uArgCount = (size_t)iArgc - 1;
+
+	/* Parse -j N or -jN. */
+	if ((uArgCount > 0) && 
+		(strncmp(ppcArgv[1], "-j", 2) == 0))
+	{
+		pcLine = ppcArgv[1] + 2;
+		uCommandIndex = 1;
+		if ((*pcLine == '\0') && (uArgCount > 1))
+			pcLine = ppcArgv[1 + uCommandIndex++];
+		lWidth = strtol(pcLine, &pcEnd, 10);
+		if ((*pcLine == '\0') || (*pcEnd != '\0') || (lWidth < 1))
+		{
+			fprintf(stderr, "%s: parallel: invalid job count\n", 
+				pcPgmName);
+			return 1;
+		}
+		uWidth = (size_t)lWidth;
+	}
+	if (uWidth == 0)
+	{
+		lWidth = sysconf(_SC_NPROCESSORS_ONLN);
+		uWidth = (lWidth < 1) ? 1 : (size_t)lWidth;
+	}
+
+	/* The command runs up to ":::", if there is one. */
+	for (uCommandLength = 0; 
+		uCommandIndex + uCommandLength < uArgCount; uCommandLength++)
+		if (strcmp(ppcArgv[1 + uCommandIndex + uCommandLength], 
+			":::") == 0)
+			break;
+	if (uCommandLength == 0)
+	{
+		fprintf(stderr, "Usage: parallel [-j N] command [argument...] "
+			"[::: argument...]\n");
+		return 1;
+	}
+
+	oArena = Arena_new();
+	if (oArena == NULL) {perror(pcPgmName); return 1;}
+
+	/* The job arguments follow ":::", or else are the lines of
+	   stdin, read from where the shell stopped. */
+	if (uCommandIndex + uCommandLength < uArgCount)
+	{
+		uJobCount = uArgCount - (uCommandIndex + uCommandLength + 1);
+		ppcJobArgs = ppcArgv + 1 + uCommandIndex + uCommandLength + 1;
+	}
+	else
+	{
+		if (oInputReader != NULL) LineReader_sync(oInputReader);
+		oLineReader = LineReader_new(0);
+		oLines = DynArray_new(0);
+		iStatus = ((oLineReader == NULL) || (oLines == NULL));
+		while ((iStatus == 0) && ((pcLine = LineReader_read(oLineReader,
+			&pcBuffer, &uBufferPhysLength)) != NULL))
+		{
+			if (*pcLine == '\0') continue;
+			if (! DynArray_add(oLines, Arena_strdup(oArena, pcLine)))
+				iStatus = 1;
+		}
+		LineReader_free(oLineReader);
+		free(pcBuffer);
+		if (iStatus != 0)
+		{
+			perror(pcPgmName);
+			if (oLines != NULL) DynArray_free(oLines);
+			Arena_free(oArena);
+			return 1;
+		}
+
+		uJobCount = DynArray_getLength(oLines);
+		ppcJobArgs = (char**)Arena_alloc(oArena, 
+			sizeof(char*) * (uJobCount + 1));
+		DynArray_toArray(oLines, (void**)ppcJobArgs);
+		DynArray_free(oLines);
+	}
+
+	psJobs = (struct ParallelJob*)Arena_alloc(oArena, 
+		sizeof(struct ParallelJob) * (uJobCount + 1));
+
+	/* Each job's command copies the command and its argument. */
+	ppcJobArgv = (char**)Arena_alloc(oArena, 
+		sizeof(char*) * (uCommandLength + 2));
+	for (uIndex = 0; uIndex < uCommandLength; uIndex++)
+		ppcJobArgv[uIndex] = ppcArgv[1 + uCommandIndex + uIndex];
+	ppcJobArgv[uCommandLength + 1] = NULL;
+	iNullFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	if (iNullFd == -1) 
+	{
+		perror(pcPgmName);
+		Arena_free(oArena);
+		return 1;
+	}
+
+	/* Children must not write out what the shell has buffered. */
+	if (fflush(stdout) == EOF) 
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+	clock_gettime(CLOCK_MONOTONIC, &sStart);
+
+	while (uDone < uJobCount)
+	{
+		/* Start jobs until N are running, or the jobs not yet
+		   written out hold too many memfds. If no memfd can be
+		   made, start no more jobs. */
+		while ((uStarted < uJobCount) && 
+			(uStarted - uDone < uWidth) &&
+			(uStarted - uWritten < uWidth + PARALLEL_MAX_AHEAD))
+		{
+			psJob = &psJobs[uStarted];
+			ppcJobArgv[uCommandLength] = ppcJobArgs[uStarted];
+			oJobCommand = Command_new(oArena, ppcJobArgv, 
+				uCommandLength, NULL, NULL, NULL, NULL, 0);
+
+			psJob->iOutFd = memfd_create("parallel", MFD_CLOEXEC);
+			if (psJob->iOutFd == -1) 
+			{
+				perror(pcPgmName);
+				uJobCount = uStarted;
+				iStatus = 1;
+				break;
+			}
+			clock_gettime(CLOCK_MONOTONIC, &psJob->sStart);
+			if (iForkOnly || (getBuiltin(oJobCommand) != NULL))
+				psJob->iPid = forkCommand(oJobCommand, iNullFd, 
+					psJob->iOutFd);
+			else
+				psJob->iPid = spawnCommand(oJobCommand, iNullFd, 
+					psJob->iOutFd);
+			psJob->iStatus = EXIT_NOT_RUN;
+			psJob->dSeconds = 0.0;
+			if (psJob->iPid == -1) uDone++;
+			uStarted++;
+		}
+
+		/* Wait for any job to finish. A background job may finish
+		   first; the job table gets its status. */
+		if (uStarted > uDone)
+		{
+			iPid = waitpid(-1, &iWaitStatus, 0);
+			if (iPid == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+			for (uIndex = uWritten; uIndex < uStarted; uIndex++)
+				if (psJobs[uIndex].iPid == iPid)
+					break;
+			if (uIndex == uStarted)
+			{
+				JobTable_setDone(oJobTable, iPid, 
+					getExitStatus(iWaitStatus));
+				continue;
+			}
+			psJob = &psJobs[uIndex];
+			clock_gettime(CLOCK_MONOTONIC, &sEnd);
+			psJob->iPid = -1;
+			psJob->iStatus = getExitStatus(iWaitStatus);
+			psJob->dSeconds = getSeconds(&psJob->sStart, &sEnd);
+			uDone++;
+		}
+
+		/* Write out the output of the jobs that are done, in
+		   order. */
+		while ((uWritten < uStarted) && (psJobs[uWritten].iPid == -1))
+		{
+			psJob = &psJobs[uWritten++];
+			if ((lseek(psJob->iOutFd, 0, SEEK_SET) == (off_t)-1) ||
+				(! copyFile(psJob->iOutFd, 1)))
+				perror(pcPgmName);
+			close(psJob->iOutFd);
+			if (psJob->iStatus != 0) iStatus = 1;
+			if ((uWritten == 1) || (psJob->dSeconds < dMin))
+				dMin = psJob->dSeconds;
+			if (psJob->dSeconds > dMax) dMax = psJob->dSeconds;
+			dTotal += psJob->dSeconds;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &sEnd);
+	dElapsed = getSeconds(&sStart, &sEnd);
+	fprintf(stderr, "%s: parallel: %lu jobs in %.3f s, %.1f jobs/s; "
+		"per job %.3f s min, %.3f s mean, %.3f s max\n", pcPgmName,
+		(unsigned long)uJobCount, dElapsed, 
+		(dElapsed > 0.0) ? (double)uJobCount / dElapsed : 0.0,
+		dMin, (uJobCount > 0) ? dTotal / (double)uJobCount : 0.0, dMax);
+
+	close(iNullFd);
+	Arena_free(oArena);
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start the commands of oPipeline, every one in a child process of
+   its own, all of them at once, each connected to the next by a
+   pipe. External commands are spawned, unless iForkOnly is set;
+   builtin commands need a fork(). The first command reads iStdIn,
+   which is then closed, unless it is -1. Return the process IDs of
+   the commands, or -1 for any that could not be run, in an array
+   from oArena. */
+
+static pid_t* startPipeline(Arena_T oArena, Pipeline_T oPipeline,
+	int iStdIn)
+{
+	size_t ulLength;
+	size_t ulIndex;
+	Command_T oCommand;
+	pid_t* piPids;
+	int aiPipe[2];
+	int iPrevRead = iStdIn;
+	int iNextWrite;
+	int iRet;
+
+	/* Store number of commands. */
+	ulLength = Pipeline_getLength(oPipeline);
+
+	/* Leave unread input for a child that reads stdin. */
+	LineReader_sync(oInputReader);
+	iRet = fflush(stdout);
+	if (iRet == EOF) {perror(pcPgmName); exit(EXIT_FAILURE); }
+
+	piPids = (pid_t*)Arena_alloc(oArena, sizeof(pid_t) * ulLength);
+
+	/* Start every command before waiting for any, so that they run
+	   concurrently. */
+	for (ulIndex = 0; ulIndex < ulLength; ulIndex++)
+	{
+		oCommand = Pipeline_getCommand(oPipeline, ulIndex);
+
+		/* The pipe to the next command is closed on exec, so that
+		   only the descriptors dup2()ed onto stdin and stdout 
+		   survive into it. */
+		iNextWrite = -1;
+		if (ulIndex + 1 < ulLength)
+		{
+			iRet = pipe2(aiPipe, O_CLOEXEC);
+			if (iRet == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+			iNextWrite = aiPipe[1];
+		}
+
+		if (iForkOnly || (getBuiltin(oCommand) != NULL))
+			piPids[ulIndex] = forkCommand(oCommand, iPrevRead, 
+				iNextWrite);
+		else
+			piPids[ulIndex] = spawnCommand(oCommand, iPrevRead, 
+				iNextWrite);
+
+		/* The children have their own copies of the pipe ends. */
+		if (iPrevRead != -1) close(iPrevRead);
+		iPrevRead = -1;
+		if (ulIndex + 1 < ulLength)
+		{
+			close(aiPipe[1]);
+			iPrevRead = aiPipe[0];
+		}
+	}
+	return piPids;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find what the expansion that starts at the '$' at *ppcDollar
+   stands for: the value of the variable of $NAME or ${NAME}, which
+   is empty if it is not set, or the exit status of the last pipeline
+   for $?, written into acStatus. Store its length in *puLength,
+   advance *ppcDollar past the expansion, and return the value. A '$'
+   that starts none of these stands for itself. */
+
+static const char* getExpansion(const char** ppcDollar, 
+	size_t* puLength, char acStatus[])
+{
+	const char* pcName = *ppcDollar + 1;
+	const char* pcEnd;
+	const char* pcValue;
+	int iBraced;
+
+	if (*pcName == '?')
+	{
+		*puLength = (size_t)sprintf(acStatus, "%d", iLastStatus);
+		*ppcDollar = pcName + 1;
+		return acStatus;
+	}
+
+	iBraced = (*pcName == '{');
+	if (iBraced) pcName++;
+	pcEnd = pcName;
+	if ((*pcEnd == '_') || isalpha((unsigned char)*pcEnd))
+		while ((*pcEnd == '_') || isalnum((unsigned char)*pcEnd))
+			pcEnd++;
+	if ((pcEnd == pcName) || (iBraced && (*pcEnd != '}')))
+	{
+		*puLength = 1;
+		*ppcDollar += 1;
+		return "$";
+	}
+
+	pcValue = VarTable_get(oVarTable, pcName, (size_t)(pcEnd - pcName));
+	if (pcValue == NULL) pcValue = "";
+	*puLength = strlen(pcValue);
+	*ppcDollar = pcEnd + (iBraced ? 1 : 0);
+	return pcValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return pcArg with each expansion in it replaced as getExpansion()
+   replaces it, in memory from oArena, or pcArg itself if it has
+   none. A backslash escapes a '$' or a backslash right after it,
+   which then stands for itself, without the backslash; this is how
+   the lexer passes on those characters inside single quotes. Any
+   other backslash stands for itself. The result is one word as it
+   stands: it is neither split nor read for operators or further
+   expansions. */
+
+static char* expandArg(Arena_T oArena, char* pcArg)
+{
+	char acStatus[16];
+	const char* pc;
+	const char* pcSpecial;
+	const char* pcValue;
+	const char* pcText;
+	char* pcResult;
+	char* pcTo;
+	size_t uLength = 0;
+	size_t uValueLength;
+	size_t uTextLength;
+	int iBuild;
+
+	if ((pcArg == NULL) || (strpbrk(pcArg, "$\\") == NULL))
+		return pcArg;
+
+	/* Measure the result, and then build it. */
+	pcResult = NULL;
+	pcTo = NULL;
+	for (iBuild = FALSE; iBuild <= TRUE; iBuild++)
+	{
+		for (pc = pcArg; (pcSpecial = strpbrk(pc, "$\\")) != NULL; )
+		{
+			uTextLength = (size_t)(pcSpecial - pc);
+			pcText = pc;
+			if (*pcSpecial == '\\')
+			{
+				if ((pcSpecial[1] == '$') || (pcSpecial[1] == '\\'))
+					pcSpecial++;
+				pcValue = pcSpecial++;
+				uValueLength = 1;
+			}
+			else
+				pcValue = getExpansion(&pcSpecial, &uValueLength,
+					acStatus);
+			if (iBuild)
+			{
+				memcpy(pcTo, pcText, uTextLength);
+				pcTo += uTextLength;
+				memcpy(pcTo, pcValue, uValueLength);
+				pcTo += uValueLength;
+			}
+			uLength += uTextLength + uValueLength;
+			pc = pcSpecial;
+		}
+		if (iBuild)
+			strcpy(pcTo, pc);
+		else
+		{
+			uLength += strlen(pc);
+			pcResult = (char*)Arena_alloc(oArena, uLength + 1);
+			pcTo = pcResult;
+		}
+	}
+	return pcResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return oCommand with the expansions in its name, arguments,
+   redirections and assignments replaced, as expandArg() replaces
+   them, as a new Command from oArena, or oCommand itself if it has
+   none. */
+
+static Command_T expandCommand(Arena_T oArena, Command_T oCommand)
+{
+	char** ppcArgv;
+	char** ppcAssigns;
+	char** ppcExpanded;
+	char* pcStdIn;
+	char* pcStdOut;
+	size_t uArgCount;
+	size_t uAssignCount;
+	size_t uIndex;
+	int iChanged;
+
+	ppcArgv = Command_getArgsArray(oCommand);
+	uArgCount = Command_getArgCount(oCommand);
+	ppcAssigns = Command_getAssignments(oCommand);
+	uAssignCount = Command_getAssignCount(oCommand);
+	pcStdIn = expandArg(oArena, Command_getStdIn(oCommand));
+	pcStdOut = expandArg(oArena, Command_getStdOut(oCommand));
+	iChanged = (pcStdIn != Command_getStdIn(oCommand)) ||
+		(pcStdOut != Command_getStdOut(oCommand));
+	for (uIndex = 0; (uIndex <= uArgCount) && (! iChanged); uIndex++)
+		iChanged = (strpbrk(ppcArgv[uIndex], "$\\") != NULL);
+	for (uIndex = 0; (uIndex < uAssignCount) && (! iChanged); uIndex++)
+		iChanged = (strpbrk(ppcAssigns[uIndex], "$\\") != NULL);
+	if (! iChanged)
+		return oCommand;
+
+	/* The assignments go after the arguments and their NULL. */
+	ppcExpanded = (char**)Arena_alloc(oArena, 
+		sizeof(char*) * (uArgCount + uAssignCount + 2));
+	for (uIndex = 0; uIndex <= uArgCount; uIndex++)
+		ppcExpanded[uIndex] = expandArg(oArena, ppcArgv[uIndex]);
+	ppcExpanded[uArgCount + 1] = NULL;
+	for (uIndex = 0; uIndex < uAssignCount; uIndex++)
+		ppcExpanded[uArgCount + 2 + uIndex] = 
+			expandArg(oArena, ppcAssigns[uIndex]);
+	return Command_new(oArena, ppcExpanded, uArgCount, 
+		Command_getQuoted(oCommand), pcStdIn, pcStdOut, 
+		ppcExpanded + uArgCount + 2, uAssignCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff pcWord holds a character that makes it a pattern
+   of file names: '*', '?' or '['. */
+
+static int isPattern(const char* pcWord)
+{
+	return (strpbrk(pcWord, "*?[") != NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to oMatches, in sorted order, the paths of the files that
+   pcRest matches in the directory pcPrefix, which is empty for the
+   working directory or else ends with '/', each one prefixed by
+   pcPrefix. pcRest matches one component of a path at a time, as
+   fnmatch() matches it, and a '.' that starts a name only by itself.
+   The names of matches in the working directory are those of
+   oDirCache, not copies; the other paths are built in oArena. */
+
+static void addMatches(Arena_T oArena, DynArray_T oMatches, 
+	const char* pcPrefix, const char* pcRest)
+{
+	struct stat sStat;
+	DynArray_T oNames;
+	const char* pcSlash;
+	const char* pcTail;
+	char* pcComponent;
+	char* pcName;
+	char* pcPath;
+	size_t uPrefixLength;
+	size_t uComponentLength;
+	size_t uHeadLength;
+	size_t uTailLength;
+	size_t uNameLength;
+	size_t uLength;
+	size_t uIndex;
+	size_t uHigh;
+	size_t uMiddle;
+
+	/* The rest names one path, which exists or does not. */
+	uPrefixLength = strlen(pcPrefix);
+	if (! isPattern(pcRest))
+	{
+		pcPath = (char*)Arena_alloc(oArena, 
+			uPrefixLength + strlen(pcRest) + 1);
+		strcpy(pcPath, pcPrefix);
+		strcpy(pcPath + uPrefixLength, pcRest);
+		if ((lstat(pcPath, &sStat) == 0) && 
+			(! DynArray_add(oMatches, pcPath)))
+			{perror(pcPgmName); exit(EXIT_FAILURE); }
+		return;
+	}
+
+	/* Otherwise a component without a pattern leads to the
+	   directory of the next one. */
+	pcSlash = strchr(pcRest, '/');
+	uComponentLength = (pcSlash == NULL) ? strlen(pcRest) : 
+		(size_t)(pcSlash - pcRest);
+	pcComponent = (char*)Arena_alloc(oArena, uComponentLength + 1);
+	memcpy(pcComponent, pcRest, uComponentLength);
+	pcComponent[uComponentLength] = '\0';
+	if (! isPattern(pcComponent))
+	{
+		pcPath = (char*)Arena_alloc(oArena, 
+			uPrefixLength + uComponentLength + 2);
+		strcpy(pcPath, pcPrefix);
+		strcpy(pcPath + uPrefixLength, pcComponent);
+		strcpy(pcPath + uPrefixLength + uComponentLength, "/");
+		addMatches(oArena, oMatches, pcPath, pcSlash + 1);
+		return;
+	}
+
+	/* Otherwise match the names in the directory, which are sorted
+	   already. The names that start with the text before the first
+	   special character or backslash lie together, after those found
+	   by a binary search; a name that lacks the text after the last
+	   '*', if there is no '[' or backslash, is passed over without
+	   calling fnmatch(). */
+	oNames = DirCache_list(oDirCache, 
+		(uPrefixLength == 0) ? "." : pcPrefix);
+	if (oNames == NULL)
+		return;
+	uHeadLength = strcspn(pcComponent, "*?[\\");
+	pcTail = strrchr(pcComponent, '*');
+	if ((pcTail == NULL) || (strpbrk(pcComponent, "[\\") != NULL) ||
+		isPattern(pcTail + 1))
+		pcTail = "";
+	else
+		pcTail++;
+	uTailLength = strlen(pcTail);
+	uLength = DynArray_getLength(oNames);
+	uIndex = 0;
+	uHigh = uLength;
+	while (uIndex < uHigh)
+	{
+		uMiddle = uIndex + (uHigh - uIndex) / 2;
+		if (strncmp((char*)DynArray_get(oNames, uMiddle), pcComponent, 
+			uHeadLength) < 0)
+			uIndex = uMiddle + 1;
+		else
+			uHigh = uMiddle;
+	}
+	for (; uIndex < uLength; uIndex++)
+	{
+		pcName = (char*)DynArray_get(oNames, uIndex);
+		if (strncmp(pcName, pcComponent, uHeadLength) != 0)
+			break;
+		uNameLength = strlen(pcName);
+		if ((uNameLength < uTailLength) ||
+			(memcmp(pcName + uNameLength - uTailLength, pcTail, 
+				uTailLength) != 0) ||
+			(fnmatch(pcComponent, pcName, FNM_PERIOD) != 0))
+			continue;
+		if ((uPrefixLength == 0) && (pcSlash == NULL))
+		{
+			if (! DynArray_add(oMatches, pcName))
+				{perror(pcPgmName); exit(EXIT_FAILURE); }
+			continue;
+		}
+
+		pcPath = (char*)Arena_alloc(oArena, 
+			uPrefixLength + uNameLength + 2);
+		strcpy(pcPath, pcPrefix);
+		strcpy(pcPath + uPrefixLength, pcName);
+		if (pcSlash == NULL)
+		{
+			if (! DynArray_add(oMatches, pcPath))
+				{perror(pcPgmName); exit(EXIT_FAILURE); }
+		}
+		else
+		{
+			strcpy(pcPath + uPrefixLength + uNameLength, "/");
+			addMatches(oArena, oMatches, pcPath, pcSlash + 1);
+		}
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return oCommand with each word of its name and arguments that is a
+   pattern replaced by the paths of the files that it matches, as
+   addMatches() finds them, as a new Command from oArena, or oCommand
+   itself if it has no patterns. A pattern that matches nothing is
+   left as it is, and so is a word that held a quoted literal. */
+
+static Command_T globCommand(Arena_T oArena, Command_T oCommand)
+{
+	DynArray_T oArgs;
+	char** ppcArgv;
+	char** ppcGlobbed;
+	size_t uArgCount;
+	size_t uLength;
+	size_t uIndex;
+
+	ppcArgv = Command_getArgsArray(oCommand);
+	uArgCount = Command_getArgCount(oCommand);
+	for (uIndex = 0; uIndex <= uArgCount; uIndex++)
+		if (isPattern(ppcArgv[uIndex]) && 
+			(! Command_isQuoted(oCommand, uIndex)))
+			break;
+	if (uIndex > uArgCount)
+		return oCommand;
+
+	oArgs = DynArray_new(0);
+	if (oArgs == NULL) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	for (uIndex = 0; uIndex <= uArgCount; uIndex++)
+	{
+		uLength = DynArray_getLength(oArgs);
+		if (isPattern(ppcArgv[uIndex]) && 
+			(! Command_isQuoted(oCommand, uIndex)))
+			addMatches(oArena, oArgs, "", ppcArgv[uIndex]);
+		if ((DynArray_getLength(oArgs) == uLength) &&
+			(! DynArray_add(oArgs, ppcArgv[uIndex])))
+			{perror(pcPgmName); exit(EXIT_FAILURE); }
+	}
+
+	uLength = DynArray_getLength(oArgs);
+	ppcGlobbed = (char**)Arena_alloc(oArena, 
+		sizeof(char*) * (uLength + 1));
+	DynArray_toArray(oArgs, (void**)ppcGlobbed);
+	ppcGlobbed[uLength] = NULL;
+	DynArray_free(oArgs);
+	/* Globbing is the last expansion, so the words need no flags. */
+	return Command_new(oArena, ppcGlobbed, uLength - 1, NULL,
+		Command_getStdIn(oCommand), Command_getStdOut(oCommand),
+		Command_getAssignments(oCommand), 
+		Command_getAssignCount(oCommand));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff what expandPipeline() makes of oPipeline may
+   depend on the lines before it: if any word of its commands holds a
+   '$', or a name or argument that is not quoted is a pattern. */
+
+static int isExpandable(Pipeline_T oPipeline)
+{
+	Command_T oCommand;
+	char** ppcArgv;
+	char** ppcAssigns;
+	size_t ulIndex;
+	size_t uIndex;
+
+	for (ulIndex = 0; ulIndex < Pipeline_getLength(oPipeline); ulIndex++)
+	{
+		oCommand = Pipeline_getCommand(oPipeline, ulIndex);
+		if (((Command_getStdIn(oCommand) != NULL) &&
+				(strchr(Command_getStdIn(oCommand), '$') != NULL)) ||
+			((Command_getStdOut(oCommand) != NULL) &&
+				(strchr(Command_getStdOut(oCommand), '$') != NULL)))
+			return TRUE;
+		ppcArgv = Command_getArgsArray(oCommand);
+		for (uIndex = 0; uIndex <= Command_getArgCount(oCommand); 
+			uIndex++)
+			if ((strchr(ppcArgv[uIndex], '$') != NULL) ||
+				(isPattern(ppcArgv[uIndex]) && 
+					(! Command_isQuoted(oCommand, uIndex))))
+				return TRUE;
+		for (ppcAssigns = Command_getAssignments(oCommand); 
+			*ppcAssigns != NULL; ppcAssigns++)
+			if (strchr(*ppcAssigns, '$') != NULL)
+				return TRUE;
+	}
+	return FALSE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return oPipeline with the expansions in its commands replaced, as
+   expandCommand() replaces them, and then its patterns, as
+   globCommand() replaces them, as a new Pipeline from oArena, or
+   oPipeline itself if it has none. Expansion happens just before a
+   pipeline runs, so that it sees what the pipelines before it on the
+   same line did. */
+
+static Pipeline_T expandPipeline(Arena_T oArena, Pipeline_T oPipeline)
+{
+	size_t ulLength;
+	size_t ulIndex;
+	size_t ulCopied;
+	Command_T oCommand;
+	Command_T oExpanded;
+	Command_T* poCommands = NULL;
+
+	ulLength = Pipeline_getLength(oPipeline);
+	for (ulIndex = 0; ulIndex < ulLength; ulIndex++)
+	{
+		oCommand = Pipeline_getCommand(oPipeline, ulIndex);
+		oExpanded = globCommand(oArena, 
+			expandCommand(oArena, oCommand));
+		if ((oExpanded != oCommand) && (poCommands == NULL))
+		{
+			poCommands = (Command_T*)Arena_alloc(oArena, 
+				sizeof(Command_T) * ulLength);
+			for (ulCopied = 0; ulCopied < ulIndex; ulCopied++)
+				poCommands[ulCopied] = 
+					Pipeline_getCommand(oPipeline, ulCopied);
+		}
+		if (poCommands != NULL) poCommands[ulIndex] = oExpanded;
+	}
+	if (poCommands == NULL)
+		return oPipeline;
+	return Pipeline_new(oArena, poCommands, ulLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If the first command of *poPipeline is "time", return TRUE after
+   replacing *poPipeline with a pipeline from oArena that starts with
+   the command after "time" instead, or with NULL if "time" stands
+   alone. Otherwise return FALSE. */
+
+static int removeTimePrefix(Arena_T oArena, Pipeline_T* poPipeline)
+{
+	size_t ulLength;
+	size_t ulIndex;
+	Command_T oFirst;
+	Command_T* poCommands;
+	const int* piQuoted;
+
+	ulLength = Pipeline_getLength(*poPipeline);
+	oFirst = Pipeline_getCommand(*poPipeline, 0);
+	if (strcmp(Command_getName(oFirst), "time") != 0)
+		return FALSE;
+	if (Command_getArgCount(oFirst) == 0)
+	{
+		if (ulLength > 1) return FALSE;
+		*poPipeline = NULL;
+		return TRUE;
+	}
+
+	poCommands = (Command_T*)Arena_alloc(oArena, 
+		sizeof(Command_T) * ulLength);
+	piQuoted = Command_getQuoted(oFirst);
+	poCommands[0] = Command_new(oArena, 
+		Command_getArgsArray(oFirst) + 1, 
+		Command_getArgCount(oFirst) - 1,
+		(piQuoted == NULL) ? NULL : piQuoted + 1,
+		Command_getStdIn(oFirst), Command_getStdOut(oFirst),
+		Command_getAssignments(oFirst), 
+		Command_getAssignCount(oFirst));
+	for (ulIndex = 1; ulIndex < ulLength; ulIndex++)
+		poCommands[ulIndex] = Pipeline_getCommand(*poPipeline, ulIndex);
+	*poPipeline = Pipeline_new(oArena, poCommands, ulLength);
+	return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the resources used that *psUsage describes to *psTotal, taking
+   the larger maximum resident set size. */
+
+static void addUsage(struct rusage* psTotal, const struct rusage* psUsage)
+{
+	psTotal->ru_utime.tv_sec += psUsage->ru_utime.tv_sec;
+	psTotal->ru_utime.tv_usec += psUsage->ru_utime.tv_usec;
+	psTotal->ru_stime.tv_sec += psUsage->ru_stime.tv_sec;
+	psTotal->ru_stime.tv_usec += psUsage->ru_stime.tv_usec;
+	if (psUsage->ru_maxrss > psTotal->ru_maxrss)
+		psTotal->ru_maxrss = psUsage->ru_maxrss;
+	psTotal->ru_minflt += psUsage->ru_minflt;
+	psTotal->ru_majflt += psUsage->ru_majflt;
+	psTotal->ru_nvcsw += psUsage->ru_nvcsw;
+	psTotal->ru_nivcsw += psUsage->ru_nivcsw;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in *psUsage the resources that the shell itself has used
+   since getrusage() stored *psStart, with its maximum resident set
+   size so far. */
+
+static void getUsageSince(const struct rusage* psStart, 
+	struct rusage* psUsage)
+{
+	struct rusage sNow;
+
+	getrusage(RUSAGE_SELF, &sNow);
+	memset(psUsage, 0, sizeof(*psUsage));
+	psUsage->ru_utime.tv_sec = sNow.ru_utime.tv_sec - 
+		psStart->ru_utime.tv_sec;
+	psUsage->ru_utime.tv_usec = sNow.ru_utime.tv_usec - 
+		psStart->ru_utime.tv_usec;
+	psUsage->ru_stime.tv_sec = sNow.ru_stime.tv_sec - 
+		psStart->ru_stime.tv_sec;
+	psUsage->ru_stime.tv_usec = sNow.ru_stime.tv_usec - 
+		psStart->ru_stime.tv_usec;
+	psUsage->ru_maxrss = sNow.ru_maxrss;
+	psUsage->ru_minflt = sNow.ru_minflt - psStart->ru_minflt;
+	psUsage->ru_majflt = sNow.ru_majflt - psStart->ru_majflt;
+	psUsage->ru_nvcsw = sNow.ru_nvcsw - psStart->ru_nvcsw;
+	psUsage->ru_nivcsw = sNow.ru_nivcsw - psStart->ru_nivcsw;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stderr the report of the time builtin: the wall time
+   since *psStart, and the resources that *psUsage describes, as
+   "name=value" fields on one line, so that both people and programs
+   can read it. Times are in seconds, and the maximum resident set
+   size in kilobytes. */
+
+static void writeTime(const struct timespec* psStart, 
+	const struct rusage* psUsage)
+{
+	struct timespec sEnd;
+
+	clock_gettime(CLOCK_MONOTONIC, &sEnd);
+	fprintf(stderr, "time: real=%.6f user=%.6f sys=%.6f maxrss_kb=%ld "
+		"minflt=%ld majflt=%ld nvcsw=%ld nivcsw=%ld\n",
+		getSeconds(psStart, &sEnd),
+		(double)psUsage->ru_utime.tv_sec + 
+			(double)psUsage->ru_utime.tv_usec / 1e6,
+		(double)psUsage->ru_stime.tv_sec + 
+			(double)psUsage->ru_stime.tv_usec / 1e6,
+		psUsage->ru_maxrss, psUsage->ru_minflt, psUsage->ru_majflt,
+		psUsage->ru_nvcsw, psUsage->ru_nivcsw);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the commands of oPipeline. A lone builtin command runs in
+   the shell itself, as executeRedirectedBuiltin() runs it, unless
+   iBackground is TRUE. Otherwise start
+   every command, as startPipeline() does. In the foreground, wait
+   for all of them and return the exit status of the last command.
+   In the background, the first command reads /dev/null instead of
+   the shell's input; add the commands to oJobTable as a job and
+   return 0 at once. If oPipeline starts with "time", report the wall
+   time and the resources that the rest of it used, as wait4() gives
+   them for each child, or as getrusage() gives them for a builtin
+   command run in the shell; a timed pipeline cannot run in the
+   background, and is then refused with exit status 1. The process
+   IDs come from oArena. */
+
+static int executePipeline(Arena_T oArena, Pipeline_T oPipeline,
+	int iBackground)
+{
+	size_t ulLength;
+	size_t ulIndex;
+	pid_t* piPids;
+	pid_t iPid;
+	int iStdIn = -1;
+	int iWaitStatus;
+	int iStatus = EXIT_NOT_RUN;
+	int iTimed;
+	size_t ulRunning;
+	size_t ulJob;
+	struct timespec sStart;
+	struct rusage sSelfStart;
+	struct rusage sUsage;
+	struct rusage sTotal;
+
+	/* Time the pipeline after "time". */
+	oPipeline = expandPipeline(oArena, oPipeline);
+	iTimed = removeTimePrefix(oArena, &oPipeline);
+	if (iTimed && iBackground)
+	{
+		fprintf(stderr, "%s: time: cannot time a background pipeline\n",
+			pcPgmName);
+		return 1;
+	}
+	if (iTimed)
+	{
+		memset(&sTotal, 0, sizeof(sTotal));
+		getrusage(RUSAGE_SELF, &sSelfStart);
+		clock_gettime(CLOCK_MONOTONIC, &sStart);
+		if (oPipeline == NULL)
+		{
+			writeTime(&sStart, &sTotal);
+			return 0;
+		}
+	}
+
+	/* Store number of commands. */
+	ulLength = Pipeline_getLength(oPipeline);
+
+	/* Execute a lone builtin command in the shell. */
+	if ((ulLength == 1) && (! iBackground) &&
+		executeRedirectedBuiltin(Pipeline_getCommand(oPipeline, 0), 
+			&iStatus))
+	{
+		if (iTimed)
+		{
+			getUsageSince(&sSelfStart, &sUsage);
+			writeTime(&sStart, &sUsage);
+		}
+		return iStatus;
+	}
+
+	/* A background job must not take the shell's input. */
+	if (iBackground)
+	{
+		iStdIn = open("/dev/null", O_RDONLY | O_CLOEXEC);
+		if (iStdIn == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	}
+
+	piPids = startPipeline(oArena, oPipeline, iStdIn);
+
+	/* Leave a background job running, and remember it. */
+	if (iBackground)
+	{
+		ulRunning = 0;
+		for (ulIndex = 0; ulIndex < ulLength; ulIndex++)
+			if (piPids[ulIndex] != -1)
+				piPids[ulRunning++] = piPids[ulIndex];
+		if (ulRunning == 0)
+			return 0;
+		ulJob = JobTable_add(oJobTable, piPids, ulRunning,
+			Pipeline_toString(oPipeline, oArena));
+		if (iInteractive)
+			printf("[%lu] %ld\n", (unsigned long)ulJob, 
+				(long)piPids[ulRunning - 1]);
+		return 0;
+	}
+
+	/* Wait for all of the commands that could be run, keeping the
+	   status of the last. */
+	for (ulIndex = 0; ulIndex < ulLength; ulIndex++)
+	{
+		if (piPids[ulIndex] == -1) continue;
+		iPid = wait4(piPids[ulIndex], &iWaitStatus, 0, &sUsage);
+		if (iPid == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+		if (ulIndex + 1 == ulLength)
+			iStatus = getExitStatus(iWaitStatus);
+		if (iTimed) addUsage(&sTotal, &sUsage);
+	}
+	if (iTimed) writeTime(&sStart, &sTotal);
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute the pipelines of oCommandList in order, each one only if
+   its condition holds for the exit status of the last pipeline that
+   ran, which is kept in iLastStatus. A pipeline that is skipped is
+   not forked at all; one that is in the background is not waited
+   for. */
+
+static void executeList(Arena_T oArena, CommandList_T oCommandList)
+{
+	size_t ulIndex;
+	enum ListCondition eCondition;
+
+	for (ulIndex = 0; ulIndex < CommandList_getLength(oCommandList);
+		ulIndex++)
+	{
+		eCondition = CommandList_getCondition(oCommandList, ulIndex);
+		if ((eCondition == RUN_IF_SUCCESS) && (iLastStatus != 0))
+			continue;
+		if ((eCondition == RUN_IF_FAILURE) && (iLastStatus == 0))
+			continue;
+
+		iLastStatus = executePipeline(oArena, 
+			CommandList_getPipeline(oCommandList, ulIndex),
+			CommandList_isBackground(oCommandList, ulIndex));
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The commands whose arguments, if they name files at all, name
+   files that they only read. */
+
+static const char* const apcReadingCommands[] = {
+	"basename", "cat", "cksum", "cmp", "comm", "cut", "date", "diff",
+	"dirname", "echo", "egrep", "expand", "expr", "false", "fgrep",
+	"fold", "grep", "head", "join", "md5sum", "nl", "od", "paste",
+	"printf", "pwd", "rev", "seq", "sha1sum", "sha256sum", "sleep",
+	"stat", "tail", "tr", "true", "wc", NULL
+};
+
+/* The commands that may write the files that their arguments name,
+   and no others. */
+
+static const char* const apcWritingCommands[] = {
+	"chmod", "cp", "gunzip", "gzip", "ln", "mkdir", "mv", "rm",
+	"rmdir", "sort", "tee", "touch", "uniq", NULL
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff the last part of the path pcName is one of the
+   names in the NULL-terminated array ppcList. */
+
+static int isListed(const char* pcName, const char* const* ppcList)
+{
+	const char* pcSlash;
+
+	pcSlash = strrchr(pcName, '/');
+	if (pcSlash != NULL) pcName = pcSlash + 1;
+	for (; *ppcList != NULL; ppcList++)
+		if (strcmp(pcName, *ppcList) == 0)
+			return TRUE;
+	return FALSE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record that the next line of oScheduler reads the file named
+   pcName, or writes it if iWrite is TRUE. Names are compared as
+   written, once "./" and repeated or trailing slashes are dropped.
+   A line that uses a file also reads each directory above it, so
+   that it waits for a line that removes or renames the directory.
+   Uses of /dev/null do not count. The copy of the name comes from
+   oArena. */
+
+static void addFile(Arena_T oArena, const char* pcName, int iWrite)
+{
+	char* pcCopy;
+	char* pcTo;
+	const char* pcFrom;
+
+	/* Everything written to /dev/null is lost alike. */
+	if (strcmp(pcName, "/dev/null") == 0)
+		return;
+
+	pcCopy = (char*)Arena_alloc(oArena, strlen(pcName) + 1);
+	pcTo = pcCopy;
+	for (pcFrom = pcName; *pcFrom != '\0'; pcFrom++)
+	{
+		/* Drop "./" at the start of each part of the path. */
+		if (((pcFrom == pcName) || (pcFrom[-1] == '/')) &&
+			(pcFrom[0] == '.') && (pcFrom[1] == '/'))
+		{
+			pcFrom++;
+			continue;
+		}
+		if ((*pcFrom == '/') && (pcTo > pcCopy) && (pcTo[-1] == '/'))
+			continue;
+		*pcTo++ = *pcFrom;
+	}
+	while ((pcTo > pcCopy + 1) && (pcTo[-1] == '/'))
+		pcTo--;
+	*pcTo = '\0';
+	if (*pcCopy == '\0')
+		strcpy(pcCopy, ".");
+
+	Scheduler_addFile(oScheduler, pcCopy, iWrite);
+	for (pcTo = pcCopy + 1; *pcTo != '\0'; pcTo++)
+	{
+		if (*pcTo != '/') continue;
+		*pcTo = '\0';
+		Scheduler_addFile(oScheduler, pcCopy, FALSE);
+		*pcTo = '/';
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return how oCommand uses the files that its arguments name. A
+   builtin command declares it in asBuiltins, unless its name has been
+   bound anew by enable; an external command declares it by being
+   listed in apcReadingCommands or apcWritingCommands. */
+
+static enum FileUse getFileUse(Command_T oCommand)
+{
+	Builtin_T oBuiltin;
+	const struct ShellBuiltin* psShellBuiltin;
+
+	oBuiltin = getBuiltin(oCommand);
+	if (oBuiltin != NULL)
+	{
+		psShellBuiltin = findShellBuiltin(oBuiltin, 
+			Command_getName(oCommand));
+		return (psShellBuiltin == NULL) ? FILES_UNKNOWN : 
+			psShellBuiltin->eFileUse;
+	}
+	if (isListed(Command_getName(oCommand), apcWritingCommands))
+		return FILES_WRITE;
+	if (isListed(Command_getName(oCommand), apcReadingCommands))
+		return FILES_READ;
+	return FILES_UNKNOWN;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If the files that oPipeline uses are all named by its redirections
+   and its arguments, record them as those of the next line of
+   oScheduler and return TRUE. Otherwise, if it is a command whose
+   effects are unknown, such as a builtin command that changes the
+   state of the shell, return FALSE. A builtin command that declares
+   its files runs in a child process, as an external one does.
+   Standard input and output that are the shell's own count as the
+   file "", which every such line writes, so that they keep their
+   order; a command is taken to read standard input only if no
+   argument names a file. Arguments that start with '-' are taken to
+   be options. Copies of the names come from oArena. */
+
+static int addPipelineFiles(Arena_T oArena, Pipeline_T oPipeline)
+{
+	size_t ulLength;
+	size_t ulIndex;
+	size_t ulArg;
+	Command_T oCommand;
+	int iWrite;
+	int iNamesFiles;
+
+	ulLength = Pipeline_getLength(oPipeline);
+	for (ulIndex = 0; ulIndex < ulLength; ulIndex++)
+	{
+		oCommand = Pipeline_getCommand(oPipeline, ulIndex);
+		if (getFileUse(oCommand) == FILES_UNKNOWN)
+			return FALSE;
+	}
+
+	for (ulIndex = 0; ulIndex < ulLength; ulIndex++)
+	{
+		oCommand = Pipeline_getCommand(oPipeline, ulIndex);
+		iWrite = (getFileUse(oCommand) == FILES_WRITE);
+		iNamesFiles = FALSE;
+		for (ulArg = 0; ulArg < Command_getArgCount(oCommand); ulArg++)
+		{
+			if (Command_getArg(oCommand, ulArg)[0] == '-') continue;
+			addFile(oArena, Command_getArg(oCommand, ulArg), iWrite);
+			iNamesFiles = TRUE;
+		}
+
+		if (Command_getStdIn(oCommand) != NULL)
+			addFile(oArena, Command_getStdIn(oCommand), FALSE);
+		else if ((ulIndex == 0) && (! iNamesFiles))
+			Scheduler_addFile(oScheduler, "", TRUE);
+
+		if (Command_getStdOut(oCommand) != NULL)
+			addFile(oArena, Command_getStdOut(oCommand), TRUE);
+		else if (ulIndex + 1 == ulLength)
+			Scheduler_addFile(oScheduler, "", TRUE);
+	}
+	return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Wait for any child process, and record that it is done in
+   oScheduler, or else in oJobTable. */
+
+static void waitScheduled(void)
+{
+	int iWaitStatus;
+	pid_t iPid;
+
+	iPid = waitpid(-1, &iWaitStatus, 0);
+	if (iPid == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	if (! Scheduler_setDone(oScheduler, iPid, 
+		getExitStatus(iWaitStatus)))
+		JobTable_setDone(oJobTable, iPid, getExitStatus(iWaitStatus));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Wait for every line of oScheduler, and then take the exit status
+   of the one started last as iLastStatus, if any was started since
+   the last call. */
+
+static void waitAllScheduled(void)
+{
+	while (Scheduler_getRunningCount(oScheduler) > 0)
+		waitScheduled();
+	if (iScheduled)
+		iLastStatus = Scheduler_getLastStatus(oScheduler);
+	iScheduled = FALSE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Execute oCommandList as a line of a script that may run at once
+   with the lines before it. A lone pipeline in the foreground whose
+   files addPipelineFiles() can tell starts once no running line uses
+   its files in a conflicting way, and fewer than uSchedulerWindow
+   lines are running; the shell does not wait for it. A pipeline that
+   holds expansions or patterns is expanded only once every line
+   before it is done, so that addPipelineFiles() sees the names that
+   it expands to. Any other line is a barrier: it runs as
+   executeList() runs it, once every line before it is done. */
+
+static void scheduleList(Arena_T oArena, CommandList_T oCommandList)
+{
+	Pipeline_T oPipeline;
+	pid_t* piPids;
+
+	/* What a line expands to depends on the files and the status
+	   that the lines before it leave, so those must finish first. */
+	oPipeline = CommandList_getPipeline(oCommandList, 0);
+	if (isExpandable(oPipeline))
+		waitAllScheduled();
+	oPipeline = expandPipeline(oArena, oPipeline);
+	if ((CommandList_getLength(oCommandList) > 1) ||
+		CommandList_isBackground(oCommandList, 0) ||
+		(! addPipelineFiles(oArena, oPipeline)))
+	{
+		waitAllScheduled();
+		executeList(oArena, oCommandList);
+		return;
+	}
+
+	while (Scheduler_isBlocked(oScheduler) ||
+		(Scheduler_getRunningCount(oScheduler) >= uSchedulerWindow))
+		waitScheduled();
+
+	piPids = startPipeline(oArena, oPipeline, -1);
+	Scheduler_start(oScheduler, piPids, Pipeline_getLength(oPipeline));
+	iScheduled = TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read, analyze and execute the lines of oInputReader until its end,
+   prompting for and echoing them if iInteractive is set, and wait
+   for every line that -P lets run at once. Build each line in
+   oArena, and lex quoted literals that continue over several lines
+   with oLexDFA. Return the number of lines executed. */
+
+static size_t interpret(Arena_T oArena, LexDFA_T oLexDFA)
+{
+	char *pcBuffer = NULL;
+	size_t uBufferPhysLength = 0;
+	const char *pcLine;
+	size_t uLineLength;
+	SynAnalyze_T oSynAnalyze = NULL;
+	CommandList_T oCommandList;
+	size_t uLineCount = 0;
+	int iRet;
+
+    if (iInteractive) printf("%c ", '%');
+
+    /* Continually analyze the input. */
+	while ((pcLine = LineReader_readInPlace(oInputReader, &pcBuffer,
+		&uBufferPhysLength, &uLineLength)) != NULL)
+	{
+		/* Echo the line, unless running quietly. */
+		if (iInteractive)
+		{
+			fwrite(pcLine, 1, uLineLength, stdout);
+			printf("\n");
+			iRet = fflush(stdout);
+			if (iRet == EOF)
+				{perror(pcPgmName); exit(EXIT_FAILURE);}
+		}
+
+		/* Lex analyze the line, handing each token straight to the
+		   syntactic analysis of the command. */
+		if (oSynAnalyze == NULL)
+			oSynAnalyze = SynAnalyze_new(oArena);
+
+		/* Keep the partial command until the literal is closed. */
+		if (! LexDFA_pushLine(oLexDFA, oArena, pcLine, uLineLength,
+			SynAnalyze_addToken, oSynAnalyze))
+		{
+			if (iInteractive) printf("%c ", '>');
+			continue;
+		}
+
+		oCommandList = SynAnalyze_finish(oSynAnalyze);
+		oSynAnalyze = NULL;
+
+		/* Collect any background jobs that are done, and report
+		   them if interactive, or else just forget them. */
+		reapJobs();
+		if (iInteractive) JobTable_write(oJobTable, TRUE);
+		else JobTable_removeDone(oJobTable);
+
+		/* Execute command list if it is not null. */
+		if ((oCommandList != NULL) && (oScheduler != NULL))
+		{
+			scheduleList(oArena, oCommandList);
+		}
+		else if (oCommandList != NULL)
+		{
+			executeList(oArena, oCommandList);
+		}
+
+		/* Free the tokens and the commands all at once, and the
+		   names of directories read again that they held. */
+		Arena_reset(oArena);
+		DirCache_release(oDirCache);
+		uLineCount++;
+
+		if (iInteractive) printf("%c ", '%');
+	}
+	if (iInteractive) printf("\n");
+	LexDFA_finish(oLexDFA);
+	if (oScheduler != NULL) waitAllScheduled();
+
+	free(pcBuffer);
+	return uLineCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A WorkerNote is what a worker of a server tells the server about
+   itself: that it has taken a session, or is idle again. */
+
+struct WorkerNote
+{
+	pid_t iPid;
+	int iIdle;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Write to iNotifyFd a WorkerNote saying whether this worker is
+   idle, as iIdle says. The note is smaller than PIPE_BUF, so notes
+   from different workers never mix. */
+
+static void notifyServer(int iNotifyFd, int iIdle)
+{
+	struct WorkerNote sNote;
+
+	sNote.iPid = getpid();
+	sNote.iIdle = iIdle;
+	if (write(iNotifyFd, &sNote, sizeof(sNote)) == -1)
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run a worker of a server: accept sessions at iListenFd one after
+   another forever, telling iNotifyFd when each one starts and ends.
+   A session takes on the client's standard input, output and error,
+   working directory and environment, interprets the lines that the
+   client sends, as interpret() does with oArena and oLexDFA, and
+   sends back the exit status of the last one. Then the worker goes
+   back to the descriptors, directory and environment it started
+   with. What the worker has found in PATH lasts from one session to
+   the next, unless a session has a PATH of its own. */
+
+static void runWorker(int iListenFd, int iNotifyFd, Arena_T oArena,
+	LexDFA_T oLexDFA)
+{
+	char** ppcBaseEnv;
+	char* pcBasePath;
+	size_t uEnvCount;
+	size_t uIndex;
+	int aiBaseFds[3];
+	int iBaseDirFd;
+	int iConnFd;
+	int iSamePath;
+	int i;
+
+	/* A worker does not outlive its server. */
+	if (prctl(PR_SET_PDEATHSIG, SIGTERM) == -1)
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+	if (getppid() == 1)
+		exit(EXIT_SUCCESS);
+
+	/* Keep what each session changes, to restore it after. */
+	for (i = 0; i < 3; i++)
+	{
+		aiBaseFds[i] = fcntl(i, F_DUPFD_CLOEXEC, 3);
+		if (aiBaseFds[i] == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+	}
+	iBaseDirFd = open(".", O_PATH | O_DIRECTORY | O_CLOEXEC);
+	if (iBaseDirFd == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	for (uEnvCount = 0; environ[uEnvCount] != NULL; uEnvCount++)
+		;
+	ppcBaseEnv = (char**)malloc(sizeof(char*) * (uEnvCount + 1));
+	if (ppcBaseEnv == NULL) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	for (uIndex = 0; uIndex < uEnvCount; uIndex++)
+	{
+		ppcBaseEnv[uIndex] = strdup(environ[uIndex]);
+		if (ppcBaseEnv[uIndex] == NULL)
+			{perror(pcPgmName); exit(EXIT_FAILURE); }
+	}
+	ppcBaseEnv[uEnvCount] = NULL;
+	pcBasePath = getenv("PATH");
+	if (pcBasePath != NULL) pcBasePath = strdup(pcBasePath);
+
+	for (;;)
+	{
+		iConnFd = accept4(iListenFd, NULL, NULL, SOCK_CLOEXEC);
+		if (iConnFd == -1)
+		{
+			if ((errno == EINTR) || (errno == ECONNABORTED)) continue;
+			perror(pcPgmName); 
+			exit(EXIT_FAILURE);
+		}
+		notifyServer(iNotifyFd, FALSE);
+
+		if (Remote_receiveSetup(iConnFd))
+		{
+			loadVariables(environ);
+			iSamePath = (pcBasePath != NULL) && 
+				(getenv("PATH") != NULL) && 
+				(strcmp(pcBasePath, getenv("PATH")) == 0);
+			if (! iSamePath) PathCache_clear(oPathCache);
+
+			/* The connection is close-on-exec, so read ahead. */
+			oInputReader = LineReader_newPrivate(iConnFd);
+			if (oInputReader == NULL)
+				{perror(pcPgmName); exit(EXIT_FAILURE); }
+			interpret(oArena, oLexDFA);
+			LineReader_free(oInputReader);
+			oInputReader = NULL;
+			if (fflush(stdout) == EOF) perror(pcPgmName);
+			(void)Remote_sendStatus(iConnFd, iLastStatus);
+			if (! iSamePath) PathCache_clear(oPathCache);
+		}
+		else perror(pcPgmName);
+		close(iConnFd);
+
+		/* Let go of the client's files, and start afresh. */
+		for (i = 0; i < 3; i++)
+			if (dup2(aiBaseFds[i], i) == -1)
+				{perror(pcPgmName); exit(EXIT_FAILURE); }
+		if (fchdir(iBaseDirFd) == -1)
+			{perror(pcPgmName); exit(EXIT_FAILURE); }
+		loadVariables(ppcBaseEnv);
+		iLastStatus = 0;
+		notifyServer(iNotifyFd, TRUE);
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Serve sessions at the Unix domain socket pcSocketPath forever,
+   with a pool of worker processes that runWorker() runs with oArena
+   and oLexDFA. Whenever no worker is idle, fork another, so that a
+   session hardly ever waits for a fork(), and sessions may run at
+   once. Reap the workers that die whenever SIGCHLD arrives. */
+
+static void serve(const char* pcSocketPath, Arena_T oArena, 
+	LexDFA_T oLexDFA)
+{
+	struct pollfd asFds[2];
+	struct signalfd_siginfo sInfo;
+	struct WorkerNote sNote;
+	struct WorkerNote* psWorkers = NULL;
+	size_t uWorkerCount = 0;
+	size_t uMaxWorkers = 0;
+	size_t uIdleCount;
+	size_t uIndex;
+	int aiNotify[2];
+	int iListenFd;
+	int iWaitStatus;
+	pid_t iPid;
+
+	iListenFd = Remote_listen(pcSocketPath);
+	if (iListenFd == -1) {perror(pcSocketPath); exit(EXIT_FAILURE); }
+	if (pipe2(aiNotify, O_CLOEXEC) == -1)
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+	if (fcntl(aiNotify[0], F_SETFL, O_NONBLOCK) == -1)
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+
+	asFds[0].fd = aiNotify[0];
+	asFds[0].events = POLLIN;
+	asFds[1].fd = iSigChldFd;
+	asFds[1].events = POLLIN;
+	for (;;)
+	{
+		/* Keep a worker idle. */
+		uIdleCount = 0;
+		for (uIndex = 0; uIndex < uWorkerCount; uIndex++)
+			if (psWorkers[uIndex].iIdle) uIdleCount++;
+		if (uIdleCount == 0)
+		{
+			if (uWorkerCount == uMaxWorkers)
+			{
+				uMaxWorkers = (uMaxWorkers == 0) ? 4 : 2 * uMaxWorkers;
+				psWorkers = (struct WorkerNote*)realloc(psWorkers,
+					sizeof(struct WorkerNote) * uMaxWorkers);
+				if (psWorkers == NULL)
+					{perror(pcPgmName); exit(EXIT_FAILURE); }
+			}
+			if (fflush(stdout) == EOF) 
+				{perror(pcPgmName); exit(EXIT_FAILURE); }
+			iPid = fork();
+			if (iPid == -1) {perror(pcPgmName); exit(EXIT_FAILURE); }
+			if (iPid == 0)
+			{
+				close(aiNotify[0]);
+				runWorker(iListenFd, aiNotify[1], oArena, oLexDFA);
+			}
+			psWorkers[uWorkerCount].iPid = iPid;
+			psWorkers[uWorkerCount].iIdle = TRUE;
+			uWorkerCount++;
+		}
+
+		if (poll(asFds, 2, -1) == -1)
+		{
+			if (errno == EINTR) continue;
+			perror(pcPgmName); 
+			exit(EXIT_FAILURE);
+		}
+
+		while (read(aiNotify[0], &sNote, sizeof(sNote)) == 
+			(ssize_t)sizeof(sNote))
+			for (uIndex = 0; uIndex < uWorkerCount; uIndex++)
+				if (psWorkers[uIndex].iPid == sNote.iPid)
+					psWorkers[uIndex].iIdle = sNote.iIdle;
+
+		while (read(iSigChldFd, &sInfo, sizeof(sInfo)) > 0)
+			;
+		while ((iPid = waitpid(-1, &iWaitStatus, WNOHANG)) > 0)
+			for (uIndex = 0; uIndex < uWorkerCount; uIndex++)
+				if (psWorkers[uIndex].iPid == iPid)
+					psWorkers[uIndex] = psWorkers[--uWorkerCount];
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Program main that returns an int. 
+   int argc is the number of arguments, *argv[] an array of the 
+   arguments. With -f script, read commands from the file script
+   instead of stdin. Unless the input is a terminal or -i is given,
+   run quietly: print no prompt, do not echo the input lines, and
+   flush stdout only before a fork or at exit. -q forces the quiet
+   mode. With -s, report at exit how many allocations each line
+   needed, and how many of those reached malloc(). With -F, run
+   every command with fork() instead of posix_spawn(). With -P, let
+   lines that use different files run at once, as many as there are
+   processors. With --serve socket, run the script given with -f, if
+   any, and then serve sessions at the Unix domain socket socket. */
+
+int main(int argc, char *argv[])
+{
+	const char *pcScript = NULL;
+	Arena_T oArena;
+	LexDFA_T oLexDFA;
+	size_t uLineCount;
+	size_t uAllocs;
+	size_t uHeapAllocs;
+	size_t uIndex;
+	int iRet;
+	int iOption;
+	int iStats = 0;
+	int iParallel = FALSE;
+	const char *pcSocketPath = NULL;
+	static const struct option asLongOptions[] = {
+		{"serve", required_argument, NULL, 'S'},
+		{NULL, 0, NULL, 0}
+	};
+	long lProcessors;
+	sigset_t sSigChld;
+
+	pcPgmName = argv[0];
+
+	/* Variables are found by one hash lookup. */
+	loadVariables(environ);
+
+	/* Parse the command-line options. */
+	while ((iOption = getopt_long(argc, argv, "f:iqsFP", asLongOptions,
+		NULL)) != -1)
+	{
+		if (iOption == 'f') pcScript = optarg;
+		else if (iOption == 'i') iInteractive = 1;
+		else if (iOption == 'q') iInteractive = 0;
+		else if (iOption == 's') iStats = 1;
+		else if (iOption == 'F') iForkOnly = TRUE;
+		else if (iOption == 'P') iParallel = TRUE;
+		else if (iOption == 'S') pcSocketPath = optarg;
+		else
+		{
+			fprintf(stderr, "Usage: %s [-i | -q] [-s] [-F] [-P] "
+				"[-f script] [--serve socket]\n", pcPgmName);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* Read a script file in place where possible, else stdin; a
+	   server reads only its sessions, unless it has a script. */
+	if (pcSocketPath != NULL)
+		iInteractive = FALSE;
+	if (pcScript != NULL)
+	{
+		oInputReader = LineReader_open(pcScript);
+		if (oInputReader == NULL)
+			{perror(pcScript); exit(EXIT_FAILURE);}
+	}
+	else if (pcSocketPath == NULL)
+	{
+		oInputReader = LineReader_new(0);
+		if (oInputReader == NULL)
+			{perror(pcPgmName); exit(EXIT_FAILURE);}
+	}
+
+	if (iInteractive == -1)
+		iInteractive = LineReader_isInteractive(oInputReader);
+
+	/* Everything built for a line comes from oArena. */
+	oArena = Arena_new();
+	if (oArena == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	/* Each command is searched for in PATH only once. */
+	oPathCache = PathCache_new();
+	if (oPathCache == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+	oDirCache = DirCache_new();
+	if (oDirCache == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	/* Each builtin command is found by one hash lookup. */
+	oBuiltinTable = BuiltinTable_new();
+	if (oBuiltinTable == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+	for (uIndex = 0; uIndex < sizeof(asBuiltins) / sizeof(asBuiltins[0]);
+		uIndex++)
+		if (! BuiltinTable_add(oBuiltinTable, asBuiltins[uIndex].pcName,
+			asBuiltins[uIndex].pfFunction))
+			{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	/* Children are reaped between lines, when SIGCHLD arrives on
+	   iSigChldFd; children get back the original signal mask. */
+	oJobTable = JobTable_new();
+	if (oJobTable == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+	sigemptyset(&sSigChld);
+	sigaddset(&sSigChld, SIGCHLD);
+	iRet = sigprocmask(SIG_BLOCK, &sSigChld, &sOrigMask);
+	if (iRet == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+	iSigChldFd = signalfd(-1, &sSigChld, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (iSigChldFd == -1) {perror(pcPgmName); exit(EXIT_FAILURE);}
+	iRet = posix_spawnattr_init(&sSpawnAttr);
+	if (iRet == 0)
+		iRet = posix_spawnattr_setsigmask(&sSpawnAttr, &sOrigMask);
+	if (iRet == 0)
+		iRet = posix_spawnattr_setflags(&sSpawnAttr, 
+			POSIX_SPAWN_SETSIGMASK);
+	if (iRet != 0) {errno = iRet; perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	/* Independent lines run at once, one for each processor. */
+	if (iParallel)
+	{
+		oScheduler = Scheduler_new();
+		if (oScheduler == NULL)
+			{perror(pcPgmName); exit(EXIT_FAILURE);}
+		lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+		uSchedulerWindow = (lProcessors < 2) ? 2 : (size_t)lProcessors;
+	}
+
+	/* A quoted literal may continue over several lines. */
+	oLexDFA = LexDFA_new();
+	if (oLexDFA == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	uLineCount = 0;
+	if (oInputReader != NULL)
+		uLineCount = interpret(oArena, oLexDFA);
+	if (pcSocketPath != NULL)
+		serve(pcSocketPath, oArena, oLexDFA);
+
+	if (iStats && (uLineCount > 0))
+	{
+		uAllocs = Arena_getAllocCount(oArena, &uHeapAllocs);
+		fprintf(stderr, 
+			"%s: %lu lines, %.2f allocations per line, "
+			"%.2f from malloc()\n", pcPgmName, 
+			(unsigned long)uLineCount, (double)uAllocs / uLineCount,
+			(double)uHeapAllocs / uLineCount);
+	}
+
+	LexDFA_free(oLexDFA);
+	posix_spawnattr_destroy(&sSpawnAttr);
+	close(iSigChldFd);
+	Scheduler_free(oScheduler);
+	JobTable_free(oJobTable);
+	BuiltinTable_free(oBuiltinTable);
+	environ = NULL;
+	VarTable_free(oVarTable);
+	DirCache_free(oDirCache);
+	PathCache_free(oPathCache);
+	Arena_free(oArena);
+	LineReader_free(oInputReader);
 	return 0;
 }
\ No newline at end of file
@@ -13,4 +13,10 @@
 
 extern const char* pcPgmName;
 
+/*--------------------------------------------------------------------*/
+
+/* The exit status of a command that could not be run. */
+
+enum {EXIT_NOT_RUN = 127};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+/*--------------------------------------------------------------------*/
+/* ishclient.c                                                        */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "remote.h"
+#include "ish.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+/*--------------------------------------------------------------------*/
+
+enum {FALSE, TRUE};
+
+/*--------------------------------------------------------------------*/
+
+/* The name of the executable binary file. */
+const char* pcPgmName;
+
+/*--------------------------------------------------------------------*/
+
+/* Run command line pcLine in a session of the ish server listening
+   at pcSocketPath, with this process's standard input, output and
+   error, working directory and environment. Return the exit status
+   of the line. */
+
+static int runRemote(const char* pcSocketPath, const char* pcLine)
+{
+	int iSocket;
+	int iStatus;
+
+	iSocket = Remote_connect(pcSocketPath);
+	if (iSocket == -1) {perror(pcSocketPath); exit(EXIT_FAILURE); }
+
+	/* The line is the whole session. */
+	if ((! Remote_sendSetup(iSocket)) ||
+		(! Remote_sendLine(iSocket, pcLine)) ||
+		(shutdown(iSocket, SHUT_WR) == -1))
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+
+	if (! Remote_receiveStatus(iSocket, &iStatus))
+	{
+		if (errno == 0)
+			fprintf(stderr, "%s: session ended early\n", pcPgmName);
+		else perror(pcPgmName);
+		exit(EXIT_FAILURE);
+	}
+	close(iSocket);
+	return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run command line pcLine with "sh -c", and return its exit
+   status. */
+
+static int runShell(const char* pcLine)
+{
+	char* apcArgv[4];
+	pid_t iPid;
+	int iWaitStatus;
+	int iRet;
+
+	apcArgv[0] = (char*)"sh";
+	apcArgv[1] = (char*)"-c";
+	apcArgv[2] = (char*)pcLine;
+	apcArgv[3] = NULL;
+	iRet = posix_spawnp(&iPid, "sh", NULL, NULL, apcArgv, environ);
+	if (iRet != 0) {errno = iRet; perror(pcPgmName); exit(EXIT_FAILURE);}
+	if (waitpid(iPid, &iWaitStatus, 0) == -1)
+		{perror(pcPgmName); exit(EXIT_FAILURE); }
+	return WIFEXITED(iWaitStatus) ? WEXITSTATUS(iWaitStatus) : 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds since some fixed time. */
+
+static double getTime(void)
+{
+	struct timespec sNow;
+
+	clock_gettime(CLOCK_MONOTONIC, &sNow);
+	return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Program main that returns an int. 
+   int argc is the number of arguments, *argv[] an array of the 
+   arguments. Run the command line made of the arguments after the
+   socket path in a session of the ish server listening there, and
+   exit with its status. With -b count, run it count times instead,
+   both through the server and with "sh -c", and report on stderr
+   the mean latency of each. */
+
+int main(int argc, char *argv[])
+{
+	const char* pcSocketPath;
+	char* pcLine;
+	size_t uLength = 0;
+	long lRuns = 0;
+	long lRun;
+	double dStart;
+	double dRemote;
+	double dShell;
+	int iOption;
+	int iStatus = 0;
+	int i;
+
+	pcPgmName = argv[0];
+
+	/* Parse the command-line options. */
+	while ((iOption = getopt(argc, argv, "+b:")) != -1)
+	{
+		if (iOption == 'b') lRuns = strtol(optarg, NULL, 10);
+		if ((iOption != 'b') || (lRuns < 1))
+		{
+			fprintf(stderr, "Usage: %s [-b count] socket command "
+				"[argument...]\n", pcPgmName);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (argc - optind < 2)
+	{
+		fprintf(stderr, "Usage: %s [-b count] socket command "
+			"[argument...]\n", pcPgmName);
+		exit(EXIT_FAILURE);
+	}
+	pcSocketPath = argv[optind];
+
+	/* The words of the command line are joined by spaces. */
+	for (i = optind + 1; i < argc; i++)
+		uLength += strlen(argv[i]) + 1;
+	pcLine = (char*)malloc(uLength);
+	if (pcLine == NULL) {perror(pcPgmName); exit(EXIT_FAILURE); }
+	pcLine[0] = '\0';
+	for (i = optind + 1; i < argc; i++)
+	{
+		if (i > optind + 1) strcat(pcLine, " ");
+		strcat(pcLine, argv[i]);
+	}
+
+	if (lRuns == 0)
+	{
+		iStatus = runRemote(pcSocketPath, pcLine);
+		free(pcLine);
+		return iStatus;
+	}
+
+	dStart = getTime();
+	for (lRun = 0; lRun < lRuns; lRun++)
+		iStatus |= runRemote(pcSocketPath, pcLine);
+	dRemote = (getTime() - dStart) / (double)lRuns;
+
+	dStart = getTime();
+	for (lRun = 0; lRun < lRuns; lRun++)
+		iStatus |= runShell(pcLine);
+	dShell = (getTime() - dStart) / (double)lRuns;
+
+	fprintf(stderr, "%s: %ld runs: ish server %.1f us, sh -c %.1f us "
+		"per run (%.2fx)\n", pcPgmName, lRuns, dRemote * 1e6, 
+		dShell * 1e6, dShell / dRemote);
+	free(pcLine);
+	return iStatus;
+}
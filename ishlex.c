@@ -3,7 +3,7 @@
 /* Author: Isaac Wolfe                                                */
 /*--------------------------------------------------------------------*/
 
-#include "dynarray.h"
+#include "arena.h"
 #include "token.h"
 #include "linereader.h"
 #include "lexdfa.h"
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 
 /*--------------------------------------------------------------------*/
 
@@ -21,37 +22,73 @@ const char *pcPgmName;
 
 /* Program main that returns an int. 
    int argc is the number of arguments, *argv[] an array of the 
-   arguments. */
+   arguments. Unless stdin is a terminal or -i is given, run quietly:
+   print no prompt, do not echo the input lines, and leave stdout
+   fully buffered. -q forces the quiet mode. */
 
 int main(int argc, char *argv[])
 {
-	char *pcLine;
-	DynArray_T oTokens;
+	char *pcLine = NULL;
+	size_t uLinePhysLength = 0;
+	LineReader_T oInputReader;
+	TokenList_T oTokens;
+	Arena_T oArena;
 	int iRet;
+	int iOption;
+	int iInteractive = -1;
 
 	pcPgmName = argv[0];
 
-    printf("%c ", '%');
+	/* Parse the command-line options. */
+	while ((iOption = getopt(argc, argv, "iq")) != -1)
+	{
+		if (iOption == 'i') iInteractive = 1;
+		else if (iOption == 'q') iInteractive = 0;
+		else
+		{
+			fprintf(stderr, "Usage: %s [-i | -q]\n", pcPgmName);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	oInputReader = LineReader_new(0);
+	if (oInputReader == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
 
-	while((pcLine = LineReader_read(stdin)) != NULL)
+	if (iInteractive == -1)
+		iInteractive = LineReader_isInteractive(oInputReader);
+
+	oArena = Arena_new();
+	if (oArena == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+    if (iInteractive) printf("%c ", '%');
+
+	while (LineReader_read(oInputReader, &pcLine, &uLinePhysLength) 
+		!= NULL)
 	{
-		printf("%s\n", pcLine);
-		iRet = fflush(stdout);
-		if (iRet == EOF)
-			{perror(pcPgmName); exit(EXIT_FAILURE);}
+		/* Echo the line, unless running quietly. */
+		if (iInteractive)
+		{
+			printf("%s\n", pcLine);
+			iRet = fflush(stdout);
+			if (iRet == EOF)
+				{perror(pcPgmName); exit(EXIT_FAILURE);}
+		}
 
-		oTokens = LexDFA_lexLine(pcLine);
+		oTokens = LexDFA_lexLine(oArena, pcLine);
 
 		if (oTokens != NULL)
 		{
 			LexDFA_writeTokens(oTokens);
-			LexDFA_freeTokens(oTokens);
-			DynArray_free(oTokens);
 		}
 
-		free(pcLine);
-		printf("%c ", '%');
+		Arena_reset(oArena);
+		if (iInteractive) printf("%c ", '%');
 	}
-	printf("\n");
+	if (iInteractive) printf("\n");
+	Arena_free(oArena);
+	free(pcLine);
+	LineReader_free(oInputReader);
 	return 0;
 }
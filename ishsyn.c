@@ -3,16 +3,18 @@
 /* Author: Isaac Wolfe                                                */
 /*--------------------------------------------------------------------*/
 
-#include "dynarray.h"
+#include "arena.h"
 #include "token.h"
 #include "linereader.h"
 #include "lexdfa.h"
 #include "ish.h"
 #include "command.h"
+#include "commandlist.h"
 #include "synAnalyze.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 
 /*--------------------------------------------------------------------*/
 
@@ -23,52 +25,87 @@ const char* pcPgmName;
 
 /* Program main that returns an int. 
    int argc is the number of arguments, *argv[] an array of the 
-   arguments. */
+   arguments. Unless stdin is a terminal or -i is given, run quietly:
+   print no prompt, do not echo the input lines, and leave stdout
+   fully buffered. -q forces the quiet mode. */
 
 int main(int argc, char *argv[])
 {
-	char *pcLine;
-	DynArray_T oTokens;
-	Command_T oCommand;
+	char *pcLine = NULL;
+	size_t uLinePhysLength = 0;
+	LineReader_T oInputReader;
+	TokenList_T oTokens;
+	Arena_T oArena;
+	CommandList_T oCommandList;
 	int iRet;
+	int iOption;
+	int iInteractive = -1;
 
 	pcPgmName = argv[0];
 
-    printf("%c ", '%');
+	/* Parse the command-line options. */
+	while ((iOption = getopt(argc, argv, "iq")) != -1)
+	{
+		if (iOption == 'i') iInteractive = 1;
+		else if (iOption == 'q') iInteractive = 0;
+		else
+		{
+			fprintf(stderr, "Usage: %s [-i | -q]\n", pcPgmName);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	oInputReader = LineReader_new(0);
+	if (oInputReader == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	if (iInteractive == -1)
+		iInteractive = LineReader_isInteractive(oInputReader);
+
+	oArena = Arena_new();
+	if (oArena == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+    if (iInteractive) printf("%c ", '%');
 
     /* Continually print prompt and analyze line. */
-	while((pcLine = LineReader_read(stdin)) != NULL)
+	while (LineReader_read(oInputReader, &pcLine, &uLinePhysLength) 
+		!= NULL)
 	{
-		printf("%s\n", pcLine);
-		iRet = fflush(stdout);
-		if (iRet == EOF)
-			{perror(pcPgmName); exit(EXIT_FAILURE);}
+		/* Echo the line, unless running quietly. */
+		if (iInteractive)
+		{
+			printf("%s\n", pcLine);
+			iRet = fflush(stdout);
+			if (iRet == EOF)
+				{perror(pcPgmName); exit(EXIT_FAILURE);}
+		}
 
 		/* Lex analyze. */
-		oTokens = LexDFA_lexLine(pcLine);
+		oTokens = LexDFA_lexLine(oArena, pcLine);
 
-		oCommand = NULL;
+		oCommandList = NULL;
 
 		printf("%s", "");
 
 		/* Syn analyze if oTokens is not NULL. */
 		if (oTokens != NULL)
 		{
-			oCommand = SynAnalyze_analyze(oTokens);
-			LexDFA_freeTokens(oTokens);
-			DynArray_free(oTokens);
+			oCommandList = SynAnalyze_analyze(oArena, oTokens);
 		}
 
-		/* Write and free oCommand (if not NULL). */
-		if (oCommand != NULL)
+		/* Write oCommandList (if not NULL). */
+		if (oCommandList != NULL)
 		{
-			Command_write(oCommand);
-			Command_free(oCommand);
+			CommandList_write(oCommandList);
 		}
 
-		if (pcLine != NULL) free(pcLine);
-		printf("%c ", '%');
+		Arena_reset(oArena);
+		if (iInteractive) printf("%c ", '%');
 	}
-	printf("\n");
+	if (iInteractive) printf("\n");
+	Arena_free(oArena);
+	free(pcLine);
+	LineReader_free(oInputReader);
 	return 0;
 }
@@ -0,0 +1,326 @@
+/*--------------------------------------------------------------------*/
+/* jobtable.c                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "jobtable.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of buckets of process IDs that a JobTable has. */
+
+enum {BUCKET_COUNT = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* A Process is a process of a Job, with its state. */
+
+struct Process
+{
+   /* The ID of the process. */
+   pid_t iPid;
+
+   /* Whether the process is done, and if so its exit status. */
+   int iDone;
+   int iStatus;
+
+   /* The Job that the process belongs to. */
+   struct Job *psJob;
+
+   /* The next Process in the same bucket. */
+   struct Process *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Job is a pipeline running in the background. */
+
+struct Job
+{
+   /* The number of the job. */
+   size_t uNumber;
+
+   /* The processes of the job, first to last, their number, and the
+      number of them still running. */
+   struct Process **ppsProcesses;
+   size_t uCount;
+   size_t uRunning;
+
+   /* What the job runs. */
+   char *pcDescription;
+
+   /* The next Job, in order of number. */
+   struct Job *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A JobTable is a list of Jobs, along with a hash table of all of
+   their Processes, keyed by process ID. */
+
+struct JobTable
+{
+   /* The Jobs, in order of number. */
+   struct Job *psJobs;
+
+   /* The buckets of Processes. */
+   struct Process *apsBuckets[BUCKET_COUNT];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pointer to the link in oJobTable that points to the
+   Process whose ID is iPid, or to the NULL link at the end of its
+   bucket if there is none. */
+
+static struct Process **JobTable_find(JobTable_T oJobTable, pid_t iPid)
+{
+   struct Process **ppsLink;
+
+   ppsLink = &oJobTable->apsBuckets[(size_t)iPid % BUCKET_COUNT];
+   while ((*ppsLink != NULL) && ((*ppsLink)->iPid != iPid))
+      ppsLink = &(*ppsLink)->psNext;
+   return ppsLink;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove Job psJob, which *ppsLink points to, from oJobTable, and
+   free it along with its Processes. */
+
+static void JobTable_remove(JobTable_T oJobTable, struct Job **ppsLink)
+{
+   struct Job *psJob = *ppsLink;
+   struct Process **ppsProcessLink;
+   size_t u;
+
+   *ppsLink = psJob->psNext;
+   for (u = 0; u < psJob->uCount; u++)
+   {
+      ppsProcessLink = JobTable_find(oJobTable,
+                                     psJob->ppsProcesses[u]->iPid);
+      *ppsProcessLink = (*ppsProcessLink)->psNext;
+      free(psJob->ppsProcesses[u]);
+   }
+   free(psJob->ppsProcesses);
+   free(psJob->pcDescription);
+   free(psJob);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty JobTable object, or NULL if insufficient memory
+   is available. */
+
+JobTable_T JobTable_new(void)
+{
+   JobTable_T oJobTable;
+   size_t u;
+
+   oJobTable = (struct JobTable*)malloc(sizeof(struct JobTable));
+   if (oJobTable == NULL)
+      return NULL;
+
+   oJobTable->psJobs = NULL;
+   for (u = 0; u < BUCKET_COUNT; u++)
+      oJobTable->apsBuckets[u] = NULL;
+   return oJobTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oJobTable. */
+
+void JobTable_free(JobTable_T oJobTable)
+{
+   if (oJobTable == NULL)
+      return;
+
+   while (oJobTable->psJobs != NULL)
+      JobTable_remove(oJobTable, &oJobTable->psJobs);
+   free(oJobTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to oJobTable a job made of the uCount running processes whose
+   IDs are in piPids, the last of which gives the job's exit status,
+   and which is described by string pcDescription. Return the job's
+   number. */
+
+size_t JobTable_add(JobTable_T oJobTable, const pid_t *piPids,
+   size_t uCount, const char *pcDescription)
+{
+   struct Job *psJob;
+   struct Job **ppsLink;
+   struct Process *psProcess;
+   struct Process **ppsProcessLink;
+   size_t uNumber = 1;
+   size_t u;
+
+   assert(oJobTable != NULL);
+   assert(piPids != NULL);
+   assert(pcDescription != NULL);
+
+   /* The job is numbered one past the last job, and goes last. */
+   for (ppsLink = &oJobTable->psJobs; *ppsLink != NULL;
+        ppsLink = &(*ppsLink)->psNext)
+      uNumber = (*ppsLink)->uNumber + 1;
+
+   psJob = (struct Job*)malloc(sizeof(struct Job));
+   if (psJob == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psJob->ppsProcesses = (struct Process**)
+      calloc(uCount, sizeof(struct Process*));
+   psJob->pcDescription = strdup(pcDescription);
+   if ((psJob->ppsProcesses == NULL) || (psJob->pcDescription == NULL))
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psJob->uNumber = uNumber;
+   psJob->uCount = uCount;
+   psJob->uRunning = uCount;
+   psJob->psNext = NULL;
+
+   for (u = 0; u < uCount; u++)
+   {
+      psProcess = (struct Process*)malloc(sizeof(struct Process));
+      if (psProcess == NULL)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      psProcess->iPid = piPids[u];
+      psProcess->iDone = 0;
+      psProcess->iStatus = 0;
+      psProcess->psJob = psJob;
+
+      ppsProcessLink = JobTable_find(oJobTable, piPids[u]);
+      assert(*ppsProcessLink == NULL);
+      psProcess->psNext = NULL;
+      *ppsProcessLink = psProcess;
+      psJob->ppsProcesses[u] = psProcess;
+   }
+
+   *ppsLink = psJob;
+   return uNumber;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record that the process of oJobTable whose ID is iPid is done, with
+   exit status iStatus. Return 1 (TRUE) if iPid is a running process
+   of oJobTable, or 0 (FALSE) otherwise. */
+
+int JobTable_setDone(JobTable_T oJobTable, pid_t iPid, int iStatus)
+{
+   struct Process *psProcess;
+
+   assert(oJobTable != NULL);
+
+   psProcess = *JobTable_find(oJobTable, iPid);
+   if ((psProcess == NULL) || psProcess->iDone)
+      return 0;
+
+   psProcess->iDone = 1;
+   psProcess->iStatus = iStatus;
+   psProcess->psJob->uRunning--;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If iPid is the ID of a process of oJobTable, return 1 (TRUE) if it
+   is running, or else 0 (FALSE) after storing its exit status in
+   *piStatus. If it is not, return -1. */
+
+int JobTable_getState(JobTable_T oJobTable, pid_t iPid, int *piStatus)
+{
+   struct Process *psProcess;
+
+   assert(oJobTable != NULL);
+   assert(piStatus != NULL);
+
+   psProcess = *JobTable_find(oJobTable, iPid);
+   if (psProcess == NULL)
+      return -1;
+   if (! psProcess->iDone)
+      return 1;
+   *piStatus = psProcess->iStatus;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the ID of a running process of oJobTable, or -1 if there is
+   none. */
+
+pid_t JobTable_getRunning(JobTable_T oJobTable)
+{
+   struct Job *psJob;
+   size_t u;
+
+   assert(oJobTable != NULL);
+
+   for (psJob = oJobTable->psJobs; psJob != NULL; psJob = psJob->psNext)
+   {
+      if (psJob->uRunning == 0)
+         continue;
+      for (u = 0; u < psJob->uCount; u++)
+         if (! psJob->ppsProcesses[u]->iDone)
+            return psJob->ppsProcesses[u]->iPid;
+   }
+   return -1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the number, state and description of each job of
+   oJobTable, or only of those that are done if iDoneOnly is TRUE.
+   Then forget the jobs that were written as done. */
+
+void JobTable_write(JobTable_T oJobTable, int iDoneOnly)
+{
+   struct Job **ppsLink;
+   struct Job *psJob;
+
+   assert(oJobTable != NULL);
+
+   ppsLink = &oJobTable->psJobs;
+   while (*ppsLink != NULL)
+   {
+      psJob = *ppsLink;
+      if (psJob->uRunning > 0)
+      {
+         if (! iDoneOnly)
+            printf("[%lu] Running\t%s\n", (unsigned long)psJob->uNumber,
+                   psJob->pcDescription);
+         ppsLink = &psJob->psNext;
+         continue;
+      }
+
+      printf("[%lu] Done\t%s\n", (unsigned long)psJob->uNumber,
+             psJob->pcDescription);
+      JobTable_remove(oJobTable, ppsLink);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Forget the jobs of oJobTable that are done. */
+
+void JobTable_removeDone(JobTable_T oJobTable)
+{
+   struct Job **ppsLink;
+
+   assert(oJobTable != NULL);
+
+   ppsLink = &oJobTable->psJobs;
+   while (*ppsLink != NULL)
+   {
+      if ((*ppsLink)->uRunning == 0)
+         JobTable_remove(oJobTable, ppsLink);
+      else
+         ppsLink = &(*ppsLink)->psNext;
+   }
+}
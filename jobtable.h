@@ -0,0 +1,80 @@
+/*--------------------------------------------------------------------*/
+/* jobtable.h                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef JOBTABLE_INCLUDED
+#define JOBTABLE_INCLUDED
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A JobTable object keeps track of the jobs running in the background:
+   the processes of each one, by process ID, and their exit statuses
+   once they are done. */
+
+typedef struct JobTable *JobTable_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty JobTable object, or NULL if insufficient memory
+   is available. */
+
+JobTable_T JobTable_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oJobTable. */
+
+void JobTable_free(JobTable_T oJobTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Add to oJobTable a job made of the uCount running processes whose
+   IDs are in piPids, the last of which gives the job's exit status,
+   and which is described by string pcDescription. Return the job's
+   number. */
+
+size_t JobTable_add(JobTable_T oJobTable, const pid_t *piPids,
+   size_t uCount, const char *pcDescription);
+
+/*--------------------------------------------------------------------*/
+
+/* Record that the process of oJobTable whose ID is iPid is done, with
+   exit status iStatus. Return 1 (TRUE) if iPid is a running process
+   of oJobTable, or 0 (FALSE) otherwise. */
+
+int JobTable_setDone(JobTable_T oJobTable, pid_t iPid, int iStatus);
+
+/*--------------------------------------------------------------------*/
+
+/* If iPid is the ID of a process of oJobTable, return 1 (TRUE) if it
+   is running, or else 0 (FALSE) after storing its exit status in
+   *piStatus. If it is not, return -1. */
+
+int JobTable_getState(JobTable_T oJobTable, pid_t iPid, int *piStatus);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the ID of a running process of oJobTable, or -1 if there is
+   none. */
+
+pid_t JobTable_getRunning(JobTable_T oJobTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the number, state and description of each job of
+   oJobTable, or only of those that are done if iDoneOnly is TRUE.
+   Then forget the jobs that were written as done. */
+
+void JobTable_write(JobTable_T oJobTable, int iDoneOnly);
+
+/*--------------------------------------------------------------------*/
+
+/* Forget the jobs of oJobTable that are done. */
+
+void JobTable_removeDone(JobTable_T oJobTable);
+
+#endif
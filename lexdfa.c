@@ -3,11 +3,10 @@
 /* Author: Isaac Wolfe                                                */
 /*--------------------------------------------------------------------*/
 
-#include "dynarray.h"
 #include "token.h"
 #include "lexdfa.h"
+#include "lexscan.h"
 #include "ish.h"
-#include <ctype.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -15,311 +14,559 @@
 
 /*--------------------------------------------------------------------*/
 
+enum {FALSE, TRUE};
 
-/* Write all tokens in oTokens to stdout.  First write the number
-   tokens; then write the word tokens. */
+/*--------------------------------------------------------------------*/
+
+
+/* Write all tokens in oTokens to stdout. */
 
-void LexDFA_writeTokens(DynArray_T oTokens)
+void LexDFA_writeTokens(TokenList_T oTokens)
 {
    size_t u;
    size_t uLength;
-   struct Token *psToken;
 
    assert(oTokens != NULL);
 
-   uLength = DynArray_getLength(oTokens);
+   uLength = TokenList_getLength(oTokens);
 
    for (u = 0; u < uLength; u++)
+      TokenList_writeToken(oTokens, u);
+}
+
+
+/*--------------------------------------------------------------------*/
+
+/* The states of the DFA that LexDFA_lexChars() runs. */
+
+enum LexState {STATE_START, STATE_IN_TOKEN, STATE_IN_LITERAL, 
+   STATE_SPECIAL, STATE_END_LITERAL, STATE_PAIR, STATE_IN_SLITERAL,
+   STATE_COUNT};
+
+/* The classes of characters that the DFA tells apart.  The end of the
+   line reads as a null character, of class CLASS_END.  A special
+   character of class CLASS_PAIR may be doubled into a special token
+   of two characters, as in "&&" and "||".  CLASS_QUOTE is the double
+   quote and CLASS_SQUOTE the single quote.  CLASS_ESCAPED, the '$'
+   that starts an expansion and the backslash that escapes one, is
+   ordinary but inside single quotes. */
+
+enum CharClass {CLASS_OTHER, CLASS_SPACE, CLASS_SPECIAL, CLASS_QUOTE,
+   CLASS_END, CLASS_PAIR, CLASS_SQUOTE, CLASS_ESCAPED, CLASS_COUNT};
+
+/* The actions that a transition of the DFA may take, as bits.  An
+   emitted token is the text accumulated so far; the character just
+   read is appended after any token is emitted.  ACTION_MORE ends a
+   line inside a literal, which may continue on the next line.
+   ACTION_ESCAPE appends a backslash before the character, so that a
+   '$' or a backslash inside single quotes reaches the shell as "\$"
+   or "\\", which it takes as the character itself. */
+
+enum
+{
+   ACTION_APPEND = 1,
+   ACTION_EMIT_ORDINARY = 2,
+   ACTION_EMIT_SPECIAL = 4,
+   ACTION_DONE = 8,
+   ACTION_MORE = 16,
+   ACTION_ESCAPE = 32
+};
+
+/* A transition of the DFA: the next state and the actions to take. */
+
+struct Transition
+{
+   unsigned char ucNextState;
+   unsigned char ucActions;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The class of each character, indexed by the character as an
+   unsigned char.  These are the characters for which isspace() is
+   true in the "C" locale. */
+
+static const unsigned char aucCharClasses[256] =
+{
+   ['\0'] = CLASS_END,
+   [' '] = CLASS_SPACE, ['\t'] = CLASS_SPACE, ['\n'] = CLASS_SPACE,
+   ['\v'] = CLASS_SPACE, ['\f'] = CLASS_SPACE, ['\r'] = CLASS_SPACE,
+   ['<'] = CLASS_SPECIAL, ['>'] = CLASS_SPECIAL, [';'] = CLASS_SPECIAL,
+   ['|'] = CLASS_PAIR, ['&'] = CLASS_PAIR,
+   ['"'] = CLASS_QUOTE, ['\''] = CLASS_SQUOTE, ['$'] = CLASS_ESCAPED,
+   ['\\'] = CLASS_ESCAPED
+};
+
+/* The transitions of the DFA, indexed by state and character class.
+   A special character right after a closing quote ends the ordinary
+   token and starts a special one, as it does after any other
+   ordinary token.  STATE_PAIR holds the first character of a special
+   token that may take a second.  Only the same character again makes
+   a token of two, so LexDFA_run() reads any other character of class
+   CLASS_PAIR there as if from STATE_SPECIAL.  STATE_IN_SLITERAL is
+   inside single quotes, where every character but the closing quote
+   is taken as it is, and a literal of either kind ends in
+   STATE_END_LITERAL. */
+
+static const struct Transition asTransitions[STATE_COUNT][CLASS_COUNT] =
+{
+   /* STATE_START */
+   {
+      {STATE_IN_TOKEN, ACTION_APPEND},
+      {STATE_START, 0},
+      {STATE_SPECIAL, ACTION_APPEND},
+      {STATE_IN_LITERAL, 0},
+      {STATE_START, ACTION_DONE},
+      {STATE_PAIR, ACTION_APPEND},
+      {STATE_IN_SLITERAL, 0},
+      {STATE_IN_TOKEN, ACTION_APPEND}
+   },
+   /* STATE_IN_TOKEN */
+   {
+      {STATE_IN_TOKEN, ACTION_APPEND},
+      {STATE_START, ACTION_EMIT_ORDINARY},
+      {STATE_SPECIAL, ACTION_EMIT_ORDINARY | ACTION_APPEND},
+      {STATE_IN_LITERAL, 0},
+      {STATE_START, ACTION_EMIT_ORDINARY | ACTION_DONE},
+      {STATE_PAIR, ACTION_EMIT_ORDINARY | ACTION_APPEND},
+      {STATE_IN_SLITERAL, 0},
+      {STATE_IN_TOKEN, ACTION_APPEND}
+   },
+   /* STATE_IN_LITERAL */
    {
-   	psToken = DynArray_get(oTokens, u);
-   	Token_writeToken(psToken);
+      {STATE_IN_LITERAL, ACTION_APPEND},
+      {STATE_IN_LITERAL, ACTION_APPEND},
+      {STATE_IN_LITERAL, ACTION_APPEND},
+      {STATE_END_LITERAL, 0},
+      {STATE_IN_LITERAL, ACTION_MORE},
+      {STATE_IN_LITERAL, ACTION_APPEND},
+      {STATE_IN_LITERAL, ACTION_APPEND},
+      {STATE_IN_LITERAL, ACTION_APPEND}
+   },
+   /* STATE_SPECIAL */
+   {
+      {STATE_IN_TOKEN, ACTION_EMIT_SPECIAL | ACTION_APPEND},
+      {STATE_START, ACTION_EMIT_SPECIAL},
+      {STATE_SPECIAL, ACTION_EMIT_SPECIAL | ACTION_APPEND},
+      {STATE_IN_LITERAL, ACTION_EMIT_SPECIAL},
+      {STATE_START, ACTION_EMIT_SPECIAL | ACTION_DONE},
+      {STATE_PAIR, ACTION_EMIT_SPECIAL | ACTION_APPEND},
+      {STATE_IN_SLITERAL, ACTION_EMIT_SPECIAL},
+      {STATE_IN_TOKEN, ACTION_EMIT_SPECIAL | ACTION_APPEND}
+   },
+   /* STATE_END_LITERAL */
+   {
+      {STATE_IN_TOKEN, ACTION_APPEND},
+      {STATE_START, ACTION_EMIT_ORDINARY},
+      {STATE_SPECIAL, ACTION_EMIT_ORDINARY | ACTION_APPEND},
+      {STATE_IN_LITERAL, 0},
+      {STATE_START, ACTION_EMIT_ORDINARY | ACTION_DONE},
+      {STATE_PAIR, ACTION_EMIT_ORDINARY | ACTION_APPEND},
+      {STATE_IN_SLITERAL, 0},
+      {STATE_IN_TOKEN, ACTION_APPEND}
+   },
+   /* STATE_PAIR */
+   {
+      {STATE_IN_TOKEN, ACTION_EMIT_SPECIAL | ACTION_APPEND},
+      {STATE_START, ACTION_EMIT_SPECIAL},
+      {STATE_SPECIAL, ACTION_EMIT_SPECIAL | ACTION_APPEND},
+      {STATE_IN_LITERAL, ACTION_EMIT_SPECIAL},
+      {STATE_START, ACTION_EMIT_SPECIAL | ACTION_DONE},
+      {STATE_SPECIAL, ACTION_APPEND},
+      {STATE_IN_SLITERAL, ACTION_EMIT_SPECIAL},
+      {STATE_IN_TOKEN, ACTION_EMIT_SPECIAL | ACTION_APPEND}
+   },
+   /* STATE_IN_SLITERAL */
+   {
+      {STATE_IN_SLITERAL, ACTION_APPEND},
+      {STATE_IN_SLITERAL, ACTION_APPEND},
+      {STATE_IN_SLITERAL, ACTION_APPEND},
+      {STATE_IN_SLITERAL, ACTION_APPEND},
+      {STATE_IN_SLITERAL, ACTION_MORE},
+      {STATE_IN_SLITERAL, ACTION_APPEND},
+      {STATE_END_LITERAL, 0},
+      {STATE_IN_SLITERAL, ACTION_APPEND | ACTION_ESCAPE}
    }
-}
+};
 
 /*--------------------------------------------------------------------*/
 
-/* Free all of the tokens in oTokens. */
+/* A LexDFA is a lexical analysis in progress between lines: the
+   state of the DFA, the text that has been accumulated for its
+   tokens, and where those tokens go. */
 
-void LexDFA_freeTokens(DynArray_T oTokens)
+struct LexDFA
 {
-   size_t u;
-   size_t uLength;
-   struct Token *psToken;
+   /* The current state of the DFA. */
+   unsigned char ucState;
 
-   assert(oTokens != NULL);
+   /* The buffer in which the characters comprising each token are
+      accumulated, or NULL if no line has been read, and the number
+      of characters that it has room for. */
+   char *pcText;
+   size_t ulTextLength;
 
-   uLength = DynArray_getLength(oTokens);
+   /* The index in pcText where the current token starts, and the
+      index of the next character to accumulate. */
+   size_t ulTokenStart;
+   size_t ulTextIndex;
 
-   for (u = 0; u < uLength; u++)
+   /* Whether the current token holds a quoted literal. */
+   int iQuoted;
+
+   /* The tokens found so far, if they are collected into a list,
+      whose text buffer is pcText. */
+   TokenList_T oTokens;
+
+   /* Otherwise the function to which each token is handed as soon as
+      it is found, and the extra argument to pass it. */
+   LexDFA_TokenFunction pfToken;
+   void *pvExtra;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in psLexDFA, with memory from oArena, for the tokens of a
+   line of uLength characters.  Every token takes at least one
+   character of the line, and its text takes no more characters of
+   the line than that plus a null character, or than twice that when
+   every character is a '$' or a backslash inside single quotes.  A
+   literal continued from the previous line also takes the newline
+   that ended that line.  The room grows geometrically, so a literal
+   spanning many lines costs time linear in its length. */
+
+static void LexDFA_reserve(struct LexDFA *psLexDFA, Arena_T oArena,
+   size_t uLength)
+{
+   size_t ulPartialLength;
+   size_t ulTextLength;
+   char *pcText;
+
+   assert(psLexDFA != NULL);
+
+   if (psLexDFA->pfToken == NULL)
    {
-      psToken = DynArray_get(oTokens, u);
-      Token_freeToken(psToken);
+      psLexDFA->oTokens = TokenList_reserve(oArena, psLexDFA->oTokens,
+         psLexDFA->ulTextIndex, uLength, 2 * uLength + 2);
+      psLexDFA->pcText = TokenList_getText(psLexDFA->oTokens);
+      return;
    }
+
+   /* The tokens already handed out keep their text where it is, so
+      only the current token moves to a larger buffer. */
+   ulPartialLength = psLexDFA->ulTextIndex - psLexDFA->ulTokenStart;
+   if ((psLexDFA->pcText != NULL) &&
+       (psLexDFA->ulTextLength - psLexDFA->ulTextIndex >=
+        2 * uLength + 2))
+      return;
+
+   ulTextLength = 2 * psLexDFA->ulTextLength;
+   if (ulTextLength < ulPartialLength + 2 * uLength + 2)
+      ulTextLength = ulPartialLength + 2 * uLength + 2;
+   pcText = (char*)Arena_alloc(oArena, ulTextLength);
+   if (ulPartialLength > 0)
+      memcpy(pcText, psLexDFA->pcText + psLexDFA->ulTokenStart,
+             ulPartialLength);
+
+   psLexDFA->pcText = pcText;
+   psLexDFA->ulTextLength = ulTextLength;
+   psLexDFA->ulTokenStart = 0;
+   psLexDFA->ulTextIndex = ulPartialLength;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Lexically analyze string pcLine.  If pcLine contains a lexical
-   error, then return NULL.  Otherwise return a DynArray object
-   containing the tokens in pcLine.  The caller owns the DynArray
-   object and the tokens that it contains. */
+/* Hand to psLexDFA a token whose type is eTokenType and whose value
+   is the text of psLexDFA from *pulTokenStart up to *pulTextIndex,
+   or TOKEN_QUOTED instead of TOKEN_ORDINARY if it holds a quoted
+   literal. Terminate the value with a null character, and start the
+   next token's text after it. */
 
-DynArray_T LexDFA_lexLine(const char *pcLine)
+static void LexDFA_addToken(struct LexDFA *psLexDFA,
+   enum TokenType eTokenType, size_t *pulTokenStart,
+   size_t *pulTextIndex)
 {
-   /* lexLine() uses a DFA approach.  It "reads" its characters from
-      pcLine. The DFA has these three states: */
-   enum LexState {STATE_START, STATE_IN_TOKEN, STATE_IN_LITERAL, 
-   	STATE_SPECIAL, STATE_END_LITERAL};
+   assert(psLexDFA != NULL);
+   assert(pulTokenStart != NULL);
+   assert(pulTextIndex != NULL);
+
+   if ((eTokenType == TOKEN_ORDINARY) && psLexDFA->iQuoted)
+      eTokenType = TOKEN_QUOTED;
+   psLexDFA->iQuoted = FALSE;
+   psLexDFA->pcText[*pulTextIndex] = '\0';
+   if (psLexDFA->pfToken == NULL)
+      TokenList_add(psLexDFA->oTokens, eTokenType, *pulTokenStart,
+                    *pulTextIndex - *pulTokenStart);
+   else
+      (*psLexDFA->pfToken)(eTokenType,
+         psLexDFA->pcText + *pulTokenStart, psLexDFA->pvExtra);
+   (*pulTextIndex)++;
+   *pulTokenStart = *pulTextIndex;
+}
 
-   /* The current state of the DFA. */
-   enum LexState eState = STATE_START;
+/*--------------------------------------------------------------------*/
+
+/* Continue the analysis psLexDFA with the uLength characters at
+   pcLine, with memory from oArena.  Return 1 (TRUE) if the analysis
+   is complete, or 0 (FALSE) if pcLine ends inside a literal, so that
+   the analysis needs the next line. */
+
+static int LexDFA_run(struct LexDFA *psLexDFA, Arena_T oArena,
+   const char *pcLine, size_t uLength)
+{
+   /* run() uses a table-driven DFA approach.  It "reads" its
+      characters from pcLine, and each one costs a lookup of its
+      class and of the transition from the current state. */
+   unsigned char ucState;
+   const struct Transition *psTransition;
 
-   /* An index into pcLine, a pointer to a buffer of text 
+   /* An index into pcLine, a pointer to the buffer of text 
       in which the characters comprising each token are 
-      accumulated, and an index into the buffer of text. */ 
-   size_t ulLineIndex = 0;
+      accumulated, the index in it where the current token
+      starts, and an index into the buffer of text. */ 
+   size_t ulLineIndex;
    char *pcText;
-   int ulTextIndex = 0;
+   size_t ulTokenStart;
+   size_t ulTextIndex;
 
    char c;
-   struct Token *psToken;
-   DynArray_T oTokens;
-   int iSuccessful;
+   unsigned char ucClass;
+   size_t ulRunLength;
 
+   assert(psLexDFA != NULL);
    assert(pcLine != NULL);
 
-   /* Create an empty token DynArray object. */
-   oTokens = DynArray_new(0);
-   if (oTokens == NULL)
-      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   LexDFA_reserve(psLexDFA, oArena, uLength);
 
-   /* Allocate memory for a buffer that is large enough to store the
-      largest token that might appear within pcLine. */
-   pcText = (char*)malloc(strlen(pcLine) + 1);
-   if (pcText == NULL)
-      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   pcText = psLexDFA->pcText;
+   ucState = psLexDFA->ucState;
+   ulTokenStart = psLexDFA->ulTokenStart;
+   ulTextIndex = psLexDFA->ulTextIndex;
+   if ((ucState == STATE_IN_LITERAL) || (ucState == STATE_IN_SLITERAL))
+      pcText[ulTextIndex++] = '\n';
 
-   for (;;)
+   for (ulLineIndex = 0; ; ulLineIndex++)
    {
-      /* "Read" the next character from pcLine. */
-      c = pcLine[ulLineIndex];
-      ulLineIndex++;
-
-      switch (eState)
+      /* "Read" the next character from pcLine.  The end of pcLine
+         reads as a null character. */
+      c = (ulLineIndex < uLength) ? pcLine[ulLineIndex] : '\0';
+      ucClass = aucCharClasses[(unsigned char)c];
+
+      /* "&|" and "|&" are two tokens, unlike "&&" and "||". */
+      if ((ucState == STATE_PAIR) && (ucClass == CLASS_PAIR) &&
+          (c != pcText[ulTextIndex - 1]))
+         ucState = STATE_SPECIAL;
+
+      psTransition = &asTransitions[ucState][ucClass];
+      ucState = psTransition->ucNextState;
+
+      /* Most characters are simply accumulated.  Within a token or
+         a literal, so is the whole run of ordinary characters that
+         follows, which is found many characters at a time. */
+      if (psTransition->ucActions == ACTION_APPEND)
       {
-         /* Handle the START state. */
-         case STATE_START:
-            if (c == '\0')
-            {
-               free(pcText);
-               return oTokens;
-            }
-            else if (isspace(c))
-            {
-            	eState = STATE_START;
-            }
-            else if ((c == '>') || (c == '<'))
-            {
-            	pcText[ulTextIndex++] = c;
-            	eState = STATE_SPECIAL;
-            }
-            else if (c == '\"')
-            {
-            	eState = STATE_IN_LITERAL;
-            }
-            else
-            {
-            	pcText[ulTextIndex++] = c;
-            	eState = STATE_IN_TOKEN;
-            }
-            break;
-
-         /* Handle the IN_NUMBER state. */
-         case STATE_IN_TOKEN:
-            if (c == '\0')
-            {
-               /* Create an ORDINARY token. */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_ORDINARY, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-               free(pcText);
-               return oTokens;
-            }
-            else if (isspace(c))
-            {
-               /* Create an ORDINARY token. */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_ORDINARY, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-               eState = STATE_START;
-            }
-            else if (c == '"')
-            {
-            	eState = STATE_IN_LITERAL;
-            }
-            else if ((c == '<') || c == '>')
-            {
-               /* Create an ORDINARY token. */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_ORDINARY, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-
-               pcText[ulTextIndex++] = c;
-               eState = STATE_SPECIAL;
-            }
-            else
-            {
-            	pcText[ulTextIndex++] = c;
-            	eState = STATE_IN_TOKEN;
-            }
-            break;
-
-         /* Handle the IN_LITERAL state. */
-         case STATE_IN_LITERAL:
-            if (c == '\0')
-            {
-               /* Print umatched quote error. */
-               fprintf(stderr, "%s: unmatched quote\n", pcPgmName);
-               ulTextIndex = 0;
-               free(pcText);
-               LexDFA_freeTokens(oTokens);
-               DynArray_free(oTokens);
-               return NULL;
-            }
-            else if (c == '\"')
-            {
-            	eState = STATE_END_LITERAL;
-            }
-            else
-            {
-               pcText[ulTextIndex++] = c;
-               eState = STATE_IN_LITERAL;
-            }
-            break;
-
-         /* Handle END_LITERAL state. */
-         case STATE_END_LITERAL:
-            if (c == '\0')
-            {
-            	/* Create an ORDINARY token. */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_ORDINARY, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-               free(pcText);
-               return oTokens;
-            }
-            else if (isspace(c))
-            {
-            	/* Create an Ordinary Token */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_ORDINARY, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-  
-               eState = STATE_START;
-            }
-            else if (c == '\"')
-            {
-               eState = STATE_IN_LITERAL;
-            }
-            else if ((c == '<') || (c == '>'))
-            {
-            	/* Create an ORDINARY token. */
-            	pcText[ulTextIndex] = '\0';
-            	psToken = Token_newToken(TOKEN_ORDINARY, pcText);
-            	iSuccessful = DynArray_add(oTokens, psToken);
-            	if (! iSuccessful)
-            		{perror(pcPgmName); exit(EXIT_FAILURE);}
-            	ulTextIndex = 0;
-            	eState = STATE_SPECIAL;
-            }
-            else
-            {
-            	pcText[ulTextIndex++] = c;
-            	eState = STATE_IN_TOKEN;
-            }
-            break;
-
-        /* Handle SPECIAL state. */
-        case STATE_SPECIAL:
-            if (c == '\0')
-            {
-               /* Create a SPECIAL token. */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_SPECIAL, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-               free(pcText);
-               return oTokens;
-            } 
-            else if (isspace(c)) 
-            {
-               /* Create an SPECIAL Token */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_SPECIAL, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-  
-               eState = STATE_START;
-           }
-           else if (c == '\"')
-           {
-           	   /* Create a SPECIAL Token */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_SPECIAL, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-  
-               eState = STATE_IN_LITERAL;
-           }
-           else if ((c == '<') || (c == '>'))
-           {
-           	   /* Create an SPECIAL Token */
-               pcText[ulTextIndex] = '\0';
-               psToken = Token_newToken(TOKEN_SPECIAL, pcText);
-               iSuccessful = DynArray_add(oTokens, psToken);
-               if (! iSuccessful)
-                  {perror(pcPgmName); exit(EXIT_FAILURE);}
-               ulTextIndex = 0;
-
-           	pcText[ulTextIndex++] = c;
-           	eState = STATE_SPECIAL;
-           }
-           else 
-           {
-           		pcText[ulTextIndex] = '\0';
-           		psToken = Token_newToken(TOKEN_SPECIAL, pcText);
-           		iSuccessful = DynArray_add(oTokens, psToken);
-            	if (! iSuccessful)
-            		{perror(pcPgmName); exit(EXIT_FAILURE);}
-            	ulTextIndex = 0;
-            	pcText[ulTextIndex++] = c;
-            	eState = STATE_IN_TOKEN;
-            }
-            break;
-
-         default:
-            assert(0);
+         pcText[ulTextIndex++] = c;
+         if (((ucState == STATE_IN_TOKEN) ||
+              (ucState == STATE_IN_LITERAL)) &&
+             (ulLineIndex + 1 < uLength))
+         {
+            ulRunLength = LexScan_span(pcLine + ulLineIndex + 1,
+                                       uLength - ulLineIndex - 1);
+            memcpy(pcText + ulTextIndex, pcLine + ulLineIndex + 1,
+                   ulRunLength);
+            ulTextIndex += ulRunLength;
+            ulLineIndex += ulRunLength;
+         }
+         continue;
       }
+
+      if (psTransition->ucActions & ACTION_EMIT_ORDINARY)
+         LexDFA_addToken(psLexDFA, TOKEN_ORDINARY, &ulTokenStart,
+                         &ulTextIndex);
+      if (psTransition->ucActions & ACTION_EMIT_SPECIAL)
+         LexDFA_addToken(psLexDFA, TOKEN_SPECIAL, &ulTokenStart,
+                         &ulTextIndex);
+      if ((ucState == STATE_IN_LITERAL) || (ucState == STATE_IN_SLITERAL))
+         psLexDFA->iQuoted = TRUE;
+      if (psTransition->ucActions & ACTION_ESCAPE)
+         pcText[ulTextIndex++] = '\\';
+      if (psTransition->ucActions & ACTION_APPEND)
+         pcText[ulTextIndex++] = c;
+      if (psTransition->ucActions & (ACTION_DONE | ACTION_MORE))
+         break;
    }
-}
\ No newline at end of file
+
+   psLexDFA->ucState = ucState;
+   psLexDFA->ulTokenStart = ulTokenStart;
+   psLexDFA->ulTextIndex = ulTextIndex;
+   return (psTransition->ucActions & ACTION_DONE) != 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Forget the text and tokens of psLexDFA, so that it is ready to
+   analyze a first line. */
+
+static void LexDFA_clear(struct LexDFA *psLexDFA)
+{
+   assert(psLexDFA != NULL);
+
+   psLexDFA->ucState = STATE_START;
+   psLexDFA->pcText = NULL;
+   psLexDFA->ulTextLength = 0;
+   psLexDFA->ulTokenStart = 0;
+   psLexDFA->ulTextIndex = 0;
+   psLexDFA->iQuoted = FALSE;
+   psLexDFA->oTokens = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new LexDFA object, ready to analyze a first line, or NULL
+   if insufficient memory is available. */
+
+LexDFA_T LexDFA_new(void)
+{
+   LexDFA_T oLexDFA;
+
+   oLexDFA = (struct LexDFA*)malloc(sizeof(struct LexDFA));
+   if (oLexDFA == NULL)
+      return NULL;
+
+   LexDFA_clear(oLexDFA);
+   oLexDFA->pfToken = NULL;
+   oLexDFA->pvExtra = NULL;
+   return oLexDFA;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oLexDFA. */
+
+void LexDFA_free(LexDFA_T oLexDFA)
+{
+   free(oLexDFA);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze the uLength characters at pcLine as the next line
+   of oLexDFA, with memory from oArena.  If the line ends inside a
+   quoted literal, return NULL: the partial token is kept, and the
+   next call continues it with the newline that ended this line, so
+   that no line is analyzed twice.  oArena must not be reset until
+   then.  Otherwise return a TokenList object containing the tokens
+   of all of the lines since the last one returned. */
+
+TokenList_T LexDFA_lexMore(LexDFA_T oLexDFA, Arena_T oArena,
+   const char *pcLine, size_t uLength)
+{
+   TokenList_T oTokens;
+
+   assert(oLexDFA != NULL);
+
+   oLexDFA->pfToken = NULL;
+   if (! LexDFA_run(oLexDFA, oArena, pcLine, uLength))
+      return NULL;
+
+   oTokens = oLexDFA->oTokens;
+   LexDFA_clear(oLexDFA);
+   return oTokens;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze the uLength characters at pcLine as the next line
+   of oLexDFA, with memory from oArena, handing each token to
+   (*pfToken)(eType, pcVal, pvExtra) as soon as it is found.
+   No list of tokens is built.  Each token's value is a string that
+   lasts until oArena is reset.  Return 1 (TRUE) if the tokens are
+   complete, or 0 (FALSE) if the line ends inside a quoted literal,
+   which the next call continues as by LexDFA_lexMore. */
+
+int LexDFA_pushLine(LexDFA_T oLexDFA, Arena_T oArena,
+   const char *pcLine, size_t uLength, LexDFA_TokenFunction pfToken,
+   void *pvExtra)
+{
+   assert(oLexDFA != NULL);
+   assert(pfToken != NULL);
+
+   oLexDFA->pfToken = pfToken;
+   oLexDFA->pvExtra = pvExtra;
+   if (! LexDFA_run(oLexDFA, oArena, pcLine, uLength))
+      return 0;
+
+   LexDFA_clear(oLexDFA);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff oLexDFA is inside a literal that continues on
+   the next line, or 0 (FALSE) otherwise. */
+
+int LexDFA_isIncomplete(LexDFA_T oLexDFA)
+{
+   assert(oLexDFA != NULL);
+
+   return (oLexDFA->ucState == STATE_IN_LITERAL) ||
+      (oLexDFA->ucState == STATE_IN_SLITERAL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* End the input of oLexDFA.  If it is inside a literal, report the
+   unmatched quote and discard the partial tokens. */
+
+void LexDFA_finish(LexDFA_T oLexDFA)
+{
+   assert(oLexDFA != NULL);
+
+   if (! LexDFA_isIncomplete(oLexDFA))
+      return;
+
+   fprintf(stderr, "%s: unmatched quote\n", pcPgmName);
+   LexDFA_clear(oLexDFA);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze the uLength characters at pcLine, which need not
+   be terminated by a null character.  If they contain a lexical
+   error, then return NULL.  Otherwise return a TokenList object
+   containing their tokens, allocated from oArena.  However many
+   tokens there are, this takes a single allocation. */
+
+TokenList_T LexDFA_lexChars(Arena_T oArena, const char *pcLine,
+   size_t uLength)
+{
+   struct LexDFA sLexDFA;
+
+   assert(pcLine != NULL);
+
+   LexDFA_clear(&sLexDFA);
+   sLexDFA.pfToken = NULL;
+   sLexDFA.pvExtra = NULL;
+
+   /* A literal may not continue past the end of pcLine. */
+   if (! LexDFA_run(&sLexDFA, oArena, pcLine, uLength))
+   {
+      /* Print umatched quote error. */
+      fprintf(stderr, "%s: unmatched quote\n", pcPgmName);
+      return NULL;
+   }
+   return sLexDFA.oTokens;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze string pcLine.  If pcLine contains a lexical
+   error, then return NULL.  Otherwise return a TokenList object
+   containing the tokens in pcLine, allocated from oArena. */
+
+TokenList_T LexDFA_lexLine(Arena_T oArena, const char *pcLine)
+{
+   assert(pcLine != NULL);
+
+   return LexDFA_lexChars(oArena, pcLine, strlen(pcLine));
+}
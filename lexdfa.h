@@ -6,26 +6,100 @@
 #ifndef LEXDFA_INCLUDED
 #define LEXDFA_INCLUDED
 
+#include "token.h"
+
 /*--------------------------------------------------------------------*/
 
-/* Write all tokens in oTokens to stdout.  First write the number
-   tokens; then write the word tokens. */
+/* A LexDFA object is a lexical analysis in progress, whose quoted
+   literals may span several lines. */
+
+typedef struct LexDFA *LexDFA_T;
 
-void LexDFA_writeTokens(DynArray_T oTokens);
+/* A LexDFA_TokenFunction accepts a token whose type is eType and
+   whose value is the string pcVal, along with an extra argument
+   pvExtra. */
+
+typedef void (*LexDFA_TokenFunction)(enum TokenType eType,
+   char *pcVal, void *pvExtra);
 
 /*--------------------------------------------------------------------*/
 
-/* Free all of the tokens in oTokens. */
+/* Write all tokens in oTokens to stdout. */
+
+void LexDFA_writeTokens(TokenList_T oTokens);
 
-void LexDFA_freeTokens(DynArray_T oTokens);
 
 /*--------------------------------------------------------------------*/
 
 /* Lexically analyze string pcLine.  If pcLine contains a lexical
-   error, then return NULL.  Otherwise return a DynArray object
-   containing the tokens in pcLine.  The caller owns the DynArray
-   object and the tokens that it contains. */
+   error, then return NULL.  Otherwise return a TokenList object
+   containing the tokens in pcLine, allocated from oArena. */
+
+TokenList_T LexDFA_lexLine(Arena_T oArena, const char *pcLine);
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze the uLength characters at pcLine, which need not
+   be terminated by a null character.  If they contain a lexical
+   error, then return NULL.  Otherwise return a TokenList object
+   containing their tokens, allocated from oArena.  However many
+   tokens there are, this takes a single allocation. */
+
+TokenList_T LexDFA_lexChars(Arena_T oArena, const char *pcLine,
+   size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new LexDFA object, ready to analyze a first line, or NULL
+   if insufficient memory is available. */
+
+LexDFA_T LexDFA_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oLexDFA. */
+
+void LexDFA_free(LexDFA_T oLexDFA);
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze the uLength characters at pcLine as the next line
+   of oLexDFA, with memory from oArena.  If the line ends inside a
+   quoted literal, return NULL: the partial token is kept, and the
+   next call continues it with the newline that ended this line, so
+   that no line is analyzed twice.  oArena must not be reset until
+   then.  Otherwise return a TokenList object containing the tokens
+   of all of the lines since the last one returned. */
+
+TokenList_T LexDFA_lexMore(LexDFA_T oLexDFA, Arena_T oArena,
+   const char *pcLine, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Lexically analyze the uLength characters at pcLine as the next line
+   of oLexDFA, with memory from oArena, handing each token to
+   (*pfToken)(eType, pcVal, pvExtra) as soon as it is found.
+   No list of tokens is built.  Each token's value is a string that
+   lasts until oArena is reset.  Return 1 (TRUE) if the tokens are
+   complete, or 0 (FALSE) if the line ends inside a quoted literal,
+   which the next call continues as by LexDFA_lexMore. */
+
+int LexDFA_pushLine(LexDFA_T oLexDFA, Arena_T oArena,
+   const char *pcLine, size_t uLength, LexDFA_TokenFunction pfToken,
+   void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff oLexDFA is inside a literal that continues on
+   the next line, or 0 (FALSE) otherwise. */
+
+int LexDFA_isIncomplete(LexDFA_T oLexDFA);
+
+/*--------------------------------------------------------------------*/
+
+/* End the input of oLexDFA.  If it is inside a literal, report the
+   unmatched quote and discard the partial tokens. */
 
-DynArray_T LexDFA_lexLine(const char *pcLine);
+void LexDFA_finish(LexDFA_T oLexDFA);
 
 #endif
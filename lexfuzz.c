@@ -0,0 +1,197 @@
+/*--------------------------------------------------------------------*/
+/* lexfuzz.c                                                          */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "arena.h"
+#include "token.h"
+#include "lexdfa.h"
+#include "lexscan.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The name of the executable binary file. */
+const char *pcPgmName;
+
+/*--------------------------------------------------------------------*/
+
+/* The longest buffer to try: every length up to three times the
+   widest vector, so that each method meets every remainder. */
+enum {MAX_LENGTH = 3 * 32 + 1};
+
+/* The number of alignments at which each buffer is tried. */
+enum {ALIGNMENTS = 32};
+
+/* The characters that matter to the lexer, which the random buffers
+   draw on half of the time: delimiters, quotes, the special
+   characters, the null character, and a few ordinary ones. */
+static const char acInteresting[] =
+	" \t\n\v\f\r\"<>|&;'$*?[\\ab\0";
+
+/* The names of the methods of LexScan_span(), by enum LexScanMethod. */
+static const char *apcMethods[] = {"scalar", "swar", "sse2", "avx2"};
+
+/*--------------------------------------------------------------------*/
+
+/* Fill the uLength characters at pcChars with random characters. */
+
+static void fillRandom(char *pcChars, size_t uLength)
+{
+	size_t u;
+
+	assert(pcChars != NULL);
+
+	for (u = 0; u < uLength; u++)
+	{
+		if (rand() % 2 == 0)
+			pcChars[u] = acInteresting[(size_t)rand() %
+				sizeof(acInteresting)];
+		else
+			pcChars[u] = (char)(rand() % 256);
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength characters at pcChars to stdout in hexadecimal,
+   after the name of the method that disagreed, pcMethod. */
+
+static void writeCase(const char *pcMethod, const char *pcChars,
+	size_t uLength)
+{
+	size_t u;
+
+	assert(pcMethod != NULL);
+	assert(pcChars != NULL);
+
+	printf("%s disagrees with scalar on %lu bytes:", pcMethod,
+		(unsigned long)uLength);
+	for (u = 0; u < uLength; u++)
+		printf(" %02x", (unsigned)(unsigned char)pcChars[u]);
+	printf("\n");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff oTokens1 and oTokens2 hold the same tokens, or
+   are both NULL after a lexical error, or 0 (FALSE) otherwise. */
+
+static int sameTokens(TokenList_T oTokens1, TokenList_T oTokens2)
+{
+	size_t u;
+	size_t uLength;
+
+	if ((oTokens1 == NULL) || (oTokens2 == NULL))
+		return oTokens1 == oTokens2;
+
+	uLength = TokenList_getLength(oTokens1);
+	if (TokenList_getLength(oTokens2) != uLength)
+		return 0;
+	for (u = 0; u < uLength; u++)
+	{
+		if ((TokenList_getType(oTokens1, u) !=
+				TokenList_getType(oTokens2, u)) ||
+			(TokenList_getValLength(oTokens1, u) !=
+				TokenList_getValLength(oTokens2, u)) ||
+			(memcmp(TokenList_getVal(oTokens1, u),
+				TokenList_getVal(oTokens2, u),
+				TokenList_getValLength(oTokens1, u)) != 0))
+			return 0;
+	}
+	return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Program main that returns an int.
+   int argc is the number of arguments, *argv[] an array of the
+   arguments. Check LexScan_span() and LexDFA_lexChars() with each
+   vector method that the CPU supports against the scalar method, on
+   random buffers of every length up to MAX_LENGTH at every alignment.
+   argv[1], if given, is the number of rounds, and argv[2] the random
+   seed. Return 0 iff all of the methods agree. */
+
+int main(int argc, char *argv[])
+{
+	static char acBuffer[ALIGNMENTS + MAX_LENGTH];
+	const char *pcChars;
+	long lRounds = 200;
+	long lRound;
+	size_t uLength;
+	size_t uAlign;
+	size_t uExpected;
+	int aiSupported[LEXSCAN_AVX2 + 1];
+	int iMethod;
+	int iFailures = 0;
+	unsigned long ulCases = 0;
+	TokenList_T oExpected;
+	TokenList_T oTokens;
+	Arena_T oArena;
+
+	pcPgmName = argv[0];
+
+	if (argc > 1) lRounds = atol(argv[1]);
+	srand((argc > 2) ? (unsigned)atol(argv[2]) : 1U);
+
+	for (iMethod = LEXSCAN_SCALAR; iMethod <= LEXSCAN_AVX2; iMethod++)
+		aiSupported[iMethod] =
+			LexScan_setMethod((enum LexScanMethod)iMethod);
+
+	oArena = Arena_new();
+	if (oArena == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	/* The lexer reports the errors that it finds to stderr. */
+	if (freopen("/dev/null", "w", stderr) == NULL)
+		{perror(pcPgmName); exit(EXIT_FAILURE);}
+
+	for (lRound = 0; lRound < lRounds; lRound++)
+	{
+		for (uLength = 0; uLength <= MAX_LENGTH; uLength++)
+		{
+			for (uAlign = 0; uAlign < ALIGNMENTS; uAlign++)
+			{
+				pcChars = acBuffer + uAlign;
+				fillRandom(acBuffer + uAlign, uLength);
+				ulCases++;
+
+				(void)LexScan_setMethod(LEXSCAN_SCALAR);
+				uExpected = LexScan_span(pcChars, uLength);
+				oExpected = LexDFA_lexChars(oArena, pcChars, uLength);
+
+				for (iMethod = LEXSCAN_SWAR; iMethod <= LEXSCAN_AVX2;
+					iMethod++)
+				{
+					if (! aiSupported[iMethod])
+						continue;
+					(void)LexScan_setMethod((enum LexScanMethod)iMethod);
+					oTokens = LexDFA_lexChars(oArena, pcChars, uLength);
+					if ((LexScan_span(pcChars, uLength) != uExpected) ||
+						(! sameTokens(oExpected, oTokens)))
+					{
+						writeCase(apcMethods[iMethod], pcChars, uLength);
+						iFailures++;
+					}
+				}
+				Arena_reset(oArena);
+			}
+		}
+	}
+
+	printf("%lu cases:", ulCases);
+	for (iMethod = LEXSCAN_SWAR; iMethod <= LEXSCAN_AVX2; iMethod++)
+		printf(" %s%s", apcMethods[iMethod],
+			aiSupported[iMethod] ? "" : " (unsupported)");
+	if (iFailures == 0)
+		printf(" agree with scalar\n");
+	else
+		printf(" disagree with scalar %d times\n", iFailures);
+
+	Arena_free(oArena);
+	return (iFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
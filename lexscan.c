@@ -0,0 +1,269 @@
+/*--------------------------------------------------------------------*/
+/* lexscan.c                                                          */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "lexscan.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LEXSCAN_X86
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff c delimits a run of ordinary characters. */
+
+static int LexScan_isDelimiter(unsigned char c)
+{
+   return (c == ' ') || ((c >= '\t') && (c <= '\r')) || (c == '"') ||
+      (c == '\'') || (c == '<') || (c == '>') || (c == '|') ||
+      (c == '&') || (c == ';') || (c == '\0');
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the span of ordinary characters at pcChars, examining one
+   character at a time. */
+
+static size_t LexScan_spanScalar(const char *pcChars, size_t uLength)
+{
+   size_t u = 0;
+
+   while ((u < uLength) &&
+          (! LexScan_isDelimiter((unsigned char)pcChars[u])))
+      u++;
+   return u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a word whose high bit is set in each byte where ulWord has a
+   zero byte, possibly also in higher bytes above such a byte. */
+
+static uint64_t LexScan_zeroBytes(uint64_t ulWord)
+{
+   const uint64_t ONES = 0x0101010101010101ULL;
+   const uint64_t HIGHS = 0x8080808080808080ULL;
+
+   return (ulWord - ONES) & ~ulWord & HIGHS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the span of ordinary characters at pcChars, examining eight
+   characters at a time within a 64-bit word. */
+
+static size_t LexScan_spanSwar(const char *pcChars, size_t uLength)
+{
+   const uint64_t ONES = 0x0101010101010101ULL;
+   static const unsigned char aucDelimiters[] =
+      {' ', '\t', '\n', '\v', '\f', '\r', '"', '\'', '<', '>',
+       '|', '&', ';', '\0'};
+
+   size_t u = 0;
+   size_t uDelimiter;
+   uint64_t ulWord;
+   uint64_t ulFound;
+
+   while (u + sizeof(ulWord) <= uLength)
+   {
+      memcpy(&ulWord, pcChars + u, sizeof(ulWord));
+      ulFound = 0;
+      for (uDelimiter = 0; uDelimiter < sizeof(aucDelimiters);
+           uDelimiter++)
+         ulFound |= LexScan_zeroBytes(
+            ulWord ^ (ONES * aucDelimiters[uDelimiter]));
+      if (ulFound != 0)
+         break;
+      u += sizeof(ulWord);
+   }
+   return u + LexScan_spanScalar(pcChars + u, uLength - u);
+}
+
+/*--------------------------------------------------------------------*/
+
+#ifdef LEXSCAN_X86
+
+/* Return the span of ordinary characters at pcChars, examining 16
+   characters at a time with SSE2. */
+
+__attribute__((target("sse2")))
+static size_t LexScan_spanSse2(const char *pcChars, size_t uLength)
+{
+   const __m128i vSpace = _mm_set1_epi8(' ');
+   const __m128i vQuote = _mm_set1_epi8('"');
+   const __m128i vSingleQuote = _mm_set1_epi8('\'');
+   const __m128i vLess = _mm_set1_epi8('<');
+   const __m128i vGreater = _mm_set1_epi8('>');
+   const __m128i vBar = _mm_set1_epi8('|');
+   const __m128i vAmpersand = _mm_set1_epi8('&');
+   const __m128i vSemicolon = _mm_set1_epi8(';');
+   const __m128i vNull = _mm_setzero_si128();
+   const __m128i vTab = _mm_set1_epi8('\t');
+   const __m128i vControlRange = _mm_set1_epi8('\r' - '\t');
+
+   size_t u = 0;
+   __m128i vChars;
+   __m128i vControl;
+   __m128i vFound;
+   int iMask;
+
+   while (u + sizeof(vChars) <= uLength)
+   {
+      vChars = _mm_loadu_si128((const __m128i*)(pcChars + u));
+      vFound = _mm_or_si128(
+         _mm_or_si128(_mm_cmpeq_epi8(vChars, vSpace),
+                      _mm_cmpeq_epi8(vChars, vQuote)),
+         _mm_or_si128(_mm_cmpeq_epi8(vChars, vLess),
+                      _mm_cmpeq_epi8(vChars, vGreater)));
+      vFound = _mm_or_si128(vFound,
+         _mm_or_si128(_mm_cmpeq_epi8(vChars, vBar),
+                      _mm_cmpeq_epi8(vChars, vNull)));
+      vFound = _mm_or_si128(vFound,
+         _mm_or_si128(_mm_cmpeq_epi8(vChars, vAmpersand),
+                      _mm_cmpeq_epi8(vChars, vSemicolon)));
+      vFound = _mm_or_si128(vFound,
+         _mm_cmpeq_epi8(vChars, vSingleQuote));
+
+      /* '\t' through '\r' are those c with (c - '\t') <= 4,
+         compared as unsigned. */
+      vControl = _mm_sub_epi8(vChars, vTab);
+      vFound = _mm_or_si128(vFound, _mm_cmpeq_epi8(
+         _mm_min_epu8(vControl, vControlRange), vControl));
+
+      iMask = _mm_movemask_epi8(vFound);
+      if (iMask != 0)
+         return u + (size_t)__builtin_ctz((unsigned)iMask);
+      u += sizeof(vChars);
+   }
+   return u + LexScan_spanScalar(pcChars + u, uLength - u);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the span of ordinary characters at pcChars, examining 32
+   characters at a time with AVX2. */
+
+__attribute__((target("avx2")))
+static size_t LexScan_spanAvx2(const char *pcChars, size_t uLength)
+{
+   const __m256i vSpace = _mm256_set1_epi8(' ');
+   const __m256i vQuote = _mm256_set1_epi8('"');
+   const __m256i vSingleQuote = _mm256_set1_epi8('\'');
+   const __m256i vLess = _mm256_set1_epi8('<');
+   const __m256i vGreater = _mm256_set1_epi8('>');
+   const __m256i vBar = _mm256_set1_epi8('|');
+   const __m256i vAmpersand = _mm256_set1_epi8('&');
+   const __m256i vSemicolon = _mm256_set1_epi8(';');
+   const __m256i vNull = _mm256_setzero_si256();
+   const __m256i vTab = _mm256_set1_epi8('\t');
+   const __m256i vControlRange = _mm256_set1_epi8('\r' - '\t');
+
+   size_t u = 0;
+   __m256i vChars;
+   __m256i vControl;
+   __m256i vFound;
+   unsigned uMask;
+
+   while (u + sizeof(vChars) <= uLength)
+   {
+      vChars = _mm256_loadu_si256((const __m256i*)(pcChars + u));
+      vFound = _mm256_or_si256(
+         _mm256_or_si256(_mm256_cmpeq_epi8(vChars, vSpace),
+                         _mm256_cmpeq_epi8(vChars, vQuote)),
+         _mm256_or_si256(_mm256_cmpeq_epi8(vChars, vLess),
+                         _mm256_cmpeq_epi8(vChars, vGreater)));
+      vFound = _mm256_or_si256(vFound,
+         _mm256_or_si256(_mm256_cmpeq_epi8(vChars, vBar),
+                         _mm256_cmpeq_epi8(vChars, vNull)));
+      vFound = _mm256_or_si256(vFound,
+         _mm256_or_si256(_mm256_cmpeq_epi8(vChars, vAmpersand),
+                         _mm256_cmpeq_epi8(vChars, vSemicolon)));
+      vFound = _mm256_or_si256(vFound,
+         _mm256_cmpeq_epi8(vChars, vSingleQuote));
+
+      vControl = _mm256_sub_epi8(vChars, vTab);
+      vFound = _mm256_or_si256(vFound, _mm256_cmpeq_epi8(
+         _mm256_min_epu8(vControl, vControlRange), vControl));
+
+      uMask = (unsigned)_mm256_movemask_epi8(vFound);
+      if (uMask != 0)
+         return u + (size_t)__builtin_ctz(uMask);
+      u += sizeof(vChars);
+   }
+   return LexScan_spanSse2(pcChars + u, uLength - u) + u;
+}
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The implementation of LexScan_span() chosen for this CPU, or NULL
+   until the first call. */
+
+static size_t (*pfSpan)(const char *pcChars, size_t uLength) = NULL;
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of characters at the start of the uLength
+   characters at pcChars that are ordinary, that is, that are neither
+   white space, '"', '\'', '<', '>', '|', '&', ';' nor the null
+   character.  The characters are scanned many at a time, with the
+   widest vector instructions that the CPU supports. */
+
+size_t LexScan_span(const char *pcChars, size_t uLength)
+{
+   assert(pcChars != NULL);
+
+   if (pfSpan == NULL)
+   {
+      pfSpan = LexScan_spanSwar;
+#ifdef LEXSCAN_X86
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+         pfSpan = LexScan_spanAvx2;
+      else if (__builtin_cpu_supports("sse2"))
+         pfSpan = LexScan_spanSse2;
+#endif
+   }
+   return (*pfSpan)(pcChars, uLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make LexScan_span() scan by method eMethod, so that the methods can
+   be checked against each other. Return 1 (TRUE) if the CPU supports
+   eMethod, or 0 (FALSE), leaving the method unchanged, otherwise. */
+
+int LexScan_setMethod(enum LexScanMethod eMethod)
+{
+   switch (eMethod)
+   {
+      case LEXSCAN_SCALAR:
+         pfSpan = LexScan_spanScalar;
+         return 1;
+      case LEXSCAN_SWAR:
+         pfSpan = LexScan_spanSwar;
+         return 1;
+#ifdef LEXSCAN_X86
+      case LEXSCAN_SSE2:
+         __builtin_cpu_init();
+         if (! __builtin_cpu_supports("sse2"))
+            return 0;
+         pfSpan = LexScan_spanSse2;
+         return 1;
+      case LEXSCAN_AVX2:
+         __builtin_cpu_init();
+         if (! __builtin_cpu_supports("avx2"))
+            return 0;
+         pfSpan = LexScan_spanAvx2;
+         return 1;
+#endif
+      default:
+         return 0;
+   }
+}
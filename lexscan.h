@@ -0,0 +1,37 @@
+/*--------------------------------------------------------------------*/
+/* lexscan.h                                                          */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef LEXSCAN_INCLUDED
+#define LEXSCAN_INCLUDED
+
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of characters at the start of the uLength
+   characters at pcChars that are ordinary, that is, that are neither
+   white space, '"', '\'', '<', '>', '|', '&', ';' nor the null
+   character.  The characters are scanned many at a time, with the
+   widest vector instructions that the CPU supports. */
+
+size_t LexScan_span(const char *pcChars, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* The ways in which LexScan_span() can scan: one character at a time,
+   eight at a time within a 64-bit word, or with SSE2 or AVX2. */
+
+enum LexScanMethod {LEXSCAN_SCALAR, LEXSCAN_SWAR, LEXSCAN_SSE2,
+   LEXSCAN_AVX2};
+
+/*--------------------------------------------------------------------*/
+
+/* Make LexScan_span() scan by method eMethod, so that the methods can
+   be checked against each other. Return 1 (TRUE) if the CPU supports
+   eMethod, or 0 (FALSE), leaving the method unchanged, otherwise. */
+
+int LexScan_setMethod(enum LexScanMethod eMethod);
+
+#endif
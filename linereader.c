@@ -3,67 +3,591 @@
 /* Author: Isaac Wolfe                                                */
 /*--------------------------------------------------------------------*/
 
-#include "dynarray.h"
-#include "token.h"
+#define _GNU_SOURCE
+
 #include "ish.h"
 #include "linereader.h"
 #include <assert.h>
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of bytes that a LineReader asks read() for when it is
+   safe to read ahead of the current line. */
+
+static const size_t BLOCK_LENGTH = 65536;
+
+/* The initial physical length of a caller's line buffer. */
+
+static const size_t INITIAL_LINE_LENGTH = 128;
 
 /*--------------------------------------------------------------------*/
 
-/* If no lines remain in psFile, then return NULL. Otherwise read a line
-   of psFile and return it as a string. The string does not contain a
-   terminating newline character. The caller owns the string. */
+/* A LineReader consists of the file descriptor that it reads, a block
+   of bytes read from it, and the bounds of the bytes in the block
+   that have not yet been handed out. A LineReader of a regular file
+   instead maps the whole file and hands out lines from the mapping. */
 
-char *LineReader_read(FILE *psFile)
+struct LineReader
 {
-   const size_t INITIAL_LINE_LENGTH = 2;
-   const size_t GROWTH_FACTOR = 2; 
-        
-   size_t uLineLength = 0;
-   size_t uPhysLineLength = INITIAL_LINE_LENGTH;
-   char *pcLine;
-   int iChar;
+   /* The file descriptor from which lines are read, or -1 if the
+      file is mapped. */
+   int iFd;
 
-   assert(psFile != NULL);
+   /* 1 (TRUE) iff the LineReader must close iFd when freed. */
+   int iOwnsFd;
 
-   /* If no lines remain, return NULL. */
-   if (feof(psFile))
+   /* 1 (TRUE) iff the file is mapped into memory. */
+   int iMapped;
+
+   /* The mapping of the file, its length, and the index of the first
+      byte of the mapping not yet handed out. pcMap is NULL if the
+      file is empty. */
+   const char *pcMap;
+   size_t uMapLength;
+   size_t uMapIndex;
+
+   /* The block of bytes most recently read from iFd. */
+   char *pcBlock;
+
+   /* The number of bytes that each read() asks for. It is 1 when
+      bytes read ahead could neither be given back nor be left
+      unread by a child process, as for sockets. */
+   size_t uReadLength;
+
+   /* A pipe into which tee() copies the bytes waiting in iFd without
+      consuming them, when iFd is a pipe or a FIFO, or -1s otherwise.
+      The bytes in pcBlock then stay in iFd until they are handed out
+      and the block is refilled or synced. */
+   int aiPeek[2];
+
+   /* The index of the first byte of pcBlock not yet handed out. */
+   size_t uStart;
+
+   /* The number of valid bytes in pcBlock. */
+   size_t uEnd;
+
+   /* 1 (TRUE) iff iFd supports lseek(), so that unread bytes can
+      be given back to it. */
+   int iSeekable;
+
+   /* 1 (TRUE) iff read() has reported end-of-file. */
+   int iEof;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Stop oLineReader from peeking at its file descriptor with tee(). */
+
+static void LineReader_closePeek(LineReader_T oLineReader)
+{
+   assert(oLineReader != NULL);
+
+   if (oLineReader->aiPeek[0] == -1)
+      return;
+   (void)close(oLineReader->aiPeek[0]);
+   (void)close(oLineReader->aiPeek[1]);
+   oLineReader->aiPeek[0] = -1;
+   oLineReader->aiPeek[1] = -1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read and discard the first uLength bytes waiting in the pipe of
+   oLineReader, which it has already peeked at. */
+
+static void LineReader_consume(LineReader_T oLineReader,
+   size_t uLength)
+{
+   ssize_t lRead;
+
+   assert(oLineReader != NULL);
+   assert(uLength <= BLOCK_LENGTH);
+
+   while (uLength > 0)
+   {
+      lRead = read(oLineReader->iFd, oLineReader->pcBlock, uLength);
+      if ((lRead == -1) && (errno == EINTR))
+         continue;
+      if (lRead <= 0)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      uLength -= (size_t)lRead;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new LineReader object that reads from file descriptor iFd,
+   or NULL if insufficient memory is available. The LineReader does
+   not own iFd. */
+
+LineReader_T LineReader_new(int iFd)
+{
+   LineReader_T oLineReader;
+   struct stat sStat;
+
+   assert(iFd >= 0);
+
+   oLineReader = (struct LineReader*)malloc(sizeof(struct LineReader));
+   if (oLineReader == NULL)
       return NULL;
-   iChar = fgetc(psFile);
-   if (iChar == EOF)
+
+   /* Read whole blocks only where the bytes read ahead cannot be
+      lost to a child: seekable files can be rewound before a fork,
+      a pipe can be peeked at with tee() and consumed only as far as
+      lines are handed out, and a terminal hands out at most one line
+      per read(). */
+   oLineReader->aiPeek[0] = -1;
+   oLineReader->aiPeek[1] = -1;
+   oLineReader->iSeekable = (lseek(iFd, 0, SEEK_CUR) != (off_t)-1);
+   if (oLineReader->iSeekable || isatty(iFd))
+      oLineReader->uReadLength = BLOCK_LENGTH;
+   else if ((fstat(iFd, &sStat) == 0) && S_ISFIFO(sStat.st_mode)
+            && (pipe2(oLineReader->aiPeek, O_CLOEXEC) == 0))
+      oLineReader->uReadLength = BLOCK_LENGTH;
+   else
+      oLineReader->uReadLength = 1;
+
+   oLineReader->pcBlock = (char*)malloc(oLineReader->uReadLength);
+   if (oLineReader->pcBlock == NULL)
+   {
+      LineReader_closePeek(oLineReader);
+      free(oLineReader);
       return NULL;
+   }
 
-   /* Allocate memory for the string. */
-   pcLine = (char*)malloc(uPhysLineLength);
-   if (pcLine == NULL)
-      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   oLineReader->iFd = iFd;
+   oLineReader->iOwnsFd = 0;
+   oLineReader->iMapped = 0;
+   oLineReader->pcMap = NULL;
+   oLineReader->uMapLength = 0;
+   oLineReader->uMapIndex = 0;
+   oLineReader->uStart = 0;
+   oLineReader->uEnd = 0;
+   oLineReader->iEof = 0;
+   return oLineReader;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new LineReader object that reads from file descriptor iFd
+   in whole blocks, whatever kind of file it is, or NULL if
+   insufficient memory is available. No child process may inherit
+   iFd, since the bytes read ahead are not given back to it. The
+   LineReader does not own iFd. */
+
+LineReader_T LineReader_newPrivate(int iFd)
+{
+   LineReader_T oLineReader;
 
-   /* Read characters into the string. */
-   while ((iChar != '\n') && (iChar != EOF))
+   oLineReader = LineReader_new(iFd);
+   if (oLineReader == NULL)
+      return NULL;
+
+   /* A pipe need not be peeked at, nor a socket read byte by byte. */
+   LineReader_closePeek(oLineReader);
+   if (oLineReader->uReadLength < BLOCK_LENGTH)
    {
-      if (uLineLength == uPhysLineLength)
+      free(oLineReader->pcBlock);
+      oLineReader->uReadLength = BLOCK_LENGTH;
+      oLineReader->pcBlock = (char*)malloc(BLOCK_LENGTH);
+      if (oLineReader->pcBlock == NULL)
       {
-         uPhysLineLength *= GROWTH_FACTOR;
-         pcLine = (char*)realloc(pcLine, uPhysLineLength);
-         if (pcLine == NULL)
-            {perror(pcPgmName); exit(EXIT_FAILURE);}
+         free(oLineReader);
+         return NULL;
       }
-      pcLine[uLineLength] = (char)iChar;
-      uLineLength++;
-      iChar = fgetc(psFile);
+   }
+   return oLineReader;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new LineReader object that reads the file named
+   pcFileName, or NULL if the file cannot be opened (setting errno).
+   A regular file is mapped into memory so that its lines can be read
+   in place; any other file, such as a pipe or a FIFO, is read as a
+   stream. The LineReader owns the file. */
+
+LineReader_T LineReader_open(const char *pcFileName)
+{
+   LineReader_T oLineReader;
+   struct stat sStat;
+   void *pvMap = NULL;
+   int iFd;
+
+   assert(pcFileName != NULL);
+
+   /* Children never see the file, so it may be read ahead freely. */
+   iFd = open(pcFileName, O_RDONLY | O_CLOEXEC);
+   if (iFd == -1)
+      return NULL;
+   if (fstat(iFd, &sStat) == -1)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   /* Fall back to reading a stream from pipes, FIFOs and devices. */
+   if (! S_ISREG(sStat.st_mode))
+   {
+      oLineReader = LineReader_newPrivate(iFd);
+      if (oLineReader == NULL)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      oLineReader->iOwnsFd = 1;
+      return oLineReader;
    }
 
-   /* Append a null character to the string. */
-   if (uLineLength == uPhysLineLength)
+   /* Map the file; pages are faulted in as the lines are reached. */
+   if (sStat.st_size > 0)
    {
-      uPhysLineLength++;
-      pcLine = (char*)realloc(pcLine, uPhysLineLength);
-      if (pcLine == NULL)
+      pvMap = mmap(NULL, (size_t)sStat.st_size, PROT_READ, MAP_PRIVATE,
+                   iFd, 0);
+      if (pvMap == MAP_FAILED)
          {perror(pcPgmName); exit(EXIT_FAILURE);}
+      (void)madvise(pvMap, (size_t)sStat.st_size, MADV_SEQUENTIAL);
+   }
+   (void)close(iFd);
+
+   oLineReader = (struct LineReader*)malloc(sizeof(struct LineReader));
+   if (oLineReader == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   oLineReader->iFd = -1;
+   oLineReader->iOwnsFd = 0;
+   oLineReader->iMapped = 1;
+   oLineReader->pcMap = (const char*)pvMap;
+   oLineReader->uMapLength = (size_t)sStat.st_size;
+   oLineReader->uMapIndex = 0;
+   oLineReader->pcBlock = NULL;
+   oLineReader->uReadLength = 0;
+   oLineReader->uStart = 0;
+   oLineReader->uEnd = 0;
+   oLineReader->aiPeek[0] = -1;
+   oLineReader->aiPeek[1] = -1;
+   oLineReader->iSeekable = 0;
+   oLineReader->iEof = 1;
+   return oLineReader;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oLineReader. */
+
+void LineReader_free(LineReader_T oLineReader)
+{
+   if (oLineReader == NULL)
+      return;
+
+   if (oLineReader->pcMap != NULL)
+      (void)munmap((void*)oLineReader->pcMap, oLineReader->uMapLength);
+   if (oLineReader->aiPeek[0] != -1)
+   {
+      LineReader_sync(oLineReader);
+      LineReader_closePeek(oLineReader);
+   }
+   if (oLineReader->iOwnsFd)
+      (void)close(oLineReader->iFd);
+   free(oLineReader->pcBlock);
+   free(oLineReader);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Consume the block of oLineReader, which has been handed out, and
+   copy the bytes that follow it in the pipe into the block without
+   consuming them. Return the number of bytes copied, 0 at
+   end-of-file, or -1 on error. */
+
+static ssize_t LineReader_peek(LineReader_T oLineReader)
+{
+   ssize_t lCopied;
+   ssize_t lRead;
+   size_t uDone;
+
+   assert(oLineReader != NULL);
+   assert(oLineReader->aiPeek[0] != -1);
+
+   LineReader_consume(oLineReader, oLineReader->uEnd);
+
+   /* tee() waits for bytes, and reports end-of-file once the writers
+      have gone. */
+   do
+      lCopied = tee(oLineReader->iFd, oLineReader->aiPeek[1],
+                    oLineReader->uReadLength, 0);
+   while ((lCopied == -1) && (errno == EINTR));
+   if (lCopied <= 0)
+      return lCopied;
+
+   for (uDone = 0; uDone < (size_t)lCopied; uDone += (size_t)lRead)
+   {
+      lRead = read(oLineReader->aiPeek[0], oLineReader->pcBlock + uDone,
+                   (size_t)lCopied - uDone);
+      if ((lRead == -1) && (errno == EINTR))
+         lRead = 0;
+      else if (lRead <= 0)
+         return -1;
    }
-   pcLine[uLineLength] = '\0';
+   return lCopied;
+}
 
+/*--------------------------------------------------------------------*/
+
+/* Refill the block of oLineReader from its file descriptor. Return 1
+   (TRUE) if any bytes were read, or 0 (FALSE) at end-of-file. */
+
+static int LineReader_fill(LineReader_T oLineReader)
+{
+   ssize_t lRead;
+
+   assert(oLineReader != NULL);
+
+   if (oLineReader->aiPeek[0] != -1)
+      lRead = LineReader_peek(oLineReader);
+   else
+   {
+      do
+         lRead = read(oLineReader->iFd, oLineReader->pcBlock,
+                      oLineReader->uReadLength);
+      while ((lRead == -1) && (errno == EINTR));
+   }
+
+   if (lRead == -1)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   oLineReader->uStart = 0;
+   oLineReader->uEnd = (size_t)lRead;
+   if (lRead == 0)
+   {
+      oLineReader->iEof = 1;
+      return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make the caller-owned buffer *ppcLine, whose physical length is
+   *puPhysLength, large enough to hold uLength characters and a null
+   character. *ppcLine may be NULL initially. */
+
+static void LineReader_reserve(char **ppcLine, size_t *puPhysLength,
+   size_t uLength)
+{
+   const size_t GROWTH_FACTOR = 2;
+
+   assert(ppcLine != NULL);
+   assert(puPhysLength != NULL);
+
+   if (*ppcLine == NULL)
+      *puPhysLength = INITIAL_LINE_LENGTH;
+   else if (uLength < *puPhysLength)
+      return;
+
+   while (uLength >= *puPhysLength)
+      *puPhysLength *= GROWTH_FACTOR;
+   *ppcLine = (char*)realloc(*ppcLine, *puPhysLength);
+   if (*ppcLine == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If no lines remain in the mapping of oLineReader, then return NULL.
+   Otherwise return the next line in place and store its length in
+   *puLength. */
+
+static const char *LineReader_nextMapped(LineReader_T oLineReader,
+   size_t *puLength)
+{
+   const char *pcLine;
+   const char *pcNewline;
+   size_t uRemaining;
+
+   assert(oLineReader != NULL);
+   assert(oLineReader->iMapped);
+
+   uRemaining = oLineReader->uMapLength - oLineReader->uMapIndex;
+   if (uRemaining == 0)
+      return NULL;
+
+   pcLine = oLineReader->pcMap + oLineReader->uMapIndex;
+   pcNewline = (const char*)memchr(pcLine, '\n', uRemaining);
+   if (pcNewline == NULL)
+   {
+      *puLength = uRemaining;
+      oLineReader->uMapIndex += uRemaining;
+   }
+   else
+   {
+      *puLength = (size_t)(pcNewline - pcLine);
+      oLineReader->uMapIndex += *puLength + 1;
+   }
    return pcLine;
-}
\ No newline at end of file
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If no lines remain in the stream of oLineReader, then return NULL.
+   Otherwise read the next line into *ppcLine as LineReader_read does,
+   store its length in *puLength, and return *ppcLine. */
+
+static char *LineReader_readStream(LineReader_T oLineReader,
+   char **ppcLine, size_t *puPhysLength, size_t *puLength)
+{
+   size_t uLineLength = 0;
+   size_t uChunkLength;
+   char *pcChunk;
+   char *pcNewline = NULL;
+   int iAny = 0;
+
+   assert(oLineReader != NULL);
+   assert(! oLineReader->iMapped);
+
+   LineReader_reserve(ppcLine, puPhysLength, 0);
+
+   /* Copy whole runs of the block up to the next newline. */
+   while (pcNewline == NULL)
+   {
+      if (oLineReader->uStart == oLineReader->uEnd)
+      {
+         if (oLineReader->iEof || (! LineReader_fill(oLineReader)))
+            break;
+      }
+      iAny = 1;
+
+      pcChunk = oLineReader->pcBlock + oLineReader->uStart;
+      uChunkLength = oLineReader->uEnd - oLineReader->uStart;
+      pcNewline = (char*)memchr(pcChunk, '\n', uChunkLength);
+      if (pcNewline != NULL)
+         uChunkLength = (size_t)(pcNewline - pcChunk);
+
+      LineReader_reserve(ppcLine, puPhysLength,
+                         uLineLength + uChunkLength);
+      memcpy(*ppcLine + uLineLength, pcChunk, uChunkLength);
+      uLineLength += uChunkLength;
+      oLineReader->uStart += uChunkLength;
+      if (pcNewline != NULL)
+         oLineReader->uStart++;
+   }
+
+   /* If no lines remain, return NULL. */
+   if (! iAny)
+      return NULL;
+
+   (*ppcLine)[uLineLength] = '\0';
+   *puLength = uLineLength;
+   return *ppcLine;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If no lines remain in oLineReader, then return NULL. Otherwise read
+   a line of oLineReader into the caller-owned buffer *ppcLine, whose
+   physical length is *puPhysLength, and return *ppcLine. The buffer
+   may be NULL initially; it grows (updating *ppcLine and
+   *puPhysLength) as needed, so it can be reused across calls. The
+   string does not contain a terminating newline character. */
+
+char *LineReader_read(LineReader_T oLineReader, char **ppcLine,
+   size_t *puPhysLength)
+{
+   const char *pcLine;
+   size_t uLength;
+
+   assert(oLineReader != NULL);
+   assert(ppcLine != NULL);
+   assert(puPhysLength != NULL);
+
+   if (! oLineReader->iMapped)
+      return LineReader_readStream(oLineReader, ppcLine, puPhysLength,
+                                   &uLength);
+
+   pcLine = LineReader_nextMapped(oLineReader, &uLength);
+   if (pcLine == NULL)
+      return NULL;
+   LineReader_reserve(ppcLine, puPhysLength, uLength);
+   memcpy(*ppcLine, pcLine, uLength);
+   (*ppcLine)[uLength] = '\0';
+   return *ppcLine;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If no lines remain in oLineReader, then return NULL. Otherwise
+   return the next line of oLineReader and store its length in
+   *puLength. If oLineReader maps its file into memory, the line is
+   read in place: it points into the mapping and is not terminated by
+   a null character. Otherwise the line is read into *ppcLine as by
+   LineReader_read. The line does not contain a terminating newline
+   character. */
+
+const char *LineReader_readInPlace(LineReader_T oLineReader,
+   char **ppcLine, size_t *puPhysLength, size_t *puLength)
+{
+   assert(oLineReader != NULL);
+   assert(ppcLine != NULL);
+   assert(puPhysLength != NULL);
+   assert(puLength != NULL);
+
+   if (oLineReader->iMapped)
+      return LineReader_nextMapped(oLineReader, puLength);
+   return LineReader_readStream(oLineReader, ppcLine, puPhysLength,
+                                puLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff oLineReader reads from a terminal, or 0 (FALSE)
+   otherwise. */
+
+int LineReader_isInteractive(LineReader_T oLineReader)
+{
+   assert(oLineReader != NULL);
+
+   if (oLineReader->iMapped)
+      return 0;
+   return isatty(oLineReader->iFd);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give back to the file descriptor of oLineReader any bytes that
+   oLineReader has read but not yet handed out, so that a child
+   process that inherits the file descriptor starts reading exactly
+   where the last line ended. */
+
+void LineReader_sync(LineReader_T oLineReader)
+{
+   off_t lUnread;
+
+   assert(oLineReader != NULL);
+
+   /* A peeked pipe still holds the whole block; consume the part
+      that has been handed out. */
+   if (oLineReader->aiPeek[0] != -1)
+   {
+      LineReader_consume(oLineReader, oLineReader->uStart);
+      oLineReader->uStart = 0;
+      oLineReader->uEnd = 0;
+      return;
+   }
+
+   lUnread = (off_t)(oLineReader->uEnd - oLineReader->uStart);
+   if (lUnread == 0)
+      return;
+
+   /* Only a seekable file descriptor holds bytes read ahead; a
+      mapped file is never shared with a child. */
+   if (! oLineReader->iSeekable)
+      return;
+   if (lseek(oLineReader->iFd, -lUnread, SEEK_CUR) == (off_t)-1)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+
+   oLineReader->uStart = 0;
+   oLineReader->uEnd = 0;
+}
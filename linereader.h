@@ -6,12 +6,88 @@
 #ifndef LINEREADER_INCLUDED
 #define LINEREADER_INCLUDED
 
-#include <stdio.h>
+#include <stddef.h>
 
-/* If no lines remain in psFile, then return NULL. Otherwise read a line
-   of psFile and return it as a string. The string does not contain a
-   terminating newline character. The caller owns the string. */
+/*--------------------------------------------------------------------*/
+
+/* A LineReader object reads the lines of a file descriptor in large
+   blocks and hands them out one at a time. */
+
+typedef struct LineReader *LineReader_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new LineReader object that reads from file descriptor iFd,
+   or NULL if insufficient memory is available. The LineReader does
+   not own iFd. */
+
+LineReader_T LineReader_new(int iFd);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new LineReader object that reads from file descriptor iFd
+   in whole blocks, whatever kind of file it is, or NULL if
+   insufficient memory is available. No child process may inherit
+   iFd, since the bytes read ahead are not given back to it. The
+   LineReader does not own iFd. */
+
+LineReader_T LineReader_newPrivate(int iFd);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new LineReader object that reads the file named
+   pcFileName, or NULL if the file cannot be opened (setting errno).
+   A regular file is mapped into memory so that its lines can be read
+   in place; any other file, such as a pipe or a FIFO, is read as a
+   stream. The LineReader owns the file. */
+
+LineReader_T LineReader_open(const char *pcFileName);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oLineReader. */
+
+void LineReader_free(LineReader_T oLineReader);
+
+/*--------------------------------------------------------------------*/
+
+/* If no lines remain in oLineReader, then return NULL. Otherwise read
+   a line of oLineReader into the caller-owned buffer *ppcLine, whose
+   physical length is *puPhysLength, and return *ppcLine. The buffer
+   may be NULL initially; it grows (updating *ppcLine and
+   *puPhysLength) as needed, so it can be reused across calls. The
+   string does not contain a terminating newline character. */
+
+char *LineReader_read(LineReader_T oLineReader, char **ppcLine,
+   size_t *puPhysLength);
+
+/*--------------------------------------------------------------------*/
+
+/* If no lines remain in oLineReader, then return NULL. Otherwise
+   return the next line of oLineReader and store its length in
+   *puLength. If oLineReader maps its file into memory, the line is
+   read in place: it points into the mapping and is not terminated by
+   a null character. Otherwise the line is read into *ppcLine as by
+   LineReader_read. The line does not contain a terminating newline
+   character. */
+
+const char *LineReader_readInPlace(LineReader_T oLineReader,
+   char **ppcLine, size_t *puPhysLength, size_t *puLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff oLineReader reads from a terminal, or 0 (FALSE)
+   otherwise. */
+
+int LineReader_isInteractive(LineReader_T oLineReader);
+
+/*--------------------------------------------------------------------*/
+
+/* Give back to the file descriptor of oLineReader any bytes that
+   oLineReader has read but not yet handed out, so that a child
+   process that inherits the file descriptor starts reading exactly
+   where the last line ended. */
 
-char *LineReader_read(FILE *psFile);
+void LineReader_sync(LineReader_T oLineReader);
 
 #endif
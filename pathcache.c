@@ -0,0 +1,301 @@
+/*--------------------------------------------------------------------*/
+/* pathcache.c                                                        */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "pathcache.h"
+#include "hashtable.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The search path used when PATH is not set, as by execvp(). */
+
+static const char DEFAULT_PATH[] = "/bin:/usr/bin";
+
+/*--------------------------------------------------------------------*/
+
+/* A Binding is the path of an executable file that a command name
+   stands for. */
+
+struct Binding
+{
+   /* The link that chains the Binding into its bucket. */
+   struct HashLink sLink;
+
+   /* The command name, and the path of its executable file. */
+   char *pcName;
+   char *pcPath;
+
+   /* The number of times that the name has been looked up. */
+   size_t uHits;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A PathCache is a hash table of Bindings. */
+
+struct PathCache
+{
+   /* The Bindings, by command name. */
+   HashTable_T oBindings;
+
+   /* A buffer in which candidate paths are built, and its physical
+      length. */
+   char *pcCandidate;
+   size_t uCandidateLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pointer to the link in oPathCache that points to the
+   Binding for pcName, or to the NULL link at the end of its bucket if
+   there is none. uHash is the hash code of pcName. */
+
+static struct HashLink **PathCache_find(PathCache_T oPathCache,
+   const char *pcName, size_t uHash)
+{
+   struct HashLink **ppsLink;
+
+   ppsLink = HashTable_getBucket(oPathCache->oBindings, uHash);
+   while ((*ppsLink != NULL) &&
+          (((*ppsLink)->uHash != uHash) ||
+           (strcmp(((struct Binding*)*ppsLink)->pcName, pcName) != 0)))
+      ppsLink = &(*ppsLink)->psNext;
+   return ppsLink;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the Binding whose link is psLink. pvExtra is unused. */
+
+static void PathCache_freeBinding(struct HashLink *psLink,
+   void *pvExtra)
+{
+   struct Binding *psBinding = (struct Binding*)psLink;
+
+   (void)pvExtra;
+
+   free(psBinding->pcName);
+   free(psBinding->pcPath);
+   free(psBinding);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the Binding whose link is psLink to stdout. pvExtra is
+   unused. */
+
+static void PathCache_writeBinding(struct HashLink *psLink,
+   void *pvExtra)
+{
+   struct Binding *psBinding = (struct Binding*)psLink;
+
+   (void)pvExtra;
+
+   printf("%4lu\t%s\n", (unsigned long)psBinding->uHits,
+          psBinding->pcPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the path of the first executable regular file named pcName
+   in the directories of PATH, in the candidate buffer of oPathCache,
+   or NULL if there is none. An empty directory is the current
+   directory. */
+
+static const char *PathCache_search(PathCache_T oPathCache,
+   const char *pcName)
+{
+   const char *pcPath;
+   const char *pcDir;
+   const char *pcEnd;
+   size_t uDirLength;
+   size_t uNameLength;
+   struct stat sStat;
+
+   pcPath = getenv("PATH");
+   if (pcPath == NULL)
+      pcPath = DEFAULT_PATH;
+   uNameLength = strlen(pcName);
+
+   for (pcDir = pcPath; ; pcDir = pcEnd + 1)
+   {
+      pcEnd = strchr(pcDir, ':');
+      if (pcEnd == NULL)
+         pcEnd = pcDir + strlen(pcDir);
+      uDirLength = (size_t)(pcEnd - pcDir);
+      if (uDirLength == 0)
+      {
+         pcDir = ".";
+         uDirLength = 1;
+      }
+
+      /* Build dir/name in the candidate buffer. */
+      if (uDirLength + uNameLength + 2 > oPathCache->uCandidateLength)
+      {
+         free(oPathCache->pcCandidate);
+         oPathCache->uCandidateLength = 2 * (uDirLength + uNameLength + 2);
+         oPathCache->pcCandidate = 
+            (char*)malloc(oPathCache->uCandidateLength);
+         if (oPathCache->pcCandidate == NULL)
+            {perror(pcPgmName); exit(EXIT_FAILURE);}
+      }
+      memcpy(oPathCache->pcCandidate, pcDir, uDirLength);
+      oPathCache->pcCandidate[uDirLength] = '/';
+      memcpy(oPathCache->pcCandidate + uDirLength + 1, pcName,
+             uNameLength + 1);
+
+      if ((access(oPathCache->pcCandidate, X_OK) == 0) &&
+          (stat(oPathCache->pcCandidate, &sStat) == 0) &&
+          S_ISREG(sStat.st_mode))
+         return oPathCache->pcCandidate;
+
+      if (*pcEnd == '\0')
+         return NULL;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty PathCache object, or NULL if insufficient
+   memory is available. */
+
+PathCache_T PathCache_new(void)
+{
+   PathCache_T oPathCache;
+
+   oPathCache = (struct PathCache*)malloc(sizeof(struct PathCache));
+   if (oPathCache == NULL)
+      return NULL;
+
+   oPathCache->oBindings = HashTable_new();
+   if (oPathCache->oBindings == NULL)
+   {
+      free(oPathCache);
+      return NULL;
+   }
+   oPathCache->pcCandidate = NULL;
+   oPathCache->uCandidateLength = 0;
+   return oPathCache;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oPathCache. */
+
+void PathCache_free(PathCache_T oPathCache)
+{
+   if (oPathCache == NULL)
+      return;
+
+   PathCache_clear(oPathCache);
+   HashTable_free(oPathCache->oBindings);
+   free(oPathCache->pcCandidate);
+   free(oPathCache);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the path of the executable file that command name pcName
+   stands for, or NULL if there is none. A name that contains a '/'
+   is its own path. Otherwise the path is the one remembered by
+   oPathCache, or else the first found by searching the directories
+   of PATH, which oPathCache then remembers. The path lasts until
+   pcName is removed from oPathCache. */
+
+const char *PathCache_lookup(PathCache_T oPathCache,
+   const char *pcName)
+{
+   struct HashLink **ppsLink;
+   struct Binding *psBinding;
+   const char *pcPath;
+   size_t uHash;
+
+   assert(oPathCache != NULL);
+   assert(pcName != NULL);
+
+   if (strchr(pcName, '/') != NULL)
+      return pcName;
+
+   uHash = HashTable_hashString(pcName);
+   ppsLink = PathCache_find(oPathCache, pcName, uHash);
+   if (*ppsLink != NULL)
+   {
+      psBinding = (struct Binding*)*ppsLink;
+      psBinding->uHits++;
+      return psBinding->pcPath;
+   }
+
+   /* A name that is not found is not remembered, so that a command
+      installed later is found. */
+   pcPath = PathCache_search(oPathCache, pcName);
+   if (pcPath == NULL)
+      return NULL;
+
+   psBinding = (struct Binding*)malloc(sizeof(struct Binding));
+   if (psBinding == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psBinding->pcName = strdup(pcName);
+   psBinding->pcPath = strdup(pcPath);
+   if ((psBinding->pcName == NULL) || (psBinding->pcPath == NULL))
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psBinding->uHits = 1;
+   HashTable_add(oPathCache->oBindings, &psBinding->sLink, uHash);
+
+   return psBinding->pcPath;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Forget the path of command name pcName in oPathCache, if any, as
+   when the file at that path has gone missing. */
+
+void PathCache_remove(PathCache_T oPathCache, const char *pcName)
+{
+   struct HashLink **ppsLink;
+   struct HashLink *psLink;
+
+   assert(oPathCache != NULL);
+   assert(pcName != NULL);
+
+   ppsLink = PathCache_find(oPathCache, pcName,
+      HashTable_hashString(pcName));
+   psLink = *ppsLink;
+   if (psLink == NULL)
+      return;
+
+   HashTable_remove(oPathCache->oBindings, ppsLink);
+   PathCache_freeBinding(psLink, NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Forget all of the paths in oPathCache, as when PATH changes. */
+
+void PathCache_clear(PathCache_T oPathCache)
+{
+   assert(oPathCache != NULL);
+
+   HashTable_map(oPathCache->oBindings, PathCache_freeBinding, NULL);
+   HashTable_clear(oPathCache->oBindings);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout each command name in oPathCache with its path and
+   the number of times that it has been looked up. */
+
+void PathCache_write(PathCache_T oPathCache)
+{
+   assert(oPathCache != NULL);
+
+   printf("hits\tcommand\n");
+   HashTable_map(oPathCache->oBindings, PathCache_writeBinding, NULL);
+}
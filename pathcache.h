@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------*/
+/* pathcache.h                                                        */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef PATHCACHE_INCLUDED
+#define PATHCACHE_INCLUDED
+
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A PathCache object remembers where in the directories of the PATH
+   environment variable each command name was found, so that PATH is
+   searched once per name rather than once per command. */
+
+typedef struct PathCache *PathCache_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty PathCache object, or NULL if insufficient
+   memory is available. */
+
+PathCache_T PathCache_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oPathCache. */
+
+void PathCache_free(PathCache_T oPathCache);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the path of the executable file that command name pcName
+   stands for, or NULL if there is none. A name that contains a '/'
+   is its own path. Otherwise the path is the one remembered by
+   oPathCache, or else the first found by searching the directories
+   of PATH, which oPathCache then remembers. The path lasts until
+   pcName is removed from oPathCache. */
+
+const char *PathCache_lookup(PathCache_T oPathCache,
+   const char *pcName);
+
+/*--------------------------------------------------------------------*/
+
+/* Forget the path of command name pcName in oPathCache, if any, as
+   when the file at that path has gone missing. */
+
+void PathCache_remove(PathCache_T oPathCache, const char *pcName);
+
+/*--------------------------------------------------------------------*/
+
+/* Forget all of the paths in oPathCache, as when PATH changes. */
+
+void PathCache_clear(PathCache_T oPathCache);
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout each command name in oPathCache with its path and
+   the number of times that it has been looked up. */
+
+void PathCache_write(PathCache_T oPathCache);
+
+#endif
@@ -0,0 +1,132 @@
+/*--------------------------------------------------------------------*/
+/* pipeline.c                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "pipeline.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A Pipeline is an object that contains its commands, in order. */
+
+struct Pipeline
+{
+	/* The number of commands. */
+	size_t uLength;
+
+	/* The commands, first to last. */
+	Command_T* poCommands;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Make a new pipeline object whose stages are the uLength commands
+   of the array poCommands. The pipeline is allocated from oArena and
+   takes poCommands as it is, without copying it; it must last until
+   oArena is reset. */
+
+Pipeline_T Pipeline_new(Arena_T oArena, Command_T* poCommands,
+	size_t uLength)
+{
+	Pipeline_T oPipeline;
+
+	assert(oArena != NULL);
+	assert(poCommands != NULL);
+	assert(uLength > 0);
+
+	oPipeline = (struct Pipeline*)
+		Arena_alloc(oArena, sizeof(struct Pipeline));
+	oPipeline->uLength = uLength;
+	oPipeline->poCommands = poCommands;
+
+	return oPipeline;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Print a pipeline, oPipeline. */
+
+void Pipeline_write(Pipeline_T oPipeline)
+{
+	size_t ulIndex;
+	assert(oPipeline != NULL);
+
+	/* Print each command, with a pipe between each two. */
+	for (ulIndex = 0; ulIndex < oPipeline->uLength; ulIndex++)
+	{
+		if (ulIndex > 0)
+			printf("Command pipe\n");
+		Command_write(oPipeline->poCommands[ulIndex]);
+	}
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a string, allocated from oArena, that shows oPipeline as it
+   might be typed: each command's name and arguments, separated by
+   spaces, with " | " between each two commands. */
+
+char* Pipeline_toString(Pipeline_T oPipeline, Arena_T oArena)
+{
+	size_t ulIndex;
+	size_t ulLength = 0;
+	char** ppcArgv;
+	char* pcString;
+	char* pc;
+
+	assert(oPipeline != NULL);
+	assert(oArena != NULL);
+
+	/* Measure the string, then fill it in. */
+	for (ulIndex = 0; ulIndex < oPipeline->uLength; ulIndex++)
+		for (ppcArgv = Command_getArgsArray(
+			oPipeline->poCommands[ulIndex]); *ppcArgv != NULL; ppcArgv++)
+			ulLength += strlen(*ppcArgv) + 3;
+
+	pcString = (char*)Arena_alloc(oArena, ulLength + 1);
+	pc = pcString;
+	for (ulIndex = 0; ulIndex < oPipeline->uLength; ulIndex++)
+	{
+		if (ulIndex > 0)
+		{
+			memcpy(pc, " | ", 3);
+			pc += 3;
+		}
+		for (ppcArgv = Command_getArgsArray(
+			oPipeline->poCommands[ulIndex]); *ppcArgv != NULL; ppcArgv++)
+		{
+			if (ppcArgv != Command_getArgsArray(
+				oPipeline->poCommands[ulIndex]))
+				*pc++ = ' ';
+			strcpy(pc, *ppcArgv);
+			pc += strlen(*ppcArgv);
+		}
+	}
+	*pc = '\0';
+
+	return pcString;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of commands of oPipeline. */
+
+size_t Pipeline_getLength(Pipeline_T oPipeline)
+{
+	assert(oPipeline != NULL);
+	return oPipeline->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th command of oPipeline. */
+
+Command_T Pipeline_getCommand(Pipeline_T oPipeline, size_t uIndex)
+{
+	assert(oPipeline != NULL);
+	assert(uIndex < oPipeline->uLength);
+	return oPipeline->poCommands[uIndex];
+}
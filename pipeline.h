@@ -0,0 +1,56 @@
+/*--------------------------------------------------------------------*/
+/* pipeline.h                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef PIPELINE_INCLUDED
+#define PIPELINE_INCLUDED
+
+#include "command.h"
+#include "arena.h"
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A pipeline is an object that contains a sequence of commands, each
+   of whose standard output is the standard input of the next. */
+
+typedef struct Pipeline* Pipeline_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Returns a new pipeline object whose stages are the uLength commands
+   of the array poCommands. The pipeline is allocated from oArena and
+   takes poCommands as it is, without copying it; it must last until
+   oArena is reset. */
+
+Pipeline_T Pipeline_new(Arena_T oArena, Command_T* poCommands,
+	size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Print a pipeline, oPipeline. */
+
+void Pipeline_write(Pipeline_T oPipeline);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a string, allocated from oArena, that shows oPipeline as it
+   might be typed: each command's name and arguments, separated by
+   spaces, with " | " between each two commands. */
+
+char* Pipeline_toString(Pipeline_T oPipeline, Arena_T oArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of commands of oPipeline. */
+
+size_t Pipeline_getLength(Pipeline_T oPipeline);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th command of oPipeline. */
+
+Command_T Pipeline_getCommand(Pipeline_T oPipeline, size_t uIndex);
+
+#endif
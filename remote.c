@@ -0,0 +1,408 @@
+/*--------------------------------------------------------------------*/
+/* remote.c                                                           */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "remote.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+extern char **environ;
+
+/*--------------------------------------------------------------------*/
+
+enum {FALSE, TRUE};
+
+/* The number of file descriptors that a session passes. */
+
+enum {FD_COUNT = 3};
+
+/*--------------------------------------------------------------------*/
+
+/* Store in *psAddress the address of the socket at path pcPath.
+   Return TRUE, or FALSE if the path is too long (setting errno). */
+
+static int Remote_getAddress(const char *pcPath,
+   struct sockaddr_un *psAddress)
+{
+   memset(psAddress, 0, sizeof(*psAddress));
+   psAddress->sun_family = AF_UNIX;
+   if (strlen(pcPath) >= sizeof(psAddress->sun_path))
+   {
+      errno = ENAMETOOLONG;
+      return FALSE;
+   }
+   strcpy(psAddress->sun_path, pcPath);
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength bytes at pvData to file descriptor iFd. Return
+   TRUE, or FALSE if they cannot all be written (setting errno). */
+
+static int Remote_write(int iFd, const void *pvData, size_t uLength)
+{
+   const char *pcData = (const char*)pvData;
+   ssize_t lRet;
+
+   while (uLength > 0)
+   {
+      lRet = write(iFd, pcData, uLength);
+      if (lRet == -1)
+      {
+         if (errno == EINTR) continue;
+         return FALSE;
+      }
+      pcData += lRet;
+      uLength -= (size_t)lRet;
+   }
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read uLength bytes from file descriptor iFd into pvData. Return
+   TRUE, or FALSE if they cannot all be read (setting errno, or
+   leaving it 0 at the end of the file). */
+
+static int Remote_read(int iFd, void *pvData, size_t uLength)
+{
+   char *pcData = (char*)pvData;
+   ssize_t lRet;
+
+   while (uLength > 0)
+   {
+      lRet = read(iFd, pcData, uLength);
+      if (lRet == -1)
+      {
+         if (errno == EINTR) continue;
+         return FALSE;
+      }
+      if (lRet == 0)
+      {
+         errno = 0;
+         return FALSE;
+      }
+      pcData += lRet;
+      uLength -= (size_t)lRet;
+   }
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a socket that listens for sessions at path pcPath, closed
+   on exec, after removing any socket already there, or -1 if it
+   cannot be made (setting errno). Only the owner of the process may
+   connect to it. */
+
+int Remote_listen(const char *pcPath)
+{
+   struct sockaddr_un sAddress;
+   mode_t iMask;
+   int iSocket;
+   int iErrno;
+   int iRet;
+
+   assert(pcPath != NULL);
+
+   if (! Remote_getAddress(pcPath, &sAddress))
+      return -1;
+   iSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+   if (iSocket == -1)
+      return -1;
+
+   /* The socket is made with mode 0600, so that no other user can
+      connect to it even before it is listening. */
+   unlink(pcPath);
+   iMask = umask(0177);
+   iRet = bind(iSocket, (struct sockaddr*)&sAddress, sizeof(sAddress));
+   umask(iMask);
+   if ((iRet == -1) || (listen(iSocket, SOMAXCONN) == -1))
+   {
+      iErrno = errno;
+      close(iSocket);
+      errno = iErrno;
+      return -1;
+   }
+   return iSocket;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a socket connected to the server listening at path pcPath,
+   closed on exec, or -1 if there is none (setting errno). */
+
+int Remote_connect(const char *pcPath)
+{
+   struct sockaddr_un sAddress;
+   int iSocket;
+   int iErrno;
+
+   assert(pcPath != NULL);
+
+   if (! Remote_getAddress(pcPath, &sAddress))
+      return -1;
+   iSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+   if (iSocket == -1)
+      return -1;
+
+   if (connect(iSocket, (struct sockaddr*)&sAddress,
+               sizeof(sAddress)) == -1)
+   {
+      iErrno = errno;
+      close(iSocket);
+      errno = iErrno;
+      return -1;
+   }
+   return iSocket;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Send over iSocket the setup of a session: file descriptors 0, 1
+   and 2, the current working directory, and the environment. Return
+   1 (TRUE), or 0 (FALSE) if it cannot be sent (setting errno). */
+
+int Remote_sendSetup(int iSocket)
+{
+   union
+   {
+      char acBuffer[CMSG_SPACE(FD_COUNT * sizeof(int))];
+      struct cmsghdr sAlign;
+   } uControl;
+   struct msghdr sMessage;
+   struct cmsghdr *psControl;
+   struct iovec asVectors[2];
+   int aiFds[FD_COUNT] = {0, 1, 2};
+   uint32_t uSetupLength;
+   char *pcSetup;
+   char *pcCwd;
+   char **ppcEnv;
+   size_t uLength;
+   size_t uSent;
+   ssize_t lRet;
+   int iRet;
+
+   /* Gather the setup, so that it goes in as few writes as can be. */
+   pcCwd = getcwd(NULL, 0);
+   if (pcCwd == NULL)
+      return FALSE;
+   uLength = strlen(pcCwd) + 1;
+   for (ppcEnv = environ; *ppcEnv != NULL; ppcEnv++)
+      uLength += strlen(*ppcEnv) + 1;
+   pcSetup = (char*)malloc(uLength);
+   if (pcSetup == NULL)
+   {
+      free(pcCwd);
+      return FALSE;
+   }
+   uSetupLength = (uint32_t)uLength;
+   uLength = strlen(pcCwd) + 1;
+   memcpy(pcSetup, pcCwd, uLength);
+   free(pcCwd);
+   for (ppcEnv = environ; *ppcEnv != NULL; ppcEnv++)
+   {
+      memcpy(pcSetup + uLength, *ppcEnv, strlen(*ppcEnv) + 1);
+      uLength += strlen(*ppcEnv) + 1;
+   }
+
+   /* The file descriptors go along with the length. */
+   memset(&sMessage, 0, sizeof(sMessage));
+   memset(&uControl, 0, sizeof(uControl));
+   asVectors[0].iov_base = &uSetupLength;
+   asVectors[0].iov_len = sizeof(uSetupLength);
+   asVectors[1].iov_base = pcSetup;
+   asVectors[1].iov_len = uLength;
+   sMessage.msg_iov = asVectors;
+   sMessage.msg_iovlen = 2;
+   sMessage.msg_control = uControl.acBuffer;
+   sMessage.msg_controllen = sizeof(uControl.acBuffer);
+   psControl = CMSG_FIRSTHDR(&sMessage);
+   psControl->cmsg_level = SOL_SOCKET;
+   psControl->cmsg_type = SCM_RIGHTS;
+   psControl->cmsg_len = CMSG_LEN(FD_COUNT * sizeof(int));
+   memcpy(CMSG_DATA(psControl), aiFds, sizeof(aiFds));
+
+   do
+      lRet = sendmsg(iSocket, &sMessage, 0);
+   while ((lRet == -1) && (errno == EINTR));
+   if (lRet < (ssize_t)sizeof(uSetupLength))
+   {
+      free(pcSetup);
+      return FALSE;
+   }
+
+   /* A large environment may not fit in the socket at once. */
+   uSent = (size_t)lRet - sizeof(uSetupLength);
+   iRet = Remote_write(iSocket, pcSetup + uSent, uLength - uSent);
+   free(pcSetup);
+   return iRet;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Receive from iSocket the setup of a session, and take it on: move
+   the file descriptors received onto 0, 1 and 2, change to the
+   working directory, and replace the environment. Return 1 (TRUE),
+   or 0 (FALSE) if it cannot be received or taken on, or if the
+   client runs as another user (setting errno). */
+
+int Remote_receiveSetup(int iSocket)
+{
+   union
+   {
+      char acBuffer[CMSG_SPACE(FD_COUNT * sizeof(int))];
+      struct cmsghdr sAlign;
+   } uControl;
+   struct msghdr sMessage;
+   struct cmsghdr *psControl;
+   struct iovec sVector;
+   struct ucred sCred;
+   socklen_t iCredLength = sizeof(sCred);
+   int aiFds[FD_COUNT];
+   uint32_t uSetupLength;
+   char *pcSetup;
+   char *pcString;
+   char *pcEquals;
+   ssize_t lRet;
+   int i;
+
+   /* A session runs as the server's user, so it must be that user's
+      own. */
+   if (getsockopt(iSocket, SOL_SOCKET, SO_PEERCRED, &sCred,
+                  &iCredLength) == -1)
+      return FALSE;
+   if (sCred.uid != geteuid())
+   {
+      errno = EACCES;
+      return FALSE;
+   }
+
+   memset(&sMessage, 0, sizeof(sMessage));
+   sVector.iov_base = &uSetupLength;
+   sVector.iov_len = sizeof(uSetupLength);
+   sMessage.msg_iov = &sVector;
+   sMessage.msg_iovlen = 1;
+   sMessage.msg_control = uControl.acBuffer;
+   sMessage.msg_controllen = sizeof(uControl.acBuffer);
+
+   do
+      lRet = recvmsg(iSocket, &sMessage, MSG_CMSG_CLOEXEC);
+   while ((lRet == -1) && (errno == EINTR));
+   if (lRet == -1)
+      return FALSE;
+
+   /* The length may arrive in pieces, but the file descriptors
+      come with its first byte. */
+   psControl = CMSG_FIRSTHDR(&sMessage);
+   if ((lRet == 0) || (psControl == NULL) ||
+       (psControl->cmsg_level != SOL_SOCKET) ||
+       (psControl->cmsg_type != SCM_RIGHTS) ||
+       (psControl->cmsg_len != CMSG_LEN(FD_COUNT * sizeof(int))) ||
+       ((sMessage.msg_flags & MSG_CTRUNC) != 0))
+   {
+      errno = EPROTO;
+      return FALSE;
+   }
+   memcpy(aiFds, CMSG_DATA(psControl), sizeof(aiFds));
+   if ((size_t)lRet < sizeof(uSetupLength))
+      if (! Remote_read(iSocket, (char*)&uSetupLength + lRet,
+                        sizeof(uSetupLength) - (size_t)lRet))
+         return FALSE;
+
+   /* dup2() leaves the copies open on exec. */
+   for (i = 0; i < FD_COUNT; i++)
+   {
+      if (dup2(aiFds[i], i) == -1)
+         return FALSE;
+      close(aiFds[i]);
+   }
+
+   pcSetup = (char*)malloc((size_t)uSetupLength + 1);
+   if (pcSetup == NULL)
+      return FALSE;
+   if (! Remote_read(iSocket, pcSetup, uSetupLength))
+   {
+      free(pcSetup);
+      return FALSE;
+   }
+   pcSetup[uSetupLength] = '\0';
+
+   if (chdir(pcSetup) == -1)
+   {
+      free(pcSetup);
+      return FALSE;
+   }
+
+   /* Each environment string is split at its '=' in place. */
+   clearenv();
+   pcString = pcSetup + strlen(pcSetup) + 1;
+   while (pcString < pcSetup + uSetupLength)
+   {
+      pcEquals = strchr(pcString, '=');
+      if (pcEquals != NULL)
+      {
+         *pcEquals = '\0';
+         setenv(pcString, pcEquals + 1, 1);
+         *pcEquals = '=';
+      }
+      pcString += strlen(pcString) + 1;
+   }
+   free(pcSetup);
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Send command line pcLine over iSocket, followed by a newline
+   character. Return 1 (TRUE), or 0 (FALSE) if it cannot all be sent
+   (setting errno). */
+
+int Remote_sendLine(int iSocket, const char *pcLine)
+{
+   assert(pcLine != NULL);
+
+   return Remote_write(iSocket, pcLine, strlen(pcLine)) &&
+      Remote_write(iSocket, "\n", 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Send exit status iStatus over iSocket. Return 1 (TRUE), or 0
+   (FALSE) if it cannot be sent (setting errno). */
+
+int Remote_sendStatus(int iSocket, int iStatus)
+{
+   int32_t iValue = (int32_t)iStatus;
+
+   return Remote_write(iSocket, &iValue, sizeof(iValue));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Receive an exit status from iSocket into *piStatus. Return 1
+   (TRUE), or 0 (FALSE) if none comes (setting errno, or leaving it
+   0 if the server closed the stream). */
+
+int Remote_receiveStatus(int iSocket, int *piStatus)
+{
+   int32_t iValue;
+
+   assert(piStatus != NULL);
+
+   if (! Remote_read(iSocket, &iValue, sizeof(iValue)))
+      return FALSE;
+   *piStatus = (int)iValue;
+   return TRUE;
+}
@@ -0,0 +1,79 @@
+/*--------------------------------------------------------------------*/
+/* remote.h                                                           */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef REMOTE_INCLUDED
+#define REMOTE_INCLUDED
+
+/*--------------------------------------------------------------------*/
+
+/* The Remote functions carry a session between a client and an ish
+   server over a Unix domain stream socket. The client first sends
+   the length of its setup, along with its standard input, output and
+   error as SCM_RIGHTS, so that the commands of the session use them
+   directly. The setup follows: the client's working directory and
+   then each string of its environment, every one ending with a null
+   character. Then come the command lines of the session, up to the
+   end of the client's side of the stream. Last, the server sends
+   back the exit status of the last command. Both ends run on the
+   same host, so numbers go in its byte order. */
+
+/*--------------------------------------------------------------------*/
+
+/* Return a socket that listens for sessions at path pcPath, closed
+   on exec, after removing any socket already there, or -1 if it
+   cannot be made (setting errno). Only the owner of the process may
+   connect to it. */
+
+int Remote_listen(const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a socket connected to the server listening at path pcPath,
+   closed on exec, or -1 if there is none (setting errno). */
+
+int Remote_connect(const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+
+/* Send over iSocket the setup of a session: file descriptors 0, 1
+   and 2, the current working directory, and the environment. Return
+   1 (TRUE), or 0 (FALSE) if it cannot be sent (setting errno). */
+
+int Remote_sendSetup(int iSocket);
+
+/*--------------------------------------------------------------------*/
+
+/* Receive from iSocket the setup of a session, and take it on: move
+   the file descriptors received onto 0, 1 and 2, change to the
+   working directory, and replace the environment. Return 1 (TRUE),
+   or 0 (FALSE) if it cannot be received or taken on, or if the
+   client runs as another user (setting errno). */
+
+int Remote_receiveSetup(int iSocket);
+
+/*--------------------------------------------------------------------*/
+
+/* Send command line pcLine over iSocket, followed by a newline
+   character. Return 1 (TRUE), or 0 (FALSE) if it cannot all be sent
+   (setting errno). */
+
+int Remote_sendLine(int iSocket, const char *pcLine);
+
+/*--------------------------------------------------------------------*/
+
+/* Send exit status iStatus over iSocket. Return 1 (TRUE), or 0
+   (FALSE) if it cannot be sent (setting errno). */
+
+int Remote_sendStatus(int iSocket, int iStatus);
+
+/*--------------------------------------------------------------------*/
+
+/* Receive an exit status from iSocket into *piStatus. Return 1
+   (TRUE), or 0 (FALSE) if none comes (setting errno, or leaving it
+   0 if the server closed the stream). */
+
+int Remote_receiveStatus(int iSocket, int *piStatus);
+
+#endif
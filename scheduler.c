@@ -0,0 +1,397 @@
+/*--------------------------------------------------------------------*/
+/* scheduler.c                                                        */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "scheduler.h"
+#include "hashtable.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of buckets of files that a Scheduler has. */
+
+enum {BUCKET_COUNT = 256};
+
+/*--------------------------------------------------------------------*/
+
+/* A File is a file that running lines use, with the number of uses
+   by those lines that read it and that write it. */
+
+struct File
+{
+   /* The name of the file. */
+   char *pcName;
+
+   /* The number of reads and writes of the file by running lines. */
+   size_t uReaders;
+   size_t uWriters;
+
+   /* The next File in the same bucket. */
+   struct File *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Use is a read or a write of a File by a line. */
+
+struct Use
+{
+   struct File *psFile;
+   int iWrite;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Line is a line of a script that is running. */
+
+struct Line
+{
+   /* The IDs of the processes of the line that are running, their
+      number, and the ID of the process that gives its exit status,
+      or -1 if there is none. */
+   pid_t *piPids;
+   size_t uRunning;
+   pid_t iLastPid;
+
+   /* The exit status of the line, once its last process is done. */
+   int iStatus;
+
+   /* The number of the line, in order of starting. */
+   size_t uNumber;
+
+   /* The files that the line uses, and their number. */
+   struct Use *psUses;
+   size_t uUseCount;
+
+   /* The next running Line. */
+   struct Line *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Scheduler is a list of running Lines, along with a hash table of
+   the Files that they use, and the uses of the next line. */
+
+struct Scheduler
+{
+   /* The running Lines, and their number. */
+   struct Line *psLines;
+   size_t uLineCount;
+
+   /* The buckets of Files. */
+   struct File *apsBuckets[BUCKET_COUNT];
+
+   /* The uses of the next line, their number, and the number that
+      psPending has room for. */
+   struct Use *psPending;
+   size_t uPendingCount;
+   size_t uMaxPending;
+
+   /* The number of lines started, and the exit status of the last
+      one. */
+   size_t uStarted;
+   int iLastStatus;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the File of oScheduler named pcName, adding it with no uses
+   if there is none. */
+
+static struct File *Scheduler_getFile(Scheduler_T oScheduler,
+   const char *pcName)
+{
+   struct File **ppsLink;
+   struct File *psFile;
+
+   ppsLink = &oScheduler->apsBuckets[
+      HashTable_hashString(pcName) % BUCKET_COUNT];
+   for (psFile = *ppsLink; psFile != NULL; psFile = psFile->psNext)
+      if (strcmp(psFile->pcName, pcName) == 0)
+         return psFile;
+
+   psFile = (struct File*)malloc(sizeof(struct File));
+   if (psFile == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psFile->pcName = strdup(pcName);
+   if (psFile->pcName == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psFile->uReaders = 0;
+   psFile->uWriters = 0;
+   psFile->psNext = *ppsLink;
+   *ppsLink = psFile;
+   return psFile;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove from oScheduler the Files that no running line uses. */
+
+static void Scheduler_removeUnused(Scheduler_T oScheduler)
+{
+   struct File **ppsLink;
+   struct File *psFile;
+   size_t u;
+
+   for (u = 0; u < BUCKET_COUNT; u++)
+   {
+      ppsLink = &oScheduler->apsBuckets[u];
+      while ((psFile = *ppsLink) != NULL)
+      {
+         if ((psFile->uReaders == 0) && (psFile->uWriters == 0))
+         {
+            *ppsLink = psFile->psNext;
+            free(psFile->pcName);
+            free(psFile);
+         }
+         else
+            ppsLink = &psFile->psNext;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Finish the Line of oScheduler that *ppsLink points to: give up its
+   uses, keep its exit status if it was started last, and free it. */
+
+static void Scheduler_finish(Scheduler_T oScheduler,
+   struct Line **ppsLink)
+{
+   struct Line *psLine = *ppsLink;
+   size_t u;
+
+   for (u = 0; u < psLine->uUseCount; u++)
+   {
+      if (psLine->psUses[u].iWrite)
+         psLine->psUses[u].psFile->uWriters--;
+      else
+         psLine->psUses[u].psFile->uReaders--;
+   }
+   if (psLine->uNumber == oScheduler->uStarted)
+      oScheduler->iLastStatus = psLine->iStatus;
+
+   *ppsLink = psLine->psNext;
+   oScheduler->uLineCount--;
+   free(psLine->piPids);
+   free(psLine->psUses);
+   free(psLine);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Scheduler object with no lines running, or NULL if
+   insufficient memory is available. */
+
+Scheduler_T Scheduler_new(void)
+{
+   Scheduler_T oScheduler;
+   size_t u;
+
+   oScheduler = (struct Scheduler*)malloc(sizeof(struct Scheduler));
+   if (oScheduler == NULL)
+      return NULL;
+
+   oScheduler->psLines = NULL;
+   oScheduler->uLineCount = 0;
+   for (u = 0; u < BUCKET_COUNT; u++)
+      oScheduler->apsBuckets[u] = NULL;
+   oScheduler->psPending = NULL;
+   oScheduler->uPendingCount = 0;
+   oScheduler->uMaxPending = 0;
+   oScheduler->uStarted = 0;
+   oScheduler->iLastStatus = 0;
+   return oScheduler;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oScheduler. */
+
+void Scheduler_free(Scheduler_T oScheduler)
+{
+   if (oScheduler == NULL)
+      return;
+
+   while (oScheduler->psLines != NULL)
+      Scheduler_finish(oScheduler, &oScheduler->psLines);
+   Scheduler_removeUnused(oScheduler);
+   free(oScheduler->psPending);
+   free(oScheduler);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record that the next line of oScheduler reads the file named
+   pcName, or writes it if iWrite is TRUE. */
+
+void Scheduler_addFile(Scheduler_T oScheduler, const char *pcName,
+   int iWrite)
+{
+   struct Use *psUses;
+   size_t uMax;
+
+   assert(oScheduler != NULL);
+   assert(pcName != NULL);
+
+   if (oScheduler->uPendingCount == oScheduler->uMaxPending)
+   {
+      uMax = (oScheduler->uMaxPending == 0) ?
+         8 : 2 * oScheduler->uMaxPending;
+      psUses = (struct Use*)realloc(oScheduler->psPending,
+                                    uMax * sizeof(struct Use));
+      if (psUses == NULL)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+      oScheduler->psPending = psUses;
+      oScheduler->uMaxPending = uMax;
+   }
+
+   psUses = &oScheduler->psPending[oScheduler->uPendingCount++];
+   psUses->psFile = Scheduler_getFile(oScheduler, pcName);
+   psUses->iWrite = iWrite;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff the next line of oScheduler must wait for a
+   running line, because of the files that they use, or 0 (FALSE)
+   otherwise. */
+
+int Scheduler_isBlocked(Scheduler_T oScheduler)
+{
+   struct Use *psUse;
+   size_t u;
+
+   assert(oScheduler != NULL);
+
+   /* Running lines may read a file together, but a write excludes
+      any other use. */
+   for (u = 0; u < oScheduler->uPendingCount; u++)
+   {
+      psUse = &oScheduler->psPending[u];
+      if (psUse->psFile->uWriters > 0)
+         return 1;
+      if (psUse->iWrite && (psUse->psFile->uReaders > 0))
+         return 1;
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start the next line of oScheduler, which runs the uCount processes
+   whose IDs are in piPids, the last of which gives the line's exit
+   status. An ID of -1 is that of a command that could not be run. */
+
+void Scheduler_start(Scheduler_T oScheduler, const pid_t *piPids,
+   size_t uCount)
+{
+   struct Line *psLine;
+   size_t u;
+
+   assert(oScheduler != NULL);
+   assert(piPids != NULL);
+   assert(uCount > 0);
+
+   psLine = (struct Line*)malloc(sizeof(struct Line));
+   if (psLine == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psLine->piPids = (pid_t*)malloc(uCount * sizeof(pid_t));
+   if (psLine->piPids == NULL)
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psLine->uRunning = 0;
+   for (u = 0; u < uCount; u++)
+      if (piPids[u] != -1)
+         psLine->piPids[psLine->uRunning++] = piPids[u];
+   psLine->iLastPid = piPids[uCount - 1];
+   psLine->iStatus = EXIT_NOT_RUN;
+   psLine->uNumber = ++oScheduler->uStarted;
+
+   /* The line takes over the pending uses. */
+   psLine->psUses = oScheduler->psPending;
+   psLine->uUseCount = oScheduler->uPendingCount;
+   oScheduler->psPending = NULL;
+   oScheduler->uPendingCount = 0;
+   oScheduler->uMaxPending = 0;
+   for (u = 0; u < psLine->uUseCount; u++)
+   {
+      if (psLine->psUses[u].iWrite)
+         psLine->psUses[u].psFile->uWriters++;
+      else
+         psLine->psUses[u].psFile->uReaders++;
+   }
+
+   psLine->psNext = oScheduler->psLines;
+   oScheduler->psLines = psLine;
+   oScheduler->uLineCount++;
+
+   /* A line none of whose commands could be run is done already. */
+   if (psLine->uRunning == 0)
+      Scheduler_finish(oScheduler, &oScheduler->psLines);
+
+   /* Files that lines have stopped using go only now, when no
+      pending use can refer to them. */
+   Scheduler_removeUnused(oScheduler);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record that the process of oScheduler whose ID is iPid is done,
+   with exit status iStatus. Return 1 (TRUE) if iPid is a running
+   process of oScheduler, or 0 (FALSE) otherwise. */
+
+int Scheduler_setDone(Scheduler_T oScheduler, pid_t iPid, int iStatus)
+{
+   struct Line **ppsLink;
+   struct Line *psLine;
+   size_t u;
+
+   assert(oScheduler != NULL);
+
+   for (ppsLink = &oScheduler->psLines; (psLine = *ppsLink) != NULL;
+        ppsLink = &psLine->psNext)
+   {
+      for (u = 0; u < psLine->uRunning; u++)
+         if (psLine->piPids[u] == iPid)
+            break;
+      if (u == psLine->uRunning)
+         continue;
+
+      psLine->piPids[u] = psLine->piPids[--psLine->uRunning];
+      if (iPid == psLine->iLastPid)
+         psLine->iStatus = iStatus;
+      if (psLine->uRunning == 0)
+         Scheduler_finish(oScheduler, ppsLink);
+      return 1;
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of lines of oScheduler that are running. */
+
+size_t Scheduler_getRunningCount(Scheduler_T oScheduler)
+{
+   assert(oScheduler != NULL);
+
+   return oScheduler->uLineCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the exit status of the line of oScheduler that was started
+   last, which is known once that line is done, or 0 if no line has
+   been started. */
+
+int Scheduler_getLastStatus(Scheduler_T oScheduler)
+{
+   assert(oScheduler != NULL);
+
+   return oScheduler->iLastStatus;
+}
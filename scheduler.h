@@ -0,0 +1,81 @@
+/*--------------------------------------------------------------------*/
+/* scheduler.h                                                        */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef SCHEDULER_INCLUDED
+#define SCHEDULER_INCLUDED
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A Scheduler object keeps track of the lines of a script that are
+   running at once, and of the files that each one reads and writes,
+   so that a line starts only once no running line writes a file
+   that it reads or touches a file that it writes. */
+
+typedef struct Scheduler *Scheduler_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Scheduler object with no lines running, or NULL if
+   insufficient memory is available. */
+
+Scheduler_T Scheduler_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oScheduler. */
+
+void Scheduler_free(Scheduler_T oScheduler);
+
+/*--------------------------------------------------------------------*/
+
+/* Record that the next line of oScheduler reads the file named
+   pcName, or writes it if iWrite is TRUE. */
+
+void Scheduler_addFile(Scheduler_T oScheduler, const char *pcName,
+   int iWrite);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) iff the next line of oScheduler must wait for a
+   running line, because of the files that they use, or 0 (FALSE)
+   otherwise. */
+
+int Scheduler_isBlocked(Scheduler_T oScheduler);
+
+/*--------------------------------------------------------------------*/
+
+/* Start the next line of oScheduler, which runs the uCount processes
+   whose IDs are in piPids, the last of which gives the line's exit
+   status. An ID of -1 is that of a command that could not be run. */
+
+void Scheduler_start(Scheduler_T oScheduler, const pid_t *piPids,
+   size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Record that the process of oScheduler whose ID is iPid is done,
+   with exit status iStatus. Return 1 (TRUE) if iPid is a running
+   process of oScheduler, or 0 (FALSE) otherwise. */
+
+int Scheduler_setDone(Scheduler_T oScheduler, pid_t iPid, int iStatus);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of lines of oScheduler that are running. */
+
+size_t Scheduler_getRunningCount(Scheduler_T oScheduler);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the exit status of the line of oScheduler that was started
+   last, which is known once that line is done, or 0 if no line has
+   been started. */
+
+int Scheduler_getLastStatus(Scheduler_T oScheduler);
+
+#endif
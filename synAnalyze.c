@@ -10,171 +10,475 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <ctype.h>
 
 /*--------------------------------------------------------------------*/
 
 enum {FALSE, TRUE};
 
+/* The number of arguments that a new command has room for, and the
+   number of commands that a new SynAnalyze has room for. */
+
+enum {INITIAL_MAX_ARGS = 8, INITIAL_MAX_COMMANDS = 4};
+
+/* What a SynAnalyze expects its next token to be. */
+
+enum SynState {EXPECT_NAME, EXPECT_ARG, EXPECT_STDIN, EXPECT_STDOUT};
+
 /*--------------------------------------------------------------------*/
 
-/* Accept a dynamic array of oTokens and return a Command object,
-   unless the dynamic array conatians errors. In the case of errors,
-   return NULL. */
+/* A SynAnalyze is a command list being built from its tokens: what
+   it expects next, the first error found, if any, the pipelines
+   finished so far, the commands of the current pipeline finished so
+   far, and the parts of the current command found so far. */
 
-Command_T SynAnalyze_analyze(DynArray_T oTokens)
+struct SynAnalyze
 {
-	size_t index;
-	Command_T oCommand;
-	DynArray_T oArguments = NULL;
-	int stdInPresent = FALSE;
-	int stdOutPresent = FALSE; 
-	int argsCount = 0;
-	Token_T oToken = NULL;
-	char* stdIn = NULL;
-	char* stdOut = NULL;
-	char* commandName; 
+	/* The arena from which the command is allocated. */
+	Arena_T oArena;
+
+	/* What the next token is expected to be. */
+	enum SynState eState;
+
+	/* The first error found, or NULL if there is none. */
+	const char* pcError;
+
+	/* Whether an operator needs a command after it. */
+	int iNeedCommand;
+
+	/* The pipelines finished so far, and the condition under which
+	   the current one runs. */
+	CommandList_T oCommandList;
+	enum ListCondition eCondition;
+
+	/* The commands of the current pipeline finished so far, their
+	   number, and the number of commands that poCommands has room
+	   for. */
+	Command_T* poCommands;
+	size_t uCommandCount;
+	size_t uMaxCommands;
+
+	/* StdIn and StdOut file names. */
+	char* pcStdIn;
+	char* pcStdOut;
+
+	/* The name followed by the arguments, with room for a NULL after
+	   them, the number of arguments, and the number of arguments
+	   that ppcArgv has room for. Each Command copies ppcArgv, so
+	   every command of the list reuses it. */
+	char** ppcArgv;
+	size_t uArgCount;
+	size_t uMaxArgs;
+
+	/* For the name and each argument, whether it held a quoted
+	   literal, with as much room as ppcArgv, and whether any did.
+	   Each Command copies piQuoted only if one did. */
+	int* piQuoted;
+	int iAnyQuoted;
+
+	/* The "name=value" assignments before the name, their number,
+	   and the number that ppcAssigns has room for. Each Command
+	   copies them too. */
+	char** ppcAssigns;
+	size_t uAssignCount;
+	size_t uMaxAssigns;
+};
 
-	assert(oTokens != NULL);
-	if (DynArray_getLength(oTokens) == 0) return NULL;
+/*--------------------------------------------------------------------*/
+
+/* Start a new, empty command in oSynAnalyze. */
+
+static void SynAnalyze_startCommand(SynAnalyze_T oSynAnalyze)
+{
+	assert(oSynAnalyze != NULL);
+
+	oSynAnalyze->eState = EXPECT_NAME;
+	oSynAnalyze->pcStdIn = NULL;
+	oSynAnalyze->pcStdOut = NULL;
+	oSynAnalyze->uArgCount = 0;
+	oSynAnalyze->iAnyQuoted = FALSE;
+	oSynAnalyze->uAssignCount = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Finish the current command of oSynAnalyze, handing the strings of
+   its arguments, StdIn and StdOut over to a new Command as they are,
+   and add it to the commands of oSynAnalyze. */
+
+static void SynAnalyze_endCommand(SynAnalyze_T oSynAnalyze)
+{
+	Command_T* poCommands;
 
-	/* Store the first token as commandName.
-	   Make sure it's ORDINARY. */
-	oToken = DynArray_get(oTokens, 0);
+	assert(oSynAnalyze != NULL);
+	assert(oSynAnalyze->eState == EXPECT_ARG);
 
-	if (Token_getType(oToken) != TOKEN_ORDINARY)
+	if (oSynAnalyze->uCommandCount == oSynAnalyze->uMaxCommands)
 	{
-		fprintf(stderr, "%s: missing command name\n", pcPgmName);
-		return NULL;
+		poCommands = (Command_T*)Arena_alloc(oSynAnalyze->oArena,
+			sizeof(Command_T) * 2 * oSynAnalyze->uMaxCommands);
+		memcpy(poCommands, oSynAnalyze->poCommands, 
+			sizeof(Command_T) * oSynAnalyze->uCommandCount);
+		oSynAnalyze->poCommands = poCommands;
+		oSynAnalyze->uMaxCommands *= 2;
 	}
 
-	commandName = Token_getVal(oToken);
+	oSynAnalyze->ppcArgv[oSynAnalyze->uArgCount + 1] = NULL;
+	oSynAnalyze->poCommands[oSynAnalyze->uCommandCount++] = 
+		Command_new(oSynAnalyze->oArena, oSynAnalyze->ppcArgv,
+			oSynAnalyze->uArgCount, 
+			oSynAnalyze->iAnyQuoted ? oSynAnalyze->piQuoted : NULL,
+			oSynAnalyze->pcStdIn,
+			oSynAnalyze->pcStdOut, oSynAnalyze->ppcAssigns,
+			oSynAnalyze->uAssignCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start a new, empty pipeline in oSynAnalyze. */
+
+static void SynAnalyze_startPipeline(SynAnalyze_T oSynAnalyze)
+{
+	assert(oSynAnalyze != NULL);
 
-	/* Traverse oTokens to find command, StdIn, & Stdout. */
-	for (index = 1; index < DynArray_getLength(oTokens); index++)
+	oSynAnalyze->poCommands = (Command_T*)Arena_alloc(
+		oSynAnalyze->oArena, sizeof(Command_T) * INITIAL_MAX_COMMANDS);
+	oSynAnalyze->uCommandCount = 0;
+	oSynAnalyze->uMaxCommands = INITIAL_MAX_COMMANDS;
+	SynAnalyze_startCommand(oSynAnalyze);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Finish the current pipeline of oSynAnalyze, and add it to the
+   command list of oSynAnalyze, to run in the background if
+   iBackground is TRUE. */
+
+static void SynAnalyze_endPipeline(SynAnalyze_T oSynAnalyze, 
+	int iBackground)
+{
+	assert(oSynAnalyze != NULL);
+
+	SynAnalyze_endCommand(oSynAnalyze);
+	CommandList_add(oSynAnalyze->oCommandList, 
+		Pipeline_new(oSynAnalyze->oArena, oSynAnalyze->poCommands,
+			oSynAnalyze->uCommandCount), 
+		oSynAnalyze->eCondition, iBackground);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SynAnalyze object, allocated from oArena, that is
+   ready to accept the tokens of a command list. */
+
+SynAnalyze_T SynAnalyze_new(Arena_T oArena)
+{
+	SynAnalyze_T oSynAnalyze;
+
+	assert(oArena != NULL);
+
+	oSynAnalyze = (struct SynAnalyze*)
+		Arena_alloc(oArena, sizeof(struct SynAnalyze));
+	oSynAnalyze->oArena = oArena;
+	oSynAnalyze->pcError = NULL;
+	oSynAnalyze->iNeedCommand = FALSE;
+	oSynAnalyze->oCommandList = CommandList_new(oArena);
+	oSynAnalyze->eCondition = RUN_ALWAYS;
+	oSynAnalyze->ppcArgv = (char**)Arena_alloc(oArena, 
+		sizeof(char*) * (INITIAL_MAX_ARGS + 2));
+	oSynAnalyze->piQuoted = (int*)Arena_alloc(oArena, 
+		sizeof(int) * (INITIAL_MAX_ARGS + 2));
+	oSynAnalyze->uMaxArgs = INITIAL_MAX_ARGS;
+	oSynAnalyze->ppcAssigns = NULL;
+	oSynAnalyze->uMaxAssigns = 0;
+	SynAnalyze_startPipeline(oSynAnalyze);
+
+	return oSynAnalyze;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the argument pcArg to oSynAnalyze, which held a quoted literal
+   iff iQuoted is TRUE.  The arguments grow geometrically, so that
+   adding each one takes constant time on average. */
+
+static void SynAnalyze_addArg(SynAnalyze_T oSynAnalyze, char* pcArg,
+	int iQuoted)
+{
+	char** ppcArgv;
+	int* piQuoted;
+
+	assert(oSynAnalyze != NULL);
+
+	if (oSynAnalyze->uArgCount == oSynAnalyze->uMaxArgs)
 	{
-		oToken = DynArray_get(oTokens, index);
+		ppcArgv = (char**)Arena_alloc(oSynAnalyze->oArena,
+			sizeof(char*) * (2 * oSynAnalyze->uMaxArgs + 2));
+		memcpy(ppcArgv, oSynAnalyze->ppcArgv, 
+			sizeof(char*) * (oSynAnalyze->uArgCount + 1));
+		oSynAnalyze->ppcArgv = ppcArgv;
+		piQuoted = (int*)Arena_alloc(oSynAnalyze->oArena,
+			sizeof(int) * (2 * oSynAnalyze->uMaxArgs + 2));
+		memcpy(piQuoted, oSynAnalyze->piQuoted, 
+			sizeof(int) * (oSynAnalyze->uArgCount + 1));
+		oSynAnalyze->piQuoted = piQuoted;
+		oSynAnalyze->uMaxArgs *= 2;
+	}
+	oSynAnalyze->ppcArgv[++oSynAnalyze->uArgCount] = pcArg;
+	oSynAnalyze->piQuoted[oSynAnalyze->uArgCount] = iQuoted;
+	if (iQuoted) oSynAnalyze->iAnyQuoted = TRUE;
+}
 
-		if (Token_getType(oToken) == TOKEN_SPECIAL)
-		{
-			/* If the special token is StdIn... */
-			if (strcmp(Token_getVal(oToken), "<") == 0)
+/*--------------------------------------------------------------------*/
+
+/* Return TRUE iff pcVal is a variable assignment, "name=value", whose
+   name is a letter or underscore followed by letters, digits and
+   underscores. */
+
+static int SynAnalyze_isAssignment(const char* pcVal)
+{
+	assert(pcVal != NULL);
+
+	if ((*pcVal != '_') && (! isalpha((unsigned char)*pcVal)))
+		return FALSE;
+	for (pcVal++; (*pcVal == '_') || isalnum((unsigned char)*pcVal); 
+		pcVal++)
+		;
+	return (*pcVal == '=');
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the assignment pcAssign, which holds for the current command
+   alone, to oSynAnalyze. Few commands have any, so the room for them
+   is made when the first one comes, and grows geometrically. */
+
+static void SynAnalyze_addAssignment(SynAnalyze_T oSynAnalyze, 
+	char* pcAssign)
+{
+	char** ppcAssigns;
+	size_t uMaxAssigns;
+
+	assert(oSynAnalyze != NULL);
+
+	if (oSynAnalyze->uAssignCount == oSynAnalyze->uMaxAssigns)
+	{
+		uMaxAssigns = (oSynAnalyze->uMaxAssigns == 0) ? 
+			INITIAL_MAX_ARGS : 2 * oSynAnalyze->uMaxAssigns;
+		ppcAssigns = (char**)Arena_alloc(oSynAnalyze->oArena,
+			sizeof(char*) * uMaxAssigns);
+		if (oSynAnalyze->uAssignCount > 0)
+			memcpy(ppcAssigns, oSynAnalyze->ppcAssigns, 
+				sizeof(char*) * oSynAnalyze->uAssignCount);
+		oSynAnalyze->ppcAssigns = ppcAssigns;
+		oSynAnalyze->uMaxAssigns = uMaxAssigns;
+	}
+	oSynAnalyze->ppcAssigns[oSynAnalyze->uAssignCount++] = pcAssign;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Accept the next token of the command list that pvSynAnalyze, a
+   SynAnalyze object, is building: a token whose type is eType and
+   whose value is the string pcVal.  pcVal must last as long as the
+   command list.  An error is reported only when the command list is
+   finished. This is a LexDFA_TokenFunction. */
+
+void SynAnalyze_addToken(enum TokenType eType, char* pcVal,
+	void* pvSynAnalyze)
+{
+	SynAnalyze_T oSynAnalyze = (SynAnalyze_T)pvSynAnalyze;
+
+	assert(oSynAnalyze != NULL);
+	assert(pcVal != NULL);
+
+	/* Ignore everything after the first error. */
+	if (oSynAnalyze->pcError != NULL) return;
+
+	switch (oSynAnalyze->eState)
+	{
+		/* The first token is the command name, after any variable
+		   assignments. Make sure it's ORDINARY. */
+		case EXPECT_NAME:
+			if (eType == TOKEN_SPECIAL)
 			{
-				/* ...make sure there isn't more than one... */
-				if (stdInPresent == TRUE)
-				{
-					fprintf(stderr, 
-						"%s: multiple redirection of standard input\n",
-						pcPgmName);
-					return NULL;
-				}
-
-				/* ... mark stdInPresent as TRUE.... */
-				stdInPresent = TRUE;
-
-				/* ... make sure there is a file destination... */
-				/* (ensure not at the end of the dynarray) */
-				if (index == (DynArray_getLength(oTokens) - 1))
-				{
-					fprintf(stderr, 
-						"%s: standard input redirection",
-						pcPgmName);
-					fprintf(stderr, " without file name\n");
-					if (oArguments != NULL) DynArray_free(oArguments);
-					return NULL;
-				}
-
-				/* ...if there is another token, save it as StdIn. */
-				oToken = DynArray_get(oTokens, ++index);
-
-				/* If the next token is SPECIAL, return error. */
-				if (Token_getType(oToken) == TOKEN_SPECIAL)
-				{
-					fprintf(stderr, 
-						"%s: standard input redirection",
-						pcPgmName);
-					fprintf(stderr, " without file name\n");
-					if (oArguments != NULL) DynArray_free(oArguments);
-					return NULL;
-				}
-
-				/* Otherwise, save the ordinary token as StdIn. */
-				stdIn = Token_getVal(oToken);
+				oSynAnalyze->pcError = "missing command name";
+				return;
 			}
-
-		/* Otherwise, if the token is StdOut... */
-		else 
-		{
-				/* ...make sure there isn't more than one... */
-			if (stdOutPresent == TRUE)
+			if (SynAnalyze_isAssignment(pcVal))
 			{
-				fprintf(stderr, 
-					"%s: multiple redirection of standard output\n",
-					pcPgmName);
-				if (oArguments != NULL) DynArray_free(oArguments);
-				return NULL; 
+				SynAnalyze_addAssignment(oSynAnalyze, pcVal);
+				oSynAnalyze->iNeedCommand = TRUE;
+				return;
 			}
-
-			stdOutPresent = TRUE;
-
-				/* ...make sure there is a file destination... */
-			if (index == (DynArray_getLength(oTokens) - 1))
+			oSynAnalyze->ppcArgv[0] = pcVal;
+			oSynAnalyze->piQuoted[0] = (eType == TOKEN_QUOTED);
+			oSynAnalyze->iAnyQuoted = (eType == TOKEN_QUOTED);
+			oSynAnalyze->eState = EXPECT_ARG;
+			oSynAnalyze->iNeedCommand = FALSE;
+			return;
+
+		/* If the token after < is SPECIAL, return error. 
+		   Otherwise, save the ordinary token as StdIn. */
+		case EXPECT_STDIN:
+			if (eType == TOKEN_SPECIAL)
 			{
-				fprintf(stderr, 
-					"%s: standard output redirection",
-					pcPgmName);
-				fprintf(stderr, " without file name\n");
-				if (oArguments != NULL) DynArray_free(oArguments);
-				return NULL;
+				oSynAnalyze->pcError = 
+					"standard input redirection without file name";
+				return;
 			}
-
-				/* ...if there is another token, save it as StdOut. */
-			oToken = DynArray_get(oTokens, ++index);
-
-				/* If the next tokem is SPECIAL, return error. */
-			if (Token_getType(oToken) == TOKEN_SPECIAL)
+			oSynAnalyze->pcStdIn = pcVal;
+			oSynAnalyze->eState = EXPECT_ARG;
+			return;
+
+		/* If the token after > is SPECIAL, return error. 
+		   Otherwise, save the ordinary token as StdOut. */
+		case EXPECT_STDOUT:
+			if (eType == TOKEN_SPECIAL)
 			{
-				fprintf(stderr, 
-					"%s: standard input redirection",
-					pcPgmName);
-				fprintf(stderr, " without file name\n");
-				if (oArguments != NULL) DynArray_free(oArguments);
-				return NULL;
+				oSynAnalyze->pcError = 
+					"standard input redirection without file name";
+				return;
 			}
+			oSynAnalyze->pcStdOut = pcVal;
+			oSynAnalyze->eState = EXPECT_ARG;
+			return;
 
-			stdOut = Token_getVal(oToken);
-		}
+		case EXPECT_ARG:
+			break;
+	}
+
+	/* If the token is ORDINARY or QUOTED, add the argument. */
+	if (eType != TOKEN_SPECIAL)
+	{
+		SynAnalyze_addArg(oSynAnalyze, pcVal, eType == TOKEN_QUOTED);
 	}
 
-		/* Otherwise, if the token is ORDINARY. */
-		else
+	/* Otherwise, if the special token is a pipe, make sure StdOut
+	   is not redirected as well, and start the next command. */
+	else if (strcmp(pcVal, "|") == 0)
+	{
+		if (oSynAnalyze->pcStdOut != NULL)
 		{
-			/* Make new dynarray is there are no args yet. */
-			if (argsCount == 0)
-			{
-				oArguments = DynArray_new(0);
+			oSynAnalyze->pcError = 
+				"multiple redirection of standard output";
+			return;
+		}
+		SynAnalyze_endCommand(oSynAnalyze);
+		SynAnalyze_startCommand(oSynAnalyze);
+		oSynAnalyze->iNeedCommand = TRUE;
+	}
 
-				/* Return error if unsufficient memory. */
-				if (oArguments == NULL)
-					{perror(pcPgmName); exit(EXIT_FAILURE);}
+	/* Otherwise, if the special token joins two pipelines, start
+	   the next one, which runs always, or only if the list so far
+	   succeeds or fails. "&" runs the pipeline before it in the
+	   background. Only ";" and "&" may end the list. */
+	else if ((strcmp(pcVal, ";") == 0) || (strcmp(pcVal, "&") == 0) ||
+		(strcmp(pcVal, "&&") == 0) || (strcmp(pcVal, "||") == 0))
+	{
+		SynAnalyze_endPipeline(oSynAnalyze, strcmp(pcVal, "&") == 0);
+		SynAnalyze_startPipeline(oSynAnalyze);
+		if (strcmp(pcVal, "&&") == 0) 
+			oSynAnalyze->eCondition = RUN_IF_SUCCESS;
+		else if (strcmp(pcVal, "||") == 0) 
+			oSynAnalyze->eCondition = RUN_IF_FAILURE;
+		else oSynAnalyze->eCondition = RUN_ALWAYS;
+		oSynAnalyze->iNeedCommand = (pcVal[1] != '\0');
+	}
 
-				argsCount++;
-			}
+	/* Otherwise, if the special token is StdIn, make sure there
+	   isn't more than one, counting a pipe from the previous
+	   command; the file name comes next. */
+	else if (strcmp(pcVal, "<") == 0)
+	{
+		if ((oSynAnalyze->pcStdIn != NULL) ||
+			(oSynAnalyze->uCommandCount > 0))
+		{
+			oSynAnalyze->pcError = 
+				"multiple redirection of standard input";
+			return;
+		}
+		oSynAnalyze->eState = EXPECT_STDIN;
+	}
 
-			/* Add the argument to the dynarray. */
-			DynArray_add(oArguments, Token_getVal(oToken));
+	/* Otherwise, if the token is StdOut... */
+	else if (strcmp(pcVal, ">") == 0)
+	{
+		if (oSynAnalyze->pcStdOut != NULL)
+		{
+			oSynAnalyze->pcError = 
+				"multiple redirection of standard output";
+			return;
 		}
+		oSynAnalyze->eState = EXPECT_STDOUT;
+	}
+
+	/* Otherwise, the special token has no meaning here. */
+	else oSynAnalyze->pcError = "unexpected special token";
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Finish the command list that oSynAnalyze is building, and return
+   it as a CommandList object allocated from the arena of
+   oSynAnalyze, unless its tokens contain errors or there are none.
+   In the case of errors, report the first one and return NULL. */
+
+CommandList_T SynAnalyze_finish(SynAnalyze_T oSynAnalyze)
+{
+	assert(oSynAnalyze != NULL);
+
+	/* Make sure a redirection has a file destination, and a pipe
+	   or an operator has a command. */
+	if (oSynAnalyze->pcError == NULL)
+	{
+		if (oSynAnalyze->eState == EXPECT_STDIN)
+			oSynAnalyze->pcError = 
+				"standard input redirection without file name";
+		else if (oSynAnalyze->eState == EXPECT_STDOUT)
+			oSynAnalyze->pcError = 
+				"standard output redirection without file name";
+		else if (oSynAnalyze->iNeedCommand)
+			oSynAnalyze->pcError = "missing command name";
+	}
+
+	if (oSynAnalyze->pcError != NULL)
+	{
+		fprintf(stderr, "%s: %s\n", pcPgmName, oSynAnalyze->pcError);
+		return NULL;
 	}
 
-	/* Call Command to make the new Command with StdIn, StdOut,
-	   commandName, and oArguments. */
-	oCommand = Command_new(commandName, stdIn, stdOut, oArguments);
+	/* A list may end with ";" or "&", and may be empty. */
+	if (oSynAnalyze->eState != EXPECT_NAME)
+		SynAnalyze_endPipeline(oSynAnalyze, FALSE);
+	if (CommandList_getLength(oSynAnalyze->oCommandList) == 0)
+		return NULL;
+
+	return oSynAnalyze->oCommandList;
+}
 
-	/* Return error if unsufficient memory. */
-	if (oCommand == NULL)
-		{perror(pcPgmName); exit(EXIT_FAILURE);}
+/*--------------------------------------------------------------------*/
 
-	if (argsCount > 0) DynArray_free(oArguments);
+/* Accept a list of oTokens and return a CommandList object allocated
+   from oArena, unless the list contains errors. In the case of
+   errors, return NULL. */
 
-	return oCommand;
+CommandList_T SynAnalyze_analyze(Arena_T oArena, TokenList_T oTokens)
+{
+	SynAnalyze_T oSynAnalyze;
+	size_t index;
+
+	assert(oTokens != NULL);
+	if (TokenList_getLength(oTokens) == 0) return NULL;
+
+	oSynAnalyze = SynAnalyze_new(oArena);
+	for (index = 0; index < TokenList_getLength(oTokens); index++)
+	{
+		SynAnalyze_addToken(TokenList_getType(oTokens, index),
+			TokenList_getVal(oTokens, index), oSynAnalyze);
+	}
+
+	return SynAnalyze_finish(oSynAnalyze);
 }
 
+/*--------------------------------------------------------------------*/
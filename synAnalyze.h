@@ -6,16 +6,51 @@
 #ifndef SYNANALYZE_INCLUDED
 #define SYNANALYZE_INCLUDED
 
-#include "command.h"
-#include "dynarray.h"
+#include "commandlist.h"
+#include "arena.h"
+#include "token.h"
 
 /*--------------------------------------------------------------------*/
 
-/* Accept a dynamic array of oTokens and return a Command object,
-   unless the dynamic array conatians errors. In the case of errors,
-   return NULL. */
+/* A SynAnalyze object builds a command list of pipelines of commands
+   from its tokens as they are found, one at a time. */
 
-Command_T SynAnalyze_analyze(DynArray_T oTokens);
+typedef struct SynAnalyze* SynAnalyze_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SynAnalyze object, allocated from oArena, that is
+   ready to accept the tokens of a command list. */
+
+SynAnalyze_T SynAnalyze_new(Arena_T oArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Accept the next token of the command list that pvSynAnalyze, a
+   SynAnalyze object, is building: a token whose type is eType and
+   whose value is the string pcVal.  pcVal must last as long as the
+   command list.  An error is reported only when the command list is
+   finished. This is a LexDFA_TokenFunction. */
+
+void SynAnalyze_addToken(enum TokenType eType, char* pcVal,
+	void* pvSynAnalyze);
+
+/*--------------------------------------------------------------------*/
+
+/* Finish the command list that oSynAnalyze is building, and return
+   it as a CommandList object allocated from the arena of
+   oSynAnalyze, unless its tokens contain errors or there are none.
+   In the case of errors, report the first one and return NULL. */
+
+CommandList_T SynAnalyze_finish(SynAnalyze_T oSynAnalyze);
+
+/*--------------------------------------------------------------------*/
+
+/* Accept a list of oTokens and return a CommandList object allocated
+   from oArena, unless the list contains errors. In the case of
+   errors, return NULL. */
+
+CommandList_T SynAnalyze_analyze(Arena_T oArena, TokenList_T oTokens);
 
 /*--------------------------------------------------------------------*/
 
@@ -4,97 +4,219 @@
 /*--------------------------------------------------------------------*/
 
 #include "token.h"
-#include "ish.h"
 #include <assert.h>
-#include <string.h>
 #include <stdio.h>
-#include <stdlib.h>
+#include <string.h>
 
 /*--------------------------------------------------------------------*/
 
-/* A Token is either a number or a word, expressed as a string. */
+/* A Token is special, ordinary or quoted; its value is a slice of the
+   text buffer of its TokenList. */
 
 struct Token
 {
    /* The type of the token. */
    enum TokenType eType;
 
-   /* The string which is the token's value. */
-   char *pcValue;
+   /* The offset of the token's value in the text buffer. */
+   size_t uOffset;
+
+   /* The length of the token's value. */
+   size_t uLength;
 };
 
 /*--------------------------------------------------------------------*/
 
-/* Write a single token, psToken, to stdout. */
+/* A TokenList is a flat array of tokens, with its logical and physical
+   lengths, followed in the same allocation by the text buffer. */
+
+struct TokenList
+{
+   /* The number of tokens in the TokenList. */
+   size_t uLength;
+
+   /* The number of tokens that psTokens has room for. */
+   size_t uMaxLength;
+
+   /* The array of tokens. */
+   struct Token *psTokens;
+
+   /* The text buffer that holds the values of the tokens. */
+   char *pcText;
+
+   /* The number of characters that pcText has room for. */
+   size_t uTextLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty TokenList object with room for uMaxTokens
+   tokens whose text, null characters included, takes up to
+   uTextLength characters. The TokenList is a single allocation from
+   oArena, and lasts until oArena is reset. */
+
+TokenList_T TokenList_new(Arena_T oArena, size_t uMaxTokens,
+   size_t uTextLength)
+{
+   TokenList_T oTokens;
+
+   assert(oArena != NULL);
+
+   /* The array and the text follow the header in one block. */
+   oTokens = (struct TokenList*)Arena_alloc(oArena,
+      sizeof(struct TokenList) + uMaxTokens * sizeof(struct Token) +
+      uTextLength);
+
+   oTokens->uLength = 0;
+   oTokens->uMaxLength = uMaxTokens;
+   oTokens->psTokens = (struct Token*)(oTokens + 1);
+   oTokens->pcText = (char*)(oTokens->psTokens + uMaxTokens);
+   oTokens->uTextLength = uTextLength;
+
+   return oTokens;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a TokenList object that holds the tokens of oTokens and the
+   first uTextUsed characters of its text buffer, with room for
+   uMoreTokens more tokens and uMoreText more characters. If oTokens
+   has that room, return oTokens itself; otherwise return a copy with
+   at least twice the room of oTokens, allocated from oArena. If
+   oTokens is NULL, return a new, empty TokenList object. */
 
-void Token_writeToken(Token_T psToken)
+TokenList_T TokenList_reserve(Arena_T oArena, TokenList_T oTokens,
+   size_t uTextUsed, size_t uMoreTokens, size_t uMoreText)
 {
-	assert(psToken != NULL);
+   TokenList_T oNewTokens;
+   size_t uMaxTokens;
+   size_t uTextLength;
 
-	   	printf("Token: %s ", psToken->pcValue);
-   	if (psToken->eType == TOKEN_SPECIAL)
-   		printf("(special)\n");
-   	else printf("(ordinary)\n");
+   assert(oArena != NULL);
+
+   if (oTokens == NULL)
+      return TokenList_new(oArena, uMoreTokens, uMoreText);
+
+   assert(uTextUsed <= oTokens->uTextLength);
+
+   if ((oTokens->uMaxLength - oTokens->uLength >= uMoreTokens) &&
+       (oTokens->uTextLength - uTextUsed >= uMoreText))
+      return oTokens;
+
+   /* Grow geometrically, so that reserving a little at a time costs
+      time linear in the total. */
+   uMaxTokens = 2 * oTokens->uMaxLength;
+   if (uMaxTokens < oTokens->uLength + uMoreTokens)
+      uMaxTokens = oTokens->uLength + uMoreTokens;
+   uTextLength = 2 * oTokens->uTextLength;
+   if (uTextLength < uTextUsed + uMoreText)
+      uTextLength = uTextUsed + uMoreText;
+
+   oNewTokens = TokenList_new(oArena, uMaxTokens, uTextLength);
+   memcpy(oNewTokens->psTokens, oTokens->psTokens,
+          oTokens->uLength * sizeof(struct Token));
+   memcpy(oNewTokens->pcText, oTokens->pcText, uTextUsed);
+   oNewTokens->uLength = oTokens->uLength;
+
+   return oNewTokens;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Free token psToken. */
+/* Return the text buffer of oTokens, into which the text of each
+   token is written before the token is added. */
 
-void Token_freeToken(Token_T psToken)
+char *TokenList_getText(TokenList_T oTokens)
 {
-	assert(psToken != NULL);
+   assert(oTokens != NULL);
 
-	free(psToken->pcValue);
-	free(psToken);
+   return oTokens->pcText;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Create and return a token whose type is eTokenType and whose
-   value consists of string pcValue.  The caller owns the token. */
+/* Add to the end of oTokens a token whose type is eTokenType and
+   whose value is the uLength characters at offset uOffset of the text
+   buffer of oTokens. The character after them must be a null
+   character. */
 
-Token_T Token_newToken(enum TokenType eTokenType,
-   char *pcValue)
+void TokenList_add(TokenList_T oTokens, enum TokenType eTokenType,
+   size_t uOffset, size_t uLength)
 {
-   Token_T psToken;
+   struct Token *psToken;
 
-   /* assert pcValue is not NULL. */
-   assert(pcValue != NULL);
+   assert(oTokens != NULL);
+   assert(oTokens->uLength < oTokens->uMaxLength);
+   assert(oTokens->pcText[uOffset + uLength] == '\0');
 
-   /* Allocate memory and create token (copied over). */
-   psToken = (struct Token*)malloc(sizeof(struct Token));
-   if (psToken == NULL)
-      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psToken = &oTokens->psTokens[oTokens->uLength++];
    psToken->eType = eTokenType;
-   psToken->pcValue = (char*)malloc(strlen(pcValue) + 1);
-   if (psToken->pcValue == NULL)
-      {perror(pcPgmName); exit(EXIT_FAILURE);}
-   strcpy(psToken->pcValue, pcValue);
+   psToken->uOffset = uOffset;
+   psToken->uLength = uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of tokens in oTokens. */
+
+size_t TokenList_getLength(TokenList_T oTokens)
+{
+   assert(oTokens != NULL);
 
-   return psToken;
+   return oTokens->uLength;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Return the eType of oToken. */
+/* Return the eType of the uIndex'th token of oTokens. */
 
-enum TokenType Token_getType(Token_T oToken)
+enum TokenType TokenList_getType(TokenList_T oTokens, size_t uIndex)
 {
-   assert(oToken != NULL);
+   assert(oTokens != NULL);
+   assert(uIndex < oTokens->uLength);
 
-   return oToken->eType;
+   return oTokens->psTokens[uIndex].eType;
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Return the string value of oToken. */
+/* Return the string value of the uIndex'th token of oTokens. The
+   string lives in the text buffer of oTokens. */
 
-char* Token_getVal(Token_T oToken)
+char *TokenList_getVal(TokenList_T oTokens, size_t uIndex)
 {
-   assert(oToken != NULL);
+   assert(oTokens != NULL);
+   assert(uIndex < oTokens->uLength);
 
-   return oToken->pcValue;
+   return oTokens->pcText + oTokens->psTokens[uIndex].uOffset;
 }
 
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the string value of the uIndex'th token of
+   oTokens. */
+
+size_t TokenList_getValLength(TokenList_T oTokens, size_t uIndex)
+{
+   assert(oTokens != NULL);
+   assert(uIndex < oTokens->uLength);
+
+   return oTokens->psTokens[uIndex].uLength;
+}
 
+/*--------------------------------------------------------------------*/
+
+/* Write the uIndex'th token of oTokens to stdout. */
+
+void TokenList_writeToken(TokenList_T oTokens, size_t uIndex)
+{
+   assert(oTokens != NULL);
+   assert(uIndex < oTokens->uLength);
+
+   printf("Token: %s ", TokenList_getVal(oTokens, uIndex));
+   if (oTokens->psTokens[uIndex].eType == TOKEN_SPECIAL)
+      printf("(special)\n");
+   else if (oTokens->psTokens[uIndex].eType == TOKEN_QUOTED)
+      printf("(ordinary, quoted)\n");
+   else printf("(ordinary)\n");
+}
@@ -6,59 +6,100 @@
 #ifndef TOKEN_INCLUDED
 #define TOKEN_INCLUDED
 
+#include "arena.h"
 #include <stddef.h>
 
 /*--------------------------------------------------------------------*/
 
-/* A Token object can be either a special or ordinary. */
+/* A Token object can be either a special or ordinary. An ordinary
+   token that holds a quoted literal is TOKEN_QUOTED, so that the
+   shell does not read it as a pattern of file names. */
 
-enum TokenType {TOKEN_SPECIAL, TOKEN_ORDINARY};
+enum TokenType {TOKEN_SPECIAL, TOKEN_ORDINARY, TOKEN_QUOTED};
 
 /*--------------------------------------------------------------------*/
 
-/* A token object is a sequence of non-white-space characters that is 
+/* A token is a sequence of non-white-space characters that is 
    separated from other tokens by white-space characters. The special 
    characters '<' and '>' form separate special tokens. Strings 
-   enclosed in double quotes (") form part or all of a single token. */
+   enclosed in double quotes (") form part or all of a single token.
 
-typedef struct Token *Token_T;
+   A TokenList object holds the tokens of one line in a flat array.
+   Each token is only a type, an offset and a length into one text
+   buffer that holds the text of every token, each followed by a null
+   character. */
+
+typedef struct TokenList *TokenList_T;
 
 /*--------------------------------------------------------------------*/
 
-/* Write a single token, psToken, to stdout. */
+/* Return a new, empty TokenList object with room for uMaxTokens
+   tokens whose text, null characters included, takes up to
+   uTextLength characters. The TokenList is a single allocation from
+   oArena, and lasts until oArena is reset. */
 
-void Token_writeToken(Token_T psToken);
+TokenList_T TokenList_new(Arena_T oArena, size_t uMaxTokens,
+   size_t uTextLength);
 
 /*--------------------------------------------------------------------*/
 
-/* Free token psToken. */
+/* Return a TokenList object that holds the tokens of oTokens and the
+   first uTextUsed characters of its text buffer, with room for
+   uMoreTokens more tokens and uMoreText more characters. If oTokens
+   has that room, return oTokens itself; otherwise return a copy with
+   at least twice the room of oTokens, allocated from oArena. If
+   oTokens is NULL, return a new, empty TokenList object. */
 
-void Token_freeToken(Token_T psToken);
+TokenList_T TokenList_reserve(Arena_T oArena, TokenList_T oTokens,
+   size_t uTextUsed, size_t uMoreTokens, size_t uMoreText);
 
 /*--------------------------------------------------------------------*/
 
-/* Create and return a token whose type is eTokenType and whose
-   value consists of string pcValue.  The caller owns the token. */
+/* Return the text buffer of oTokens, into which the text of each
+   token is written before the token is added. */
 
-Token_T Token_newToken(enum TokenType eTokenType,
-   char *pcValue);
+char *TokenList_getText(TokenList_T oTokens);
 
 /*--------------------------------------------------------------------*/
 
-/* Return the eType of oToken. */
+/* Add to the end of oTokens a token whose type is eTokenType and
+   whose value is the uLength characters at offset uOffset of the text
+   buffer of oTokens. The character after them must be a null
+   character. */
 
-enum TokenType Token_getType(Token_T oToken);
+void TokenList_add(TokenList_T oTokens, enum TokenType eTokenType,
+   size_t uOffset, size_t uLength);
 
 /*--------------------------------------------------------------------*/
 
+/* Return the number of tokens in oTokens. */
+
+size_t TokenList_getLength(TokenList_T oTokens);
+
+/*--------------------------------------------------------------------*/
 
-/* Return the string value of oToken. */
+/* Return the eType of the uIndex'th token of oTokens. */
 
-char* Token_getVal(Token_T oToken);
+enum TokenType TokenList_getType(TokenList_T oTokens, size_t uIndex);
 
 /*--------------------------------------------------------------------*/
 
+/* Return the string value of the uIndex'th token of oTokens. The
+   string lives in the text buffer of oTokens. */
 
+char *TokenList_getVal(TokenList_T oTokens, size_t uIndex);
 
-#endif
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the string value of the uIndex'th token of
+   oTokens. */
 
+size_t TokenList_getValLength(TokenList_T oTokens, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uIndex'th token of oTokens to stdout. */
+
+void TokenList_writeToken(TokenList_T oTokens, size_t uIndex);
+
+#endif
@@ -0,0 +1,477 @@
+/*--------------------------------------------------------------------*/
+/* vartable.c                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#include "vartable.h"
+#include "hashtable.h"
+#include "ish.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+enum {FALSE, TRUE};
+
+/*--------------------------------------------------------------------*/
+
+/* The number of overlaid environment arrays that a VarTable keeps
+   for reuse. */
+
+enum {OVERLAY_COUNT = 8};
+
+/*--------------------------------------------------------------------*/
+
+/* A Variable is one environment variable. */
+
+struct Variable
+{
+   /* The link that chains the Variable into its bucket. */
+   struct HashLink sLink;
+
+   /* The variable as "name=value", as environ holds it, and the
+      length of its name. */
+   char *pcString;
+   size_t uNameLength;
+
+   /* The Variables set before and after this one. */
+   struct Variable *psPrev;
+   struct Variable *psLater;
+
+   /* The index of the variable in the environment array. */
+   size_t uIndex;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* An Overlay is an environment array built from that of a VarTable
+   with some "name=value" assignments put over it. */
+
+struct Overlay
+{
+   /* The assignments, each followed by a null character, and the
+      length of all of them. The array points into them. */
+   char *pcAssigns;
+   size_t uAssignsLength;
+
+   /* The environment array. */
+   char **ppcEnvp;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A VarTable is a hash table of Variables, which are also linked in
+   the order they were set, and the environment array built from
+   them. */
+
+struct VarTable
+{
+   /* The Variables, by name. */
+   HashTable_T oVariables;
+
+   /* The Variables set first and last. */
+   struct Variable *psFirst;
+   struct Variable *psLast;
+
+   /* The environment array, the number of strings it has room for,
+      and whether it must be built again. */
+   char **ppcEnvp;
+   size_t uEnvpLength;
+   int iChanged;
+
+   /* The environment arrays built with assignments over ppcEnvp, and
+      the index of the one to replace next. */
+   struct Overlay asOverlays[OVERLAY_COUNT];
+   size_t uNextOverlay;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pointer to the link in oVarTable that points to the
+   Variable whose name is the uNameLength characters at pcName, or to
+   the NULL link at the end of its bucket if there is none. uHash is
+   the hash code of the name. */
+
+static struct HashLink **VarTable_find(VarTable_T oVarTable,
+   const char *pcName, size_t uNameLength, size_t uHash)
+{
+   struct HashLink **ppsLink;
+   struct Variable *psVariable;
+
+   for (ppsLink = HashTable_getBucket(oVarTable->oVariables, uHash);
+        *ppsLink != NULL; ppsLink = &(*ppsLink)->psNext)
+   {
+      psVariable = (struct Variable*)*ppsLink;
+      if ((psVariable->sLink.uHash == uHash) &&
+          (psVariable->uNameLength == uNameLength) &&
+          (memcmp(psVariable->pcString, pcName, uNameLength) == 0))
+         break;
+   }
+   return ppsLink;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the Variable in oVarTable whose name is the uNameLength
+   characters at pcName, or NULL if there is none. */
+
+static struct Variable *VarTable_lookup(VarTable_T oVarTable,
+   const char *pcName, size_t uNameLength)
+{
+   return (struct Variable*)*VarTable_find(oVarTable, pcName,
+      uNameLength, HashTable_hashChars(pcName, uNameLength));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the environment arrays that oVarTable built with assignments
+   over its own, which no longer match it. */
+
+static void VarTable_clearOverlays(VarTable_T oVarTable)
+{
+   size_t u;
+
+   for (u = 0; u < OVERLAY_COUNT; u++)
+   {
+      free(oVarTable->asOverlays[u].pcAssigns);
+      free(oVarTable->asOverlays[u].ppcEnvp);
+      oVarTable->asOverlays[u].pcAssigns = NULL;
+      oVarTable->asOverlays[u].uAssignsLength = 0;
+      oVarTable->asOverlays[u].ppcEnvp = NULL;
+   }
+   oVarTable->uNextOverlay = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set the variable whose name is the uNameLength characters at
+   pcName in oVarTable to pcValue. Return TRUE if successful, or
+   FALSE if insufficient memory is available. */
+
+static int VarTable_put(VarTable_T oVarTable, const char *pcName,
+   size_t uNameLength, const char *pcValue)
+{
+   struct HashLink **ppsLink;
+   struct Variable *psVariable;
+   char *pcString;
+   size_t uValueLength;
+   size_t uHash;
+
+   uValueLength = strlen(pcValue);
+   pcString = (char*)malloc(uNameLength + uValueLength + 2);
+   if (pcString == NULL)
+      return FALSE;
+   memcpy(pcString, pcName, uNameLength);
+   pcString[uNameLength] = '=';
+   memcpy(pcString + uNameLength + 1, pcValue, uValueLength + 1);
+
+   /* A variable set again keeps its place. */
+   uHash = HashTable_hashChars(pcName, uNameLength);
+   ppsLink = VarTable_find(oVarTable, pcName, uNameLength, uHash);
+   if (*ppsLink != NULL)
+   {
+      psVariable = (struct Variable*)*ppsLink;
+      free(psVariable->pcString);
+      psVariable->pcString = pcString;
+      oVarTable->iChanged = TRUE;
+      return TRUE;
+   }
+
+   psVariable = (struct Variable*)malloc(sizeof(struct Variable));
+   if (psVariable == NULL)
+   {
+      free(pcString);
+      return FALSE;
+   }
+   psVariable->pcString = pcString;
+   psVariable->uNameLength = uNameLength;
+   HashTable_add(oVarTable->oVariables, &psVariable->sLink, uHash);
+
+   psVariable->psPrev = oVarTable->psLast;
+   psVariable->psLater = NULL;
+   if (oVarTable->psLast == NULL)
+      oVarTable->psFirst = psVariable;
+   else
+      oVarTable->psLast->psLater = psVariable;
+   oVarTable->psLast = psVariable;
+
+   oVarTable->iChanged = TRUE;
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new VarTable object that holds a copy of each
+   "name=value" string in ppcEnv, a NULL-terminated array in the form
+   of environ, or NULL if insufficient memory is available. A string
+   without '=' is skipped, and a later string for the same name
+   replaces an earlier one. */
+
+VarTable_T VarTable_new(char **ppcEnv)
+{
+   VarTable_T oVarTable;
+   const char *pcEquals;
+
+   assert(ppcEnv != NULL);
+
+   oVarTable = (struct VarTable*)calloc(1, sizeof(struct VarTable));
+   if (oVarTable == NULL)
+      return NULL;
+   oVarTable->oVariables = HashTable_new();
+   if (oVarTable->oVariables == NULL)
+   {
+      free(oVarTable);
+      return NULL;
+   }
+   oVarTable->iChanged = TRUE;
+
+   for (; *ppcEnv != NULL; ppcEnv++)
+   {
+      pcEquals = strchr(*ppcEnv, '=');
+      if ((pcEquals == NULL) || (pcEquals == *ppcEnv))
+         continue;
+      if (! VarTable_put(oVarTable, *ppcEnv,
+         (size_t)(pcEquals - *ppcEnv), pcEquals + 1))
+      {
+         VarTable_free(oVarTable);
+         return NULL;
+      }
+   }
+   return oVarTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oVarTable, and the environment array that it built. */
+
+void VarTable_free(VarTable_T oVarTable)
+{
+   struct Variable *psVariable;
+   struct Variable *psLater;
+
+   if (oVarTable == NULL)
+      return;
+
+   for (psVariable = oVarTable->psFirst; psVariable != NULL;
+        psVariable = psLater)
+   {
+      psLater = psVariable->psLater;
+      free(psVariable->pcString);
+      free(psVariable);
+   }
+   VarTable_clearOverlays(oVarTable);
+   HashTable_free(oVarTable->oVariables);
+   free(oVarTable->ppcEnvp);
+   free(oVarTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value of the variable in oVarTable whose name is the
+   uNameLength characters at pcName, which need not be terminated by
+   a null character, or NULL if there is none. The value lasts until
+   the variable changes. */
+
+const char *VarTable_get(VarTable_T oVarTable, const char *pcName,
+   size_t uNameLength)
+{
+   struct Variable *psVariable;
+
+   assert(oVarTable != NULL);
+   assert(pcName != NULL);
+
+   psVariable = VarTable_lookup(oVarTable, pcName, uNameLength);
+   if (psVariable == NULL)
+      return NULL;
+   return psVariable->pcString + uNameLength + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set the variable pcName in oVarTable to pcValue, keeping copies of
+   both. pcName must be non-empty and contain no '='. Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+int VarTable_set(VarTable_T oVarTable, const char *pcName,
+   const char *pcValue)
+{
+   assert(oVarTable != NULL);
+   assert(pcName != NULL);
+   assert(pcValue != NULL);
+   assert((*pcName != '\0') && (strchr(pcName, '=') == NULL));
+
+   return VarTable_put(oVarTable, pcName, strlen(pcName), pcValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the variable pcName from oVarTable, if it is there. */
+
+void VarTable_unset(VarTable_T oVarTable, const char *pcName)
+{
+   struct HashLink **ppsLink;
+   struct Variable *psVariable;
+   size_t uNameLength;
+
+   assert(oVarTable != NULL);
+   assert(pcName != NULL);
+
+   uNameLength = strlen(pcName);
+   ppsLink = VarTable_find(oVarTable, pcName, uNameLength,
+      HashTable_hashChars(pcName, uNameLength));
+   psVariable = (struct Variable*)*ppsLink;
+   if (psVariable == NULL)
+      return;
+   HashTable_remove(oVarTable->oVariables, ppsLink);
+
+   if (psVariable->psPrev == NULL)
+      oVarTable->psFirst = psVariable->psLater;
+   else
+      psVariable->psPrev->psLater = psVariable->psLater;
+   if (psVariable->psLater == NULL)
+      oVarTable->psLast = psVariable->psPrev;
+   else
+      psVariable->psLater->psPrev = psVariable->psPrev;
+
+   free(psVariable->pcString);
+   free(psVariable);
+   oVarTable->iChanged = TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a NULL-terminated array of the "name=value" strings of the
+   variables in oVarTable, in the form of environ. The array is built
+   again only if a variable has changed since the last call; it and
+   its strings last until the next change. */
+
+char **VarTable_getEnvp(VarTable_T oVarTable)
+{
+   struct Variable *psVariable;
+   size_t uLength;
+   size_t u = 0;
+
+   assert(oVarTable != NULL);
+
+   if (! oVarTable->iChanged)
+      return oVarTable->ppcEnvp;
+
+   uLength = HashTable_getLength(oVarTable->oVariables);
+   if (uLength + 1 > oVarTable->uEnvpLength)
+   {
+      free(oVarTable->ppcEnvp);
+      oVarTable->uEnvpLength = 2 * (uLength + 1);
+      oVarTable->ppcEnvp = (char**)
+         malloc(sizeof(char*) * oVarTable->uEnvpLength);
+      if (oVarTable->ppcEnvp == NULL)
+         {perror(pcPgmName); exit(EXIT_FAILURE);}
+   }
+   for (psVariable = oVarTable->psFirst; psVariable != NULL;
+        psVariable = psVariable->psLater)
+   {
+      psVariable->uIndex = u;
+      oVarTable->ppcEnvp[u++] = psVariable->pcString;
+   }
+   oVarTable->ppcEnvp[u] = NULL;
+
+   VarTable_clearOverlays(oVarTable);
+   oVarTable->iChanged = FALSE;
+   return oVarTable->ppcEnvp;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a NULL-terminated array in the form of environ that holds
+   the variables of oVarTable with the uCount "name=value" strings of
+   ppcAssigns put over them, a later one over an earlier one for the
+   same name, without changing oVarTable. The array shares the
+   strings of the variables that it keeps; it is built only the
+   first time these assignments are given, and given again while
+   oVarTable is unchanged. It lasts until oVarTable changes, or until
+   a few other sets of assignments have been given. */
+
+char **VarTable_getOverlay(VarTable_T oVarTable, char **ppcAssigns,
+   size_t uCount)
+{
+   struct Overlay *psOverlay;
+   struct Variable *psVariable;
+   char **ppcEnvp;
+   char *pcAssign;
+   size_t uAssignsLength = 0;
+   size_t uVarCount;
+   size_t uLength;
+   size_t uNameLength;
+   size_t u;
+   size_t v;
+
+   assert(oVarTable != NULL);
+   assert(ppcAssigns != NULL);
+
+   /* Make sure the indices of the variables are current. */
+   if (uCount == 0)
+      return VarTable_getEnvp(oVarTable);
+   (void)VarTable_getEnvp(oVarTable);
+   uVarCount = HashTable_getLength(oVarTable->oVariables);
+
+   /* Reuse an array built for the same assignments. */
+   for (u = 0; u < uCount; u++)
+      uAssignsLength += strlen(ppcAssigns[u]) + 1;
+   for (u = 0; u < OVERLAY_COUNT; u++)
+   {
+      psOverlay = &oVarTable->asOverlays[u];
+      if (psOverlay->uAssignsLength != uAssignsLength)
+         continue;
+      pcAssign = psOverlay->pcAssigns;
+      for (v = 0; v < uCount; v++)
+      {
+         if (strcmp(pcAssign, ppcAssigns[v]) != 0)
+            break;
+         pcAssign += strlen(pcAssign) + 1;
+      }
+      if (v == uCount)
+         return psOverlay->ppcEnvp;
+   }
+
+   /* Otherwise replace the oldest one. */
+   psOverlay = &oVarTable->asOverlays[oVarTable->uNextOverlay];
+   oVarTable->uNextOverlay =
+      (oVarTable->uNextOverlay + 1) % OVERLAY_COUNT;
+   free(psOverlay->pcAssigns);
+   free(psOverlay->ppcEnvp);
+   psOverlay->pcAssigns = (char*)malloc(uAssignsLength);
+   ppcEnvp = (char**)
+      malloc(sizeof(char*) * (uVarCount + uCount + 1));
+   if ((psOverlay->pcAssigns == NULL) || (ppcEnvp == NULL))
+      {perror(pcPgmName); exit(EXIT_FAILURE);}
+   psOverlay->uAssignsLength = uAssignsLength;
+   psOverlay->ppcEnvp = ppcEnvp;
+
+   /* Copy the pointers of the variables, and then put each
+      assignment in place of the variable it names, or after them. */
+   memcpy(ppcEnvp, oVarTable->ppcEnvp, sizeof(char*) * uVarCount);
+   uLength = uVarCount;
+   pcAssign = psOverlay->pcAssigns;
+   for (u = 0; u < uCount; u++)
+   {
+      strcpy(pcAssign, ppcAssigns[u]);
+      uNameLength = (size_t)(strchr(pcAssign, '=') - pcAssign);
+      psVariable = VarTable_lookup(oVarTable, pcAssign, uNameLength);
+      if (psVariable != NULL)
+         ppcEnvp[psVariable->uIndex] = pcAssign;
+      else
+      {
+         for (v = uVarCount; v < uLength; v++)
+            if (strncmp(ppcEnvp[v], pcAssign, uNameLength + 1) == 0)
+               break;
+         ppcEnvp[v] = pcAssign;
+         if (v == uLength)
+            uLength++;
+      }
+      pcAssign += strlen(pcAssign) + 1;
+   }
+   ppcEnvp[uLength] = NULL;
+   return ppcEnvp;
+}
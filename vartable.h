@@ -0,0 +1,87 @@
+/*--------------------------------------------------------------------*/
+/* vartable.h                                                         */
+/* Author: Isaac Wolfe                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef VARTABLE_INCLUDED
+#define VARTABLE_INCLUDED
+
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A VarTable object holds the environment variables of the shell,
+   indexed by name in a hash table, so that a variable is found
+   without scanning the environment. It keeps them in the order in
+   which they were first set, and builds from them an environment
+   array in the form of environ, again only after they change, and
+   arrays with a few variables changed for one command alone. */
+
+typedef struct VarTable *VarTable_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new VarTable object that holds a copy of each
+   "name=value" string in ppcEnv, a NULL-terminated array in the form
+   of environ, or NULL if insufficient memory is available. A string
+   without '=' is skipped, and a later string for the same name
+   replaces an earlier one. */
+
+VarTable_T VarTable_new(char **ppcEnv);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oVarTable, and the environment array that it built. */
+
+void VarTable_free(VarTable_T oVarTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value of the variable in oVarTable whose name is the
+   uNameLength characters at pcName, which need not be terminated by
+   a null character, or NULL if there is none. The value lasts until
+   the variable changes. */
+
+const char *VarTable_get(VarTable_T oVarTable, const char *pcName,
+   size_t uNameLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Set the variable pcName in oVarTable to pcValue, keeping copies of
+   both. pcName must be non-empty and contain no '='. Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+int VarTable_set(VarTable_T oVarTable, const char *pcName,
+   const char *pcValue);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the variable pcName from oVarTable, if it is there. */
+
+void VarTable_unset(VarTable_T oVarTable, const char *pcName);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a NULL-terminated array of the "name=value" strings of the
+   variables in oVarTable, in the form of environ. The array is built
+   again only if a variable has changed since the last call; it and
+   its strings last until the next change. */
+
+char **VarTable_getEnvp(VarTable_T oVarTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a NULL-terminated array in the form of environ that holds
+   the variables of oVarTable with the uCount "name=value" strings of
+   ppcAssigns put over them, a later one over an earlier one for the
+   same name, without changing oVarTable. The array shares the
+   strings of the variables that it keeps; it is built only the
+   first time these assignments are given, and given again while
+   oVarTable is unchanged. It lasts until oVarTable changes, or until
+   a few other sets of assignments have been given. */
+
+char **VarTable_getOverlay(VarTable_T oVarTable, char **ppcAssigns,
+   size_t uCount);
+
+#endif